@@ -5,8 +5,10 @@
 
 #ifdef DOCTEST_CONFIG_DISABLE
 
+#include <algorithm>
 #include <filesystem>
 #include <format>
+#include <fstream>
 
 #include <string>
 
@@ -14,6 +16,8 @@
 #include <replxx.hxx>
 
 #include <ranges>
+#include <sstream>
+#include <vector>
 
 import anka;
 import utility;
@@ -22,10 +26,15 @@ const auto constexpr MAJOR_VERSION = "0";
 const auto constexpr MINOR_VERSION = "3";
 const auto constexpr PATCH_VERSION = "0";
 
-auto execute(anka::Context &context, const std::string_view content) -> bool
+// Runs func and reports the errors it throws, token positions of parse errors are shifted by offset.
+template <typename Func> auto reportErrors(anka::Context &context, size_t offset, Func func) -> bool
 {
-  try
-  {
+  return anka::reportErrors(context, offset, std::cerr, func);
+}
+
+auto executeContent(anka::Context &context, const std::string_view content) -> bool
+{
+  return reportErrors(context, 0, [&]() {
     auto tokens = anka::extractTokens(content);
     auto sentences = anka::parse(content, tokens, context);
     auto wordOpt = anka::execute(context, sentences);
@@ -34,37 +43,183 @@ auto execute(anka::Context &context, const std::string_view content) -> bool
     {
       std::cout << std::format("{}\n", toString(context, wordOpt.value()));
     }
+  });
+}
 
-    return false;
-  }
-  catch (const anka::TokenizerError &err)
+auto execute(anka::Context &context, const std::string_view content) -> bool
+{
+  // only the user defined names survive the execution of the content, the rest is released
+  const auto mark = anka::markContext(context);
+  const auto result = executeContent(context, content);
+  anka::releaseTemporaries(context, mark);
+  return result;
+}
+
+constexpr size_t fileChunkSize = 1 << 16;
+constexpr int defaultStreamChunkSize = 1 << 20;
+
+// Reads the file in chunks and executes the complete lines of every chunk, so the memory use does not depend on
+// the size of the file. Only the value of the last sentence is printed.
+auto executeFile(anka::Context &context, const std::string &filename) -> bool
+{
+  std::ifstream file(filename, std::ios::binary);
+  anka::Tokenizer tokenizer;
+  std::vector<char> chunk(fileChunkSize);
+
+  // the value of the last sentence is kept with the user defined names, the rest is released after every chunk
+  const auto mark = anka::markContext(context);
+  std::vector<anka::Word> lastValue;
+
+  auto executeLines = [&]() -> bool {
+    while (auto linesOpt = tokenizer.takeLines())
+    {
+      auto &lines = linesOpt.value();
+      auto success = reportErrors(context, lines.offset, [&]() {
+        auto sentences = anka::parse(lines.text, lines.tokens, context);
+        if (auto wordOpt = anka::execute(context, sentences))
+          lastValue.assign(1, wordOpt.value());
+      });
+      anka::releaseTemporaries(context, mark, lastValue);
+      if (!success)
+        return false;
+    }
+    return true;
+  };
+
+  while (file)
   {
-    std::cerr << std::format("Token error at {} character: {}.\n", err.pos, err.ch);
+    file.read(chunk.data(), chunk.size());
+    const auto count = static_cast<size_t>(file.gcount());
+    if (!reportErrors(context, 0, [&]() { tokenizer.feed({chunk.data(), count}); }) || !executeLines())
+      return false;
+  }
+  tokenizer.finish();
+  if (!executeLines())
     return false;
+
+  if (!lastValue.empty())
+  {
+    std::cout << std::format("{}\n", toString(context, lastValue.front()));
   }
-  catch (const anka::ParseError &err)
+  return true;
+}
+
+// Runs the last sentence of the file over the chunks of the array file, bound to name.
+auto executeStream(anka::Context &context, const std::string &filename, const std::string &name,
+                   const std::string &path, size_t chunkSize, const std::optional<std::string> &outputOpt) -> bool
+{
+  std::ofstream outputFile;
+  if (outputOpt)
   {
-    std::cerr << std::format("AST error: {}.\n", err.message);
-    if (err.tokenOpt.has_value())
+    outputFile.open(outputOpt.value());
+    if (!outputFile)
     {
-      auto t = err.tokenOpt.value();
-      std::cerr << std::format("Token start: {}, length: {}.\n", t.start, t.len);
+      std::cerr << std::format("Could not create the output file: {}\n", outputOpt.value());
+      return false;
     }
-    return false;
   }
-  catch (const anka::ExecutionError &err)
-  {
-    std::cerr << err.msg << "\n";
-    if (err.word1.has_value())
+  auto &output = outputOpt ? static_cast<std::ostream &>(outputFile) : std::cout;
+
+  return reportErrors(context, 0, [&]() {
+    const auto content = anka::utility::readFile(filename.c_str());
+    auto tokens = anka::extractTokens(content);
+    auto sentences = anka::parse(content, tokens, context);
+
+    anka::StreamExecution stream(context, sentences, name);
+    anka::ArrayFileReader reader(path, chunkSize);
+    while (auto chunkOpt = reader.readChunk(context))
     {
-      std::cerr << std::format("word: {}\n", toString(context, err.word1.value()));
+      stream.executeChunk(chunkOpt.value(), output);
     }
-    if (err.word2.has_value())
+
+    if (auto resultOpt = stream.getResult())
+    {
+      output << std::format("{}\n", toString(context, resultOpt.value()));
+    }
+  });
+}
+
+// Loads an array file into a user defined name.
+auto loadArrayFile(anka::Context &context, const std::string &name, const std::string &path) -> bool
+{
+  return reportErrors(context, 0, [&]() {
+    const auto nameId = anka::internName(context, name);
+    if (anka::isInternalFunction(nameId))
+      throw anka::ExecutionError{std::nullopt, std::nullopt, std::format("{} is an internal function", name)};
+
+    anka::setUserDefinedName(context, nameId, anka::loadArray(context, path));
+  });
+}
+
+// Saves the array of a user defined name to a file.
+auto saveArrayFile(anka::Context &context, const std::string &name, const std::string &path) -> bool
+{
+  return reportErrors(context, 0, [&]() {
+    const auto wordOpt = anka::findUserDefinedName(context, name);
+    if (!wordOpt)
+      throw anka::ExecutionError{std::nullopt, std::nullopt, std::format("Unknown name: {}", name)};
+
+    anka::saveArray(context, wordOpt.value(), path);
+  });
+}
+
+// Applies func to the name and path of every "name=path" argument.
+template <typename Func> auto forEachArrayFile(const std::vector<std::string> &arguments, Func func) -> bool
+{
+  for (const auto &argument : arguments)
+  {
+    const auto separator = argument.find('=');
+    if (separator == std::string::npos)
     {
-      std::cerr << std::format("word: {}\n", toString(context, err.word2.value()));
+      std::cerr << std::format("Expected name=file, found: {}\n", argument);
+      return false;
     }
+    if (!func(argument.substr(0, separator), argument.substr(separator + 1)))
+      return false;
+  }
+  return true;
+}
+
+auto writeTrace(const std::string &path) -> bool
+{
+  std::ofstream file(path);
+  if (!file)
+  {
+    std::cerr << std::format("Could not create the trace file: {}\n", path);
+    return false;
+  }
+  file << anka::getChromeTrace();
+  return true;
+}
+
+// Stops profiling, then prints the report and writes the trace that were asked for.
+auto finishProfiling(bool profile, const std::optional<std::string> &traceOpt) -> bool
+{
+  anka::stopProfiling();
+  if (profile)
+    std::cerr << anka::getProfileReport();
+  return !traceOpt || writeTrace(traceOpt.value());
+}
+
+// Runs the scripts of a directory or a list file concurrently and prints their results in order.
+auto executeBatch(const std::string &path, size_t memoCapacity) -> bool
+{
+  std::vector<std::string> scripts;
+  anka::Context context;
+  if (!reportErrors(context, 0, [&]() { scripts = anka::getBatchScripts(path); }))
     return false;
+
+  size_t failures = 0;
+  for (const auto &result : anka::runBatch(scripts, memoCapacity))
+  {
+    std::cout << std::format("anka: {}\n", result.path) << result.output;
+    std::cerr << result.errors;
+    failures += result.success ? 0 : 1;
   }
+
+  if (failures > 0)
+    std::cerr << std::format("anka: {} of {} scripts failed.\n", failures, scripts.size());
+  return failures == 0;
 }
 
 auto executeRepl(anka::Context &context) -> void
@@ -78,6 +233,10 @@ auto executeRepl(anka::Context &context) -> void
   std::cout << ".clear: Clear context.\n";
   std::cout << ".internal: List internal commands and constants.\n";
   std::cout << ".history: List command history.\n";
+  std::cout << ".load name file: Load an array file into a name.\n";
+  std::cout << ".save name file: Save the array of a name to a file.\n";
+  std::cout << ".profile: Start profiling, the next .profile prints the time spent per phase and function.\n";
+  std::cout << ".memory: List the values and bytes in the pools of the context.\n";
 
   std::string prompt = "\x1b[1;32manka\x1b[0m> ";
 
@@ -114,7 +273,9 @@ auto executeRepl(anka::Context &context) -> void
     }
     else if (input == ".clear")
     {
+      const auto memoCapacity = context.memo.capacity;
       context = anka::Context{};
+      anka::setMemoCapacity(context, memoCapacity);
       rx.history_add(input);
     }
     else if (input.compare(0, 8, ".history") == 0)
@@ -128,6 +289,37 @@ auto executeRepl(anka::Context &context) -> void
 
       rx.history_add(input);
     }
+    else if (input.compare(0, 5, ".load") == 0 || input.compare(0, 5, ".save") == 0)
+    {
+      std::istringstream arguments(input.substr(5));
+      std::string name;
+      std::string path;
+      if (!(arguments >> name >> path))
+        std::cerr << std::format("Expected: {} name file\n", input.substr(0, 5));
+      else if (input[1] == 'l')
+        loadArrayFile(context, name, path);
+      else
+        saveArrayFile(context, name, path);
+      rx.history_add(input);
+    }
+    else if (input == ".profile")
+    {
+      if (anka::isProfiling())
+      {
+        anka::stopProfiling();
+        std::cout << anka::getProfileReport();
+      }
+      else
+      {
+        anka::startProfiling(false);
+      }
+      rx.history_add(input);
+    }
+    else if (input == ".memory")
+    {
+      std::cout << anka::getMemoryReport(context);
+      rx.history_add(input);
+    }
     else if (input.compare(0, 9, ".internal") == 0)
     {
       auto definitions = anka::getAllInternalFunctionDefinitions();
@@ -160,6 +352,18 @@ int main(int argc, char *argv[])
 
   std::optional<std::string> filenameOpt;
   auto runRepl = false;
+  std::optional<int> threadCountOpt;
+  std::optional<int> memoizeOpt;
+  std::vector<std::string> loadArguments;
+  std::vector<std::string> saveArguments;
+  std::optional<std::string> streamOpt;
+  std::optional<int> chunkSizeOpt;
+  std::optional<std::string> outputOpt;
+  auto profile = false;
+  std::optional<std::string> saveImageOpt;
+  std::optional<std::string> loadImageOpt;
+  std::optional<std::string> traceOpt;
+  std::optional<std::string> batchOpt;
 
   auto parser = argument_parser{};
   auto params = parser.params();
@@ -167,20 +371,92 @@ int main(int argc, char *argv[])
   parser.add_default_help_option();
   params.add_parameter(filenameOpt, "--filename", "-f").nargs(1).help("File name to process");
   params.add_parameter(runRepl, "--repl", "-r").nargs(0).help("Run REPL");
+  params.add_parameter(threadCountOpt, "--threads", "-t")
+      .nargs(1)
+      .help("Number of threads used for large arrays, defaults to the number of cores");
+  params.add_parameter(memoizeOpt, "--memoize")
+      .nargs(1)
+      .help("Number of results of pure blocks and executors that are kept and reused when they are applied to the "
+            "same argument again, off by default");
+  params.add_parameter(loadArguments, "--load")
+      .minargs(1)
+      .help("Array files to load before processing, given as name=file.npy");
+  params.add_parameter(saveArguments, "--save")
+      .minargs(1)
+      .help("Arrays to save after processing, given as name=file.npy");
+  params.add_parameter(streamOpt, "--stream")
+      .nargs(1)
+      .help("Run the last sentence of the file over the chunks of an array file, given as name=file. The file is "
+            "an .npy file or numbers separated by white space");
+  params.add_parameter(chunkSizeOpt, "--chunk-size")
+      .nargs(1)
+      .help("Number of elements in a streamed chunk, defaults to 1048576");
+  params.add_parameter(outputOpt, "--output", "-o")
+      .nargs(1)
+      .help("File the results of streaming are written to, defaults to the standard output");
+  params.add_parameter(loadImageOpt, "--load-image")
+      .nargs(1)
+      .help("Start from a context image saved with --save-image instead of an empty context");
+  params.add_parameter(saveImageOpt, "--save-image")
+      .nargs(1)
+      .help("Save the names and values of the context to an image after processing");
+  params.add_parameter(batchOpt, "--batch")
+      .nargs(1)
+      .help("Run the .anka scripts of a directory, or the scripts listed one per line in a file, concurrently. Every "
+            "script gets a context of its own, the value of its last sentence is printed after its name");
+  params.add_parameter(profile, "--profile")
+      .nargs(0)
+      .help("Print the time spent per phase and function and the values created per pool after processing");
+  params.add_parameter(traceOpt, "--trace")
+      .nargs(1)
+      .help("Profile and write the trace of the calls to a file in the Chrome trace format");
 
   if (!parser.parse_args(argc, argv))
     return -1;
 
+  if (threadCountOpt)
+    anka::setThreadCount(std::max(1, threadCountOpt.value()));
+
   anka::Context context;
-  anka::injectInternalConstants(context);
+  if (loadImageOpt)
+  {
+    if (!reportErrors(context, 0, [&]() { context = anka::loadContextImage(loadImageOpt.value()); }))
+      return -1;
+  }
+  else
+  {
+    anka::injectInternalConstants(context);
+  }
+  if (memoizeOpt)
+    anka::setMemoCapacity(context, static_cast<size_t>(std::max(0, memoizeOpt.value())));
+  if (profile || traceOpt)
+    anka::startProfiling(traceOpt.has_value());
 
   std::cout << appDesc << "\n";
 
+  if (streamOpt && !filenameOpt)
+  {
+    std::cerr << "Streaming needs a file with the sentence to run, given with '-f'.\n";
+    return -1;
+  }
+
+  if (batchOpt)
+  {
+    const auto success = executeBatch(batchOpt.value(), static_cast<size_t>(std::max(0, memoizeOpt.value_or(0))));
+    if ((profile || traceOpt) && !finishProfiling(profile, traceOpt))
+      return -1;
+    return success ? 0 : -1;
+  }
+
   if (!filenameOpt && !runRepl)
   {
     std::cerr << "No argument given, use '-h' to see the vailable options.\n";
   }
 
+  auto loadFile = [&](const std::string &name, const std::string &path) { return loadArrayFile(context, name, path); };
+  if (!forEachArrayFile(loadArguments, loadFile))
+    return -1;
+
   if (filenameOpt)
   {
     const auto filename = filenameOpt.value();
@@ -190,14 +466,38 @@ int main(int argc, char *argv[])
       throw std::runtime_error("File does not exist.");
     }
 
-    auto content = anka::utility::readFile(filename.c_str());
+    if (streamOpt)
+    {
+      const auto separator = streamOpt->find('=');
+      if (separator == std::string::npos)
+      {
+        std::cerr << std::format("Expected name=file, found: {}\n", streamOpt.value());
+        return -1;
+      }
 
-    if (!execute(context, content))
+      const auto chunkSize = static_cast<size_t>(std::max(1, chunkSizeOpt.value_or(defaultStreamChunkSize)));
+      if (!executeStream(context, filename, streamOpt->substr(0, separator), streamOpt->substr(separator + 1),
+                         chunkSize, outputOpt))
+      {
+        return -1;
+      }
+    }
+    else if (!executeFile(context, filename))
     {
       return -1;
     }
   }
 
+  auto saveFile = [&](const std::string &name, const std::string &path) { return saveArrayFile(context, name, path); };
+  if (!forEachArrayFile(saveArguments, saveFile))
+    return -1;
+
+  if (saveImageOpt && !reportErrors(context, 0, [&]() { anka::saveContextImage(context, saveImageOpt.value()); }))
+    return -1;
+
+  if ((profile || traceOpt) && !finishProfiling(profile, traceOpt))
+    return -1;
+
   if (runRepl)
   {
     executeRepl(context);
@@ -3,10 +3,21 @@ module;
 #include <compare>
 export module anka;
 export import :internal_functions;
+export import :bit_array;
 export import :errors;
 export import :type_system;
 export import :interpreter_state;
 export import :state_utilities;
 export import :executor;
 export import :tokenizer;
-export import :parser;
\ No newline at end of file
+export import :parser;
+export import :thread_pool;
+export import :array_io;
+export import :stream;
+export import :sorting;
+export import :dictionary;
+export import :nested_array;
+export import :memoization;
+export import :profiler;
+export import :context_image;
+export import :batch;
\ No newline at end of file
@@ -0,0 +1,525 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+export module anka:array_io;
+
+import :interpreter_state;
+import :errors;
+import :bit_array;
+
+// Arrays are stored in the .npy format: a magic string, a version, the length of a text header that describes the
+// element type and the shape, and the raw elements.
+
+namespace anka
+{
+
+static_assert(std::endian::native == std::endian::little, "array files are read and written as little endian");
+
+constexpr auto npyMagic = std::string_view{"\x93NUMPY"};
+// header lengths are padded so the elements start at a multiple of this
+constexpr size_t npyAlignment = 64;
+
+[[noreturn]] auto throwArrayFileError(const std::filesystem::path &path, const std::string &message) -> void
+{
+  throw ExecutionError{std::nullopt, std::nullopt, std::format("{}: {}", path.string(), message)};
+}
+
+// Read only view of a whole file, the pages are only read when they are used.
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::filesystem::path &path)
+  {
+    try
+    {
+      map(path);
+    }
+    catch (...)
+    {
+      unmap();
+      throw;
+    }
+  }
+
+  ~MappedFile()
+  {
+    unmap();
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  auto bytes() const -> std::string_view
+  {
+    return {data, size};
+  }
+
+private:
+  auto map(const std::filesystem::path &path) -> void
+  {
+#ifdef _WIN32
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      throwArrayFileError(path, "could not open the file");
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+      throwArrayFileError(path, "could not read the file size");
+    size = static_cast<size_t>(fileSize.QuadPart);
+    if (size == 0)
+      return;
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+      throwArrayFileError(path, "could not map the file");
+    data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+      throwArrayFileError(path, "could not open the file");
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+      throwArrayFileError(path, "could not read the file size");
+    size = static_cast<size_t>(status.st_size);
+    if (size == 0)
+      return;
+
+    auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (address != MAP_FAILED)
+    {
+      madvise(address, size, MADV_SEQUENTIAL);
+      data = static_cast<const char *>(address);
+    }
+#endif
+    if (data == nullptr)
+      throwArrayFileError(path, "could not map the file");
+  }
+
+  auto unmap() -> void
+  {
+#ifdef _WIN32
+    if (data != nullptr)
+      UnmapViewOfFile(data);
+    if (mapping != nullptr)
+      CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+      CloseHandle(file);
+#else
+    if (data != nullptr)
+      munmap(const_cast<char *>(data), size);
+    if (descriptor >= 0)
+      close(descriptor);
+#endif
+  }
+
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE mapping = nullptr;
+#else
+  int descriptor = -1;
+#endif
+  const char *data = nullptr;
+  size_t size = 0;
+};
+
+struct ArrayFileHeader
+{
+  std::string descr;
+  size_t length = 0;
+  // position of the first element in the file
+  size_t dataOffset = 0;
+};
+
+// Text of the quoted value or the tuple that follows key in the header dictionary.
+auto findHeaderValue(std::string_view header, std::string_view key) -> std::string_view
+{
+  auto keyPos = header.find(std::format("'{}'", key));
+  if (keyPos == std::string_view::npos)
+    return {};
+
+  auto valueStart = header.find_first_of("'(", header.find(':', keyPos));
+  if (valueStart == std::string_view::npos)
+    return {};
+
+  const auto closing = header[valueStart] == '(' ? ')' : '\'';
+  auto valueEnd = header.find(closing, valueStart + 1);
+  if (valueEnd == std::string_view::npos)
+    return {};
+
+  return header.substr(valueStart + 1, valueEnd - valueStart - 1);
+}
+
+auto readLittleEndian(std::string_view bytes) -> size_t
+{
+  size_t value = 0;
+  for (auto i = bytes.size(); i > 0; --i)
+  {
+    value = (value << 8) | static_cast<unsigned char>(bytes[i - 1]);
+  }
+  return value;
+}
+
+auto readHeader(const std::filesystem::path &path, std::string_view bytes) -> ArrayFileHeader
+{
+  if (bytes.size() < 10 || !bytes.starts_with(npyMagic))
+    throwArrayFileError(path, "not an array file");
+
+  // version 1 has a 2 byte header length, later versions 4 bytes
+  const auto lengthSize = static_cast<unsigned char>(bytes[6]) == 1 ? size_t{2} : size_t{4};
+  const auto headerStart = npyMagic.size() + 2 + lengthSize;
+  if (bytes.size() < headerStart)
+    throwArrayFileError(path, "truncated header");
+
+  const auto headerLength = readLittleEndian(bytes.substr(npyMagic.size() + 2, lengthSize));
+  if (bytes.size() < headerStart + headerLength)
+    throwArrayFileError(path, "truncated header");
+
+  const auto header = bytes.substr(headerStart, headerLength);
+  const auto shape = findHeaderValue(header, "shape");
+  size_t length = 0;
+  auto [ptr, ec] = std::from_chars(shape.data(), shape.data() + shape.size(), length);
+  if (ec != std::errc{} || std::string_view(ptr, shape.data() + shape.size()).find_first_not_of(", ") !=
+                               std::string_view::npos)
+    throwArrayFileError(path, std::format("only one dimensional arrays are supported, found shape ({})", shape));
+
+  return {std::string(findHeaderValue(header, "descr")), length, headerStart + headerLength};
+}
+
+auto getElementSize(const std::string &descr) -> size_t
+{
+  if (descr == "<i4")
+    return sizeof(int);
+  if (descr == "<f8")
+    return sizeof(double);
+  if (descr == "|b1")
+    return 1;
+  if (descr == "<i8")
+    return sizeof(std::int64_t);
+  if (descr == "<f4")
+    return sizeof(float);
+  if (descr == "|i1")
+    return sizeof(std::int8_t);
+  if (descr == "<i2")
+    return sizeof(std::int16_t);
+  if (descr == "|u1")
+    return sizeof(std::uint8_t);
+  return 0;
+}
+
+template <typename T> auto readElements(std::string_view payload, size_t length) -> std::vector<T>
+{
+  std::vector<T> values(length);
+  if (length > 0)
+    std::memcpy(values.data(), payload.data(), length * sizeof(T));
+  return values;
+}
+
+auto readBooleans(std::string_view payload, size_t length) -> BitArray
+{
+  BitArray values(length);
+  auto blocks = values.blocks();
+  for (size_t i = 0; i < length; ++i)
+  {
+    blocks[i / BitArray::bitsPerBlock] |= BitArray::Block{payload[i] != 0} << (i % BitArray::bitsPerBlock);
+  }
+  return values;
+}
+
+// Creates the array of the element type descr from the elements in payload.
+auto createArrayWord(Context &context, const std::string &descr, std::string_view payload, size_t length) -> Word
+{
+  if (descr == "<i4")
+    return createWord(context, readElements<int>(payload, length));
+  if (descr == "<f8")
+    return createWord(context, readElements<double>(payload, length));
+  if (descr == "<i8")
+    return createWord(context, readElements<std::int64_t>(payload, length));
+  if (descr == "<f4")
+    return createWord(context, readElements<float>(payload, length));
+  if (descr == "|i1")
+    return createWord(context, readElements<std::int8_t>(payload, length));
+  if (descr == "<i2")
+    return createWord(context, readElements<std::int16_t>(payload, length));
+  if (descr == "|u1")
+    return createWord(context, readElements<std::uint8_t>(payload, length));
+  return createWord(context, readBooleans(payload, length));
+}
+
+// Loads a one dimensional array of int32 ('<i4'), float64 ('<f8') or bool ('|b1') elements, or of the storage
+// kinds int64 ('<i8'), float32 ('<f4'), int8 ('|i1'), int16 ('<i2') and uint8 ('|u1').
+export auto loadArray(Context &context, const std::filesystem::path &path) -> Word
+{
+  MappedFile file(path);
+  const auto bytes = file.bytes();
+  const auto header = readHeader(path, bytes);
+
+  const auto elementSize = getElementSize(header.descr);
+  if (elementSize == 0)
+    throwArrayFileError(path, std::format("element type '{}' is not supported", header.descr));
+
+  if ((bytes.size() - header.dataOffset) / elementSize < header.length)
+    throwArrayFileError(path, "the file is shorter than its header says");
+
+  return createArrayWord(context, header.descr, bytes.substr(header.dataOffset), header.length);
+}
+
+auto writeHeader(std::ofstream &file, std::string_view descr, size_t length) -> void
+{
+  auto header = std::format("{{'descr': '{}', 'fortran_order': False, 'shape': ({},), }}", descr, length);
+  const auto prefixSize = npyMagic.size() + 4;
+  const auto paddedSize = (prefixSize + header.size() + 1 + npyAlignment - 1) / npyAlignment * npyAlignment;
+  header.resize(paddedSize - prefixSize - 1, ' ');
+  header.push_back('\n');
+
+  const auto headerLength = static_cast<std::uint16_t>(header.size());
+  const char lengthBytes[] = {static_cast<char>(headerLength & 0xff), static_cast<char>(headerLength >> 8)};
+  file.write(npyMagic.data(), npyMagic.size());
+  file.write("\x01\x00", 2);
+  file.write(lengthBytes, 2);
+  file.write(header.data(), header.size());
+}
+
+template <typename T> auto writeElements(std::ofstream &file, const std::vector<T> &values) -> void
+{
+  file.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+auto writeBooleans(std::ofstream &file, const BitArray &values) -> void
+{
+  constexpr size_t bufferSize = 1 << 16;
+  std::vector<char> buffer;
+  buffer.reserve(std::min(bufferSize, values.size()));
+  for (auto value : values)
+  {
+    buffer.push_back(value ? 1 : 0);
+    if (buffer.size() == bufferSize)
+    {
+      file.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  }
+  file.write(buffer.data(), buffer.size());
+}
+
+// Saves an integer, double or boolean array or an array of a storage kind, the elements are written straight from
+// the array.
+export auto saveArray(const Context &context, const Word &word, const std::filesystem::path &path) -> void
+{
+  if (word.type != WordType::IntegerArray && word.type != WordType::IntegerRange &&
+      word.type != WordType::DoubleArray && word.type != WordType::BooleanArray && word.type != WordType::LongArray &&
+      !isStorageArray(word.type))
+  {
+    throw ExecutionError{word, std::nullopt, "Only integer, double or boolean arrays can be saved"};
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+    throwArrayFileError(path, "could not create the file");
+
+  switch (word.type)
+  {
+  case WordType::IntegerArray:
+    writeHeader(file, "<i4", context.integerArrays[word.index].size());
+    writeElements(file, context.integerArrays[word.index]);
+    break;
+  case WordType::IntegerRange: {
+    const auto &range = context.integerRanges[word.index];
+    writeHeader(file, "<i4", range.length);
+    writeElements(file, materialize(range));
+    break;
+  }
+  case WordType::DoubleArray:
+    writeHeader(file, "<f8", context.doubleArrays[word.index].size());
+    writeElements(file, context.doubleArrays[word.index]);
+    break;
+  case WordType::LongArray:
+    writeHeader(file, "<i8", context.longArrays[word.index].size());
+    writeElements(file, context.longArrays[word.index]);
+    break;
+  case WordType::FloatArray:
+    writeHeader(file, "<f4", context.floatArrays[word.index].size());
+    writeElements(file, context.floatArrays[word.index]);
+    break;
+  case WordType::Int8Array:
+    writeHeader(file, "|i1", context.int8Arrays[word.index].size());
+    writeElements(file, context.int8Arrays[word.index]);
+    break;
+  case WordType::Int16Array:
+    writeHeader(file, "<i2", context.int16Arrays[word.index].size());
+    writeElements(file, context.int16Arrays[word.index]);
+    break;
+  case WordType::UInt8Array:
+    writeHeader(file, "|u1", context.uint8Arrays[word.index].size());
+    writeElements(file, context.uint8Arrays[word.index]);
+    break;
+  default:
+    writeHeader(file, "|b1", context.booleanArrays[word.index].size());
+    writeBooleans(file, context.booleanArrays[word.index]);
+    break;
+  }
+
+  if (!file)
+    throwArrayFileError(path, "could not write the file");
+}
+
+// Reads an array file in chunks of at most chunkSize elements, so only one chunk is in memory at a time. Files that
+// start like .npy files are binary, other files hold numbers separated by white space. A text file gives double
+// chunks if its first chunk has a number with a '.' or an exponent, otherwise integer chunks.
+export class ArrayFileReader
+{
+public:
+  ArrayFileReader(const std::filesystem::path &path, size_t chunkSize)
+      : path(path), file(path, std::ios::binary), chunkSize(std::max<size_t>(1, chunkSize))
+  {
+    if (!file)
+      throwArrayFileError(path, "could not open the file");
+
+    std::string preamble(10, '\0');
+    file.read(preamble.data(), preamble.size());
+    preamble.resize(static_cast<size_t>(file.gcount()));
+    if (!preamble.starts_with(npyMagic))
+    {
+      text = std::move(preamble);
+      return;
+    }
+
+    // the header length can have 4 bytes
+    if (static_cast<unsigned char>(preamble[6]) != 1)
+    {
+      preamble.resize(12);
+      file.read(preamble.data() + 10, 2);
+    }
+    const auto headerStart = preamble.size();
+    const auto lengthSize = headerStart - npyMagic.size() - 2;
+    const auto headerLength = readLittleEndian(std::string_view(preamble).substr(npyMagic.size() + 2, lengthSize));
+    auto bytes = preamble + std::string(headerLength, ' ');
+    file.read(bytes.data() + headerStart, bytes.size() - headerStart);
+
+    const auto header = readHeader(path, bytes);
+    descr = header.descr;
+    remaining = header.length;
+    if (getElementSize(descr) == 0)
+      throwArrayFileError(path, std::format("element type '{}' is not supported", descr));
+  }
+
+  // Reads the next chunk into the context, none after the last one.
+  auto readChunk(Context &context) -> std::optional<Word>
+  {
+    if (!descr.empty())
+      return readBinaryChunk(context);
+
+    if (!isDoubleOpt)
+    {
+      fillText();
+      isDoubleOpt = text.find_first_of(".eE") != std::string::npos;
+    }
+
+    if (isDoubleOpt.value())
+      return readTextChunk<double>(context);
+    return readTextChunk<int>(context);
+  }
+
+private:
+  auto readBinaryChunk(Context &context) -> std::optional<Word>
+  {
+    if (remaining == 0)
+      return std::nullopt;
+
+    const auto length = std::min(remaining, chunkSize);
+    std::string payload(length * getElementSize(descr), '\0');
+    file.read(payload.data(), payload.size());
+    if (static_cast<size_t>(file.gcount()) != payload.size())
+      throwArrayFileError(path, "the file is shorter than its header says");
+    remaining -= length;
+
+    return createArrayWord(context, descr, payload, length);
+  }
+
+  // Appends the next block of the file to the unread text.
+  auto fillText() -> bool
+  {
+    constexpr size_t blockSize = 1 << 16;
+    text.erase(0, textPos);
+    textPos = 0;
+
+    const auto size = text.size();
+    text.resize(size + blockSize);
+    file.read(text.data() + size, blockSize);
+    text.resize(size + static_cast<size_t>(file.gcount()));
+    return text.size() > size;
+  }
+
+  template <typename T> auto readTextChunk(Context &context) -> std::optional<Word>
+  {
+    constexpr auto whiteSpace = std::string_view{" \t\r\n"};
+
+    std::vector<T> values;
+    while (values.size() < chunkSize)
+    {
+      auto start = text.find_first_not_of(whiteSpace, textPos);
+      auto end = start == std::string::npos ? std::string::npos : text.find_first_of(whiteSpace, start);
+      // a number at the end of the text can continue in the next block
+      if (end == std::string::npos)
+      {
+        if (fillText())
+          continue;
+
+        // the end of the file, the unread text moved to the front
+        start = text.find_first_not_of(whiteSpace, textPos);
+        if (start == std::string::npos)
+          break;
+        end = text.size();
+      }
+
+      T value = 0;
+      auto [ptr, ec] = std::from_chars(text.data() + start, text.data() + end, value);
+      if (ec != std::errc{} || ptr != text.data() + end)
+        throwArrayFileError(path, std::format("expected a number, found: {}", text.substr(start, end - start)));
+      values.push_back(value);
+      textPos = end;
+    }
+
+    if (values.empty())
+      return std::nullopt;
+    return createWord(context, std::move(values));
+  }
+
+  std::filesystem::path path;
+  std::ifstream file;
+  size_t chunkSize;
+
+  // element type and number of elements left of a binary file
+  std::string descr;
+  size_t remaining = 0;
+
+  // unread part of a text file starts at textPos
+  std::string text;
+  size_t textPos = 0;
+  std::optional<bool> isDoubleOpt;
+};
+
+} // namespace anka
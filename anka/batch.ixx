@@ -0,0 +1,129 @@
+module;
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+export module anka:batch;
+
+import :interpreter_state;
+import :state_utilities;
+import :internal_functions;
+import :errors;
+import :tokenizer;
+import :parser;
+import :executor;
+import :memoization;
+import :thread_pool;
+
+// A batch runs many independent scripts in one process. Every script gets a context of its own, so the scripts only
+// share the tables of the internal functions, which are built once and only read while the scripts run.
+
+namespace anka
+{
+
+export struct ScriptResult
+{
+  std::string path;
+  bool success = false;
+  // the value of the last sentence
+  std::string output;
+  std::string errors;
+};
+
+[[noreturn]] auto throwScriptError(const std::filesystem::path &path, const std::string &message) -> void
+{
+  throw ExecutionError{std::nullopt, std::nullopt, std::format("{}: {}", path.string(), message)};
+}
+
+auto readScript(const std::filesystem::path &path) -> std::string
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throwScriptError(path, "could not open the file");
+
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Executes the script in a new context, what it prints and the errors it throws are kept in the result.
+export auto executeScript(const std::string &path, size_t memoCapacity) -> ScriptResult
+{
+  ScriptResult res{path};
+  std::ostringstream output;
+  std::ostringstream errors;
+
+  Context context;
+  injectInternalConstants(context);
+  setMemoCapacity(context, memoCapacity);
+
+  res.success = reportErrors(context, 0, errors, [&]() {
+    // other exceptions would end the whole batch
+    try
+    {
+      const auto content = readScript(path);
+      auto tokens = extractTokens(content);
+      auto sentences = parse(content, tokens, context);
+      if (auto wordOpt = execute(context, sentences))
+        output << std::format("{}\n", toString(context, wordOpt.value()));
+    }
+    catch (const std::exception &err)
+    {
+      throwScriptError(path, err.what());
+    }
+  });
+
+  res.output = output.str();
+  res.errors = errors.str();
+  return res;
+}
+
+// The .anka files of a directory sorted by name, or the files listed one per line in a file.
+export auto getBatchScripts(const std::string &path) -> std::vector<std::string>
+{
+  std::vector<std::string> scripts;
+  if (std::filesystem::is_directory(path))
+  {
+    for (const auto &entry : std::filesystem::directory_iterator(path))
+    {
+      if (entry.is_regular_file() && entry.path().extension() == ".anka")
+        scripts.push_back(entry.path().string());
+    }
+    std::ranges::sort(scripts);
+    return scripts;
+  }
+
+  std::ifstream file(path);
+  if (!file)
+    throwScriptError(path, "could not open the list of scripts");
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (!line.empty())
+      scripts.push_back(line);
+  }
+  return scripts;
+}
+
+// Runs the scripts on the thread pool, the results are in the order of the paths. The scripts are claimed one at a
+// time, so a long script does not hold back the others, and the work inside a script stays on its thread.
+export auto runBatch(const std::vector<std::string> &paths, size_t memoCapacity) -> std::vector<ScriptResult>
+{
+  loadInternalFunctions();
+
+  std::vector<ScriptResult> results(paths.size());
+  const std::function<void(size_t)> job = [&](size_t i) { results[i] = executeScript(paths[i], memoCapacity); };
+  getThreadPool().run(paths.size(), job);
+  return results;
+}
+
+} // namespace anka
@@ -0,0 +1,303 @@
+#ifdef ANKA_BENCHMARKS
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <argumentum/argparse.h>
+
+import anka;
+
+// Every allocation goes through the global operator new, the counters include the ones of the worker threads.
+std::atomic<size_t> allocationCount{0};
+std::atomic<size_t> allocatedBytes{0};
+
+auto operator new(std::size_t size) -> void *
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  if (auto *pointer = std::malloc(size == 0 ? 1 : size))
+    return pointer;
+  throw std::bad_alloc{};
+}
+
+auto operator delete(void *pointer) noexcept -> void
+{
+  std::free(pointer);
+}
+
+auto operator delete(void *pointer, std::size_t) noexcept -> void
+{
+  std::free(pointer);
+}
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// One iteration of a benchmark, created by its setup so that the setup is not measured.
+using Iteration = std::function<void()>;
+
+struct Benchmark
+{
+  std::string name;
+  // elements, bytes or calls processed by one iteration
+  size_t items;
+  std::function<Iteration()> setup;
+};
+
+struct Measurement
+{
+  std::string name;
+  size_t iterations = 0;
+  // median of the repetitions
+  double nanoseconds = 0;
+  double itemsPerSecond = 0;
+  // per iteration over all repetitions
+  double allocations = 0;
+  double allocatedBytes = 0;
+};
+
+// the data of every run is the same
+constexpr unsigned seed = 42;
+constexpr size_t repetitionCount = 5;
+constexpr auto repetitionTime = std::chrono::milliseconds(50);
+constexpr std::array<size_t, 3> arraySizes{1 << 10, 1 << 16, 1 << 20};
+
+auto createRandomArray(size_t size) -> std::vector<int>
+{
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> distribution(-1000, 1000);
+  std::vector<int> res(size);
+  for (auto &value : res)
+    value = distribution(generator);
+  return res;
+}
+
+// Lines like the ones of the scripts we run, repeated to lineCount lines.
+auto createScript(size_t lineCount) -> std::string
+{
+  const auto lines = {
+      std::string_view{"avg: {div |{to_double sum} length|}\n"},
+      std::string_view{"sum filter[is_positive] mul[2] inc (1 2 3 4 5 6 7 8 9 10)\n"},
+      std::string_view{"|sum length top[3]| ((1000 2000 3000) (4000) (5000 6000))\n"},
+      std::string_view{"div[100.0] add[_1 _1] (1.5 2.5 3.5)\n"},
+  };
+
+  std::string script;
+  for (size_t i = 0; i < lineCount; ++i)
+    script += *(lines.begin() + i % lines.size());
+  return script;
+}
+
+// Executes the sentences with x bound to a random array of size elements. The values an iteration creates are
+// released after it, so every iteration starts from the same context.
+auto scriptBenchmark(const std::string &group, const std::string &content, size_t size, size_t items) -> Benchmark
+{
+  return Benchmark{std::format("{}/{}/{}", group, content, size), items, [content, size]() -> Iteration {
+                     auto context = std::make_shared<anka::Context>();
+                     anka::setUserDefinedName(*context, anka::internName(*context, "x"),
+                                              anka::createWord(*context, createRandomArray(size)));
+
+                     auto tokens = anka::extractTokens(content);
+                     auto sentences = anka::parse(content, tokens, *context);
+                     auto compiled =
+                         std::make_shared<std::vector<anka::CompiledWords>>(anka::compile(*context, sentences));
+                     return [context, compiled]() {
+                       const auto mark = anka::markContext(*context);
+                       anka::execute(*context, *compiled);
+                       anka::releaseTemporaries(*context, mark);
+                     };
+                   }};
+}
+
+auto arrayBenchmark(const std::string &group, const std::string &content, size_t size) -> Benchmark
+{
+  return scriptBenchmark(group, content, size, size);
+}
+
+// The same call repeated count times, the time goes to finding the overload and calling it.
+auto dispatchBenchmark(const std::string &name, const std::string &call, size_t count) -> Benchmark
+{
+  std::string content;
+  for (size_t i = 0; i < count; ++i)
+    content += call + " ";
+  content += "1";
+
+  auto benchmark = scriptBenchmark("dispatch", content, 0, count);
+  benchmark.name = std::format("dispatch/{}/{}", name, count);
+  return benchmark;
+}
+
+auto getBenchmarks() -> std::vector<Benchmark>
+{
+  std::vector<Benchmark> benchmarks;
+
+  const auto script = std::make_shared<std::string>(createScript(1000));
+  benchmarks.push_back({"tokenize/script/1000", script->size(), [script]() -> Iteration {
+                          return [script]() { anka::extractTokens(*script); };
+                        }});
+
+  const auto tokens = std::make_shared<std::vector<anka::Token>>(anka::extractTokens(*script));
+  benchmarks.push_back({"parse/script/1000", tokens->size(), [script, tokens]() -> Iteration {
+                          auto context = std::make_shared<anka::Context>();
+                          return [script, tokens, context]() {
+                            const auto mark = anka::markContext(*context);
+                            anka::parse(*script, *tokens, *context);
+                            anka::releaseTemporaries(*context, mark);
+                          };
+                        }});
+
+  benchmarks.push_back(dispatchBenchmark("unary", "inc", 64));
+  benchmarks.push_back(dispatchBenchmark("bound", "add[1]", 64));
+  benchmarks.push_back(dispatchBenchmark("placeholder", "add[_1 _1]", 16));
+
+  for (const auto size : arraySizes)
+  {
+    benchmarks.push_back(arrayBenchmark("elementwise", "neg x", size));
+    benchmarks.push_back(arrayBenchmark("elementwise", "add[x x]", size));
+    benchmarks.push_back(arrayBenchmark("elementwise", "mul[2] inc x", size));
+    benchmarks.push_back(arrayBenchmark("reduction", "sum x", size));
+    benchmarks.push_back(arrayBenchmark("reduction", "foldl[add] x", size));
+    benchmarks.push_back(arrayBenchmark("reduction", "foldl[max] x", size));
+    benchmarks.push_back(arrayBenchmark("scan", "scanl[add] x", size));
+    benchmarks.push_back(arrayBenchmark("sort", "sort x", size));
+    benchmarks.push_back(arrayBenchmark("filter", "filter[is_positive] x", size));
+    benchmarks.push_back(arrayBenchmark("executor", "|sum length| x", size));
+    benchmarks.push_back(arrayBenchmark("tuple", "mul |inc dec| x", size));
+    benchmarks.push_back(arrayBenchmark("tuple", "mul[_1 _1] x", size));
+  }
+  return benchmarks;
+}
+
+auto runIterations(const Iteration &iteration, size_t count) -> Clock::duration
+{
+  const auto start = Clock::now();
+  for (size_t i = 0; i < count; ++i)
+    iteration();
+  return Clock::now() - start;
+}
+
+auto measure(const Benchmark &benchmark) -> Measurement
+{
+  const auto iteration = benchmark.setup();
+
+  // the first iteration builds the lazily created tables and warms the caches
+  iteration();
+
+  size_t count = 1;
+  auto elapsed = runIterations(iteration, count);
+  while (elapsed < repetitionTime / 10)
+  {
+    count *= 2;
+    elapsed = runIterations(iteration, count);
+  }
+  // scale the count to a repetition of about repetitionTime
+  const auto scale = std::chrono::duration<double>(repetitionTime) / std::chrono::duration<double>(elapsed);
+  count = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(count) * scale));
+
+  std::vector<double> nanoseconds;
+  const auto allocationsBefore = allocationCount.load();
+  const auto bytesBefore = allocatedBytes.load();
+  for (size_t repetition = 0; repetition < repetitionCount; ++repetition)
+  {
+    const auto duration = std::chrono::duration<double, std::nano>(runIterations(iteration, count));
+    nanoseconds.push_back(duration.count() / static_cast<double>(count));
+  }
+  const auto totalIterations = static_cast<double>(count * repetitionCount);
+
+  std::ranges::sort(nanoseconds);
+  Measurement res;
+  res.name = benchmark.name;
+  res.iterations = count;
+  res.nanoseconds = nanoseconds[nanoseconds.size() / 2];
+  res.itemsPerSecond = static_cast<double>(benchmark.items) * 1e9 / res.nanoseconds;
+  res.allocations = static_cast<double>(allocationCount.load() - allocationsBefore) / totalIterations;
+  res.allocatedBytes = static_cast<double>(allocatedBytes.load() - bytesBefore) / totalIterations;
+  return res;
+}
+
+auto toJson(const std::vector<Measurement> &measurements) -> std::string
+{
+  std::string json = std::format("{{\n  \"threads\": {},\n  \"repetitions\": {},\n  \"benchmarks\": [",
+                                 anka::getThreadCount(), repetitionCount);
+  for (size_t i = 0; i < measurements.size(); ++i)
+  {
+    const auto &m = measurements[i];
+    json += std::format("{}\n    {{\"name\": \"{}\", \"iterations\": {}, \"ns_per_iteration\": {:.1f}, "
+                        "\"items_per_second\": {:.1f}, \"allocations_per_iteration\": {:.2f}, "
+                        "\"bytes_per_iteration\": {:.1f}}}",
+                        i == 0 ? "" : ",", m.name, m.iterations, m.nanoseconds, m.itemsPerSecond, m.allocations,
+                        m.allocatedBytes);
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  using namespace argumentum;
+
+  std::optional<std::string> filterOpt;
+  std::optional<std::string> jsonOpt;
+  std::optional<int> threadCountOpt;
+
+  auto parser = argument_parser{};
+  auto params = parser.params();
+  parser.config().program(argv[0]).description("anka benchmarks");
+  parser.add_default_help_option();
+  params.add_parameter(filterOpt, "--filter").nargs(1).help("Only run the benchmarks whose name contains the text");
+  params.add_parameter(jsonOpt, "--json").nargs(1).help("File the results are written to as JSON");
+  params.add_parameter(threadCountOpt, "--threads", "-t")
+      .nargs(1)
+      .help("Number of threads used for large arrays, defaults to the number of cores");
+
+  if (!parser.parse_args(argc, argv))
+    return -1;
+
+  if (threadCountOpt)
+    anka::setThreadCount(std::max(1, threadCountOpt.value()));
+
+  std::cout << std::format("{:<40} {:>10} {:>14} {:>14} {:>12} {:>14}\n", "benchmark", "iterations", "ns/iteration",
+                           "items/s", "allocations", "bytes");
+
+  std::vector<Measurement> measurements;
+  for (const auto &benchmark : getBenchmarks())
+  {
+    if (filterOpt && benchmark.name.find(filterOpt.value()) == std::string::npos)
+      continue;
+
+    const auto &m = measurements.emplace_back(measure(benchmark));
+    std::cout << std::format("{:<40} {:>10} {:>14.1f} {:>14.4g} {:>12.2f} {:>14.1f}\n", m.name, m.iterations,
+                             m.nanoseconds, m.itemsPerSecond, m.allocations, m.allocatedBytes);
+  }
+
+  if (jsonOpt)
+  {
+    std::ofstream file(jsonOpt.value());
+    if (!file)
+    {
+      std::cerr << std::format("Could not create the output file: {}\n", jsonOpt.value());
+      return -1;
+    }
+    file << toJson(measurements);
+  }
+}
+
+#endif
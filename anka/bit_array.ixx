@@ -0,0 +1,247 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+export module anka:bit_array;
+
+namespace anka
+{
+
+// Boolean array that stores one value per bit. The bits after size() in the last block are always zero, so whole
+// blocks can be compared and counted.
+export class BitArray
+{
+public:
+  using Block = std::uint64_t;
+  static constexpr size_t bitsPerBlock = 64;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = bool;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = bool;
+
+    const_iterator() = default;
+    const_iterator(const BitArray *array, size_t index) : array(array), index(index)
+    {
+    }
+
+    auto operator*() const -> bool
+    {
+      return (*array)[index];
+    }
+    auto operator[](difference_type offset) const -> bool
+    {
+      return (*array)[index + offset];
+    }
+
+    auto operator++() -> const_iterator &
+    {
+      ++index;
+      return *this;
+    }
+    auto operator++(int) -> const_iterator
+    {
+      auto copy = *this;
+      ++index;
+      return copy;
+    }
+    auto operator--() -> const_iterator &
+    {
+      --index;
+      return *this;
+    }
+    auto operator--(int) -> const_iterator
+    {
+      auto copy = *this;
+      --index;
+      return copy;
+    }
+    auto operator+=(difference_type offset) -> const_iterator &
+    {
+      index += offset;
+      return *this;
+    }
+    auto operator-=(difference_type offset) -> const_iterator &
+    {
+      index -= offset;
+      return *this;
+    }
+    friend auto operator+(const_iterator iter, difference_type offset) -> const_iterator
+    {
+      return iter += offset;
+    }
+    friend auto operator+(difference_type offset, const_iterator iter) -> const_iterator
+    {
+      return iter += offset;
+    }
+    friend auto operator-(const_iterator iter, difference_type offset) -> const_iterator
+    {
+      return iter -= offset;
+    }
+    friend auto operator-(const const_iterator &lhs, const const_iterator &rhs) -> difference_type
+    {
+      return static_cast<difference_type>(lhs.index) - static_cast<difference_type>(rhs.index);
+    }
+    friend auto operator==(const const_iterator &lhs, const const_iterator &rhs) -> bool
+    {
+      return lhs.index == rhs.index;
+    }
+    friend auto operator<=>(const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return lhs.index <=> rhs.index;
+    }
+
+  private:
+    const BitArray *array = nullptr;
+    size_t index = 0;
+  };
+
+  BitArray() = default;
+
+  explicit BitArray(size_t size, bool value = false)
+      : bits(getBlockCount(size), value ? ~Block{0} : Block{0}), bitCount(size)
+  {
+    clearTail();
+  }
+
+  BitArray(std::initializer_list<bool> values) : BitArray(values.begin(), values.end())
+  {
+  }
+
+  template <std::input_iterator Iter> BitArray(Iter first, Iter last)
+  {
+    for (; first != last; ++first)
+    {
+      push_back(*first);
+    }
+  }
+
+  static constexpr auto getBlockCount(size_t size) -> size_t
+  {
+    return (size + bitsPerBlock - 1) / bitsPerBlock;
+  }
+
+  auto size() const -> size_t
+  {
+    return bitCount;
+  }
+
+  auto empty() const -> bool
+  {
+    return bitCount == 0;
+  }
+
+  auto operator[](size_t index) const -> bool
+  {
+    return (bits[index / bitsPerBlock] >> (index % bitsPerBlock)) & 1;
+  }
+
+  auto set(size_t index, bool value) -> void
+  {
+    const auto mask = Block{1} << (index % bitsPerBlock);
+    auto &block = bits[index / bitsPerBlock];
+    block = value ? (block | mask) : (block & ~mask);
+  }
+
+  auto push_back(bool value) -> void
+  {
+    if (bitCount % bitsPerBlock == 0)
+      bits.push_back(0);
+
+    bits.back() |= Block{value} << (bitCount % bitsPerBlock);
+    ++bitCount;
+  }
+
+  auto reserve(size_t size) -> void
+  {
+    bits.reserve(getBlockCount(size));
+  }
+
+  auto front() const -> bool
+  {
+    return (*this)[0];
+  }
+
+  auto back() const -> bool
+  {
+    return (*this)[bitCount - 1];
+  }
+
+  auto begin() const -> const_iterator
+  {
+    return {this, 0};
+  }
+
+  auto end() const -> const_iterator
+  {
+    return {this, bitCount};
+  }
+
+  auto blocks() -> std::span<Block>
+  {
+    return bits;
+  }
+
+  auto blocks() const -> std::span<const Block>
+  {
+    return bits;
+  }
+
+  // Zeroes the bits after size() in the last block, needed after writing whole blocks.
+  auto clearTail() -> void
+  {
+    const auto usedBits = bitCount % bitsPerBlock;
+    if (usedBits != 0)
+      bits.back() &= (Block{1} << usedBits) - 1;
+  }
+
+  // Number of true values
+  auto count() const -> size_t
+  {
+    size_t res = 0;
+    for (auto block : bits)
+    {
+      res += std::popcount(block);
+    }
+    return res;
+  }
+
+  auto all() const -> bool
+  {
+    return count() == bitCount;
+  }
+
+  auto any() const -> bool
+  {
+    return std::ranges::any_of(bits, [](Block block) { return block != 0; });
+  }
+
+  auto none() const -> bool
+  {
+    return !any();
+  }
+
+  friend auto operator==(const BitArray &lhs, const BitArray &rhs) -> bool
+  {
+    return lhs.bitCount == rhs.bitCount && lhs.bits == rhs.bits;
+  }
+
+private:
+  std::vector<Block> bits;
+  size_t bitCount = 0;
+};
+
+// Array type used for the elements of type T, boolean arrays are bit packed.
+export template <typename T> using Array = std::conditional_t<std::is_same_v<T, bool>, BitArray, std::vector<T>>;
+
+} // namespace anka
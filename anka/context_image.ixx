@@ -0,0 +1,530 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+export module anka:context_image;
+
+import :interpreter_state;
+import :internal_functions;
+import :errors;
+import :bit_array;
+import :dictionary;
+import :nested_array;
+import :array_io;
+
+// A context image holds the names, the pools and the values of the user defined names of a context, so the context
+// can be restored without executing the sentences that built it. Values are written little endian like in the array
+// files, arrays as their length followed by their raw elements.
+
+namespace anka
+{
+
+constexpr auto imageMagic = std::string_view{"ANKAIMG\n"};
+constexpr std::uint32_t imageVersion = 3;
+
+class ImageWriter
+{
+public:
+  explicit ImageWriter(std::ofstream &file) : file(file)
+  {
+  }
+
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  auto write(const T &value) -> void
+  {
+    file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T> auto writeArray(std::span<const T> values) -> void
+  {
+    write<std::uint64_t>(values.size());
+    file.write(reinterpret_cast<const char *>(values.data()), values.size_bytes());
+  }
+
+  auto writeString(std::string_view text) -> void
+  {
+    writeArray(std::span<const char>(text));
+  }
+
+  auto writeWord(const Word &word) -> void
+  {
+    write(static_cast<std::uint8_t>(word.type));
+    write<std::uint64_t>(word.index);
+  }
+
+  auto writeWords(const std::vector<Word> &words) -> void
+  {
+    write<std::uint64_t>(words.size());
+    for (const auto &word : words)
+      writeWord(word);
+  }
+
+  auto writeBits(const BitArray &values) -> void
+  {
+    write<std::uint64_t>(values.size());
+    writeArray(values.blocks());
+  }
+
+  template <typename T> auto writeNested(const NestedArray<T> &nested) -> void
+  {
+    if constexpr (std::is_same_v<T, bool>)
+      writeBits(nested.values());
+    else
+      writeArray(std::span<const T>(nested.values()));
+    const auto &offsets = nested.offsets();
+    writeArray(std::span<const std::uint64_t>(std::vector<std::uint64_t>(offsets.begin(), offsets.end())));
+  }
+
+private:
+  std::ofstream &file;
+};
+
+// Reads the values of an image from its mapped bytes, a value that does not fit in the rest throws.
+class ImageReader
+{
+public:
+  ImageReader(const std::filesystem::path &path, std::string_view bytes) : path(path), bytes(bytes)
+  {
+  }
+
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  auto read() -> T
+  {
+    T value;
+    std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+    return value;
+  }
+
+  // Number of items that follow, each takes at least itemSize bytes.
+  auto readCount(size_t itemSize) -> size_t
+  {
+    const auto count = read<std::uint64_t>();
+    if (count > (bytes.size() - position) / itemSize)
+      fail("truncated image");
+    return static_cast<size_t>(count);
+  }
+
+  template <typename T> auto readArray() -> std::vector<T>
+  {
+    const auto length = readCount(sizeof(T));
+    std::vector<T> values(length);
+    if (length > 0)
+      std::memcpy(values.data(), take(length * sizeof(T)).data(), length * sizeof(T));
+    return values;
+  }
+
+  auto readString() -> std::string
+  {
+    auto characters = readArray<char>();
+    return std::string(characters.begin(), characters.end());
+  }
+
+  auto readWord() -> Word
+  {
+    const auto type = static_cast<WordType>(read<std::uint8_t>());
+    return Word{type, static_cast<size_t>(read<std::uint64_t>())};
+  }
+
+  auto readWords() -> std::vector<Word>
+  {
+    std::vector<Word> words(readCount(wordSize));
+    for (auto &word : words)
+      word = readWord();
+    return words;
+  }
+
+  auto readBits() -> BitArray
+  {
+    const auto size = static_cast<size_t>(read<std::uint64_t>());
+    const auto blocks = readArray<BitArray::Block>();
+    if (blocks.size() != BitArray::getBlockCount(size))
+      fail("boolean array with a wrong number of blocks");
+
+    BitArray values(size);
+    std::ranges::copy(blocks, values.blocks().begin());
+    values.clearTail();
+    return values;
+  }
+
+  template <typename T> auto readNested() -> NestedArray<T>
+  {
+    auto values = [this] {
+      if constexpr (std::is_same_v<T, bool>)
+        return readBits();
+      else
+        return readArray<T>();
+    }();
+    const auto storedOffsets = readArray<std::uint64_t>();
+    std::vector<size_t> offsets(storedOffsets.begin(), storedOffsets.end());
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != values.size() ||
+        !std::ranges::is_sorted(offsets))
+      fail("nested array with wrong row offsets");
+
+    return NestedArray<T>(std::move(values), std::move(offsets));
+  }
+
+  auto atEnd() const -> bool
+  {
+    return position == bytes.size();
+  }
+
+  [[noreturn]] auto fail(const std::string &message) const -> void
+  {
+    throwArrayFileError(path, message);
+  }
+
+private:
+  auto take(size_t count) -> std::string_view
+  {
+    if (count > bytes.size() - position)
+      fail("truncated image");
+
+    const auto taken = bytes.substr(position, count);
+    position += count;
+    return taken;
+  }
+
+  // bytes of a word in the image
+  static constexpr size_t wordSize = sizeof(std::uint8_t) + sizeof(std::uint64_t);
+
+  std::filesystem::path path;
+  std::string_view bytes;
+  size_t position = 0;
+};
+
+auto writeDictionary(ImageWriter &writer, const Dictionary &dictionary) -> void
+{
+  writer.writeArray(std::span<const int>(dictionary.keys()));
+  writer.write(static_cast<std::uint8_t>(dictionary.values().index()));
+  std::visit(
+      [&writer](const auto &values) {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(values)>, BitArray>)
+          writer.writeBits(values);
+        else
+          writer.writeArray(std::span<const typename std::remove_cvref_t<decltype(values)>::value_type>(values));
+      },
+      dictionary.values());
+}
+
+auto readDictionary(ImageReader &reader) -> Dictionary
+{
+  const auto keys = reader.readArray<int>();
+  Dictionary dictionary;
+  dictionary.reserve(keys.size());
+  for (const auto key : keys)
+  {
+    if (!dictionary.insert(key).second)
+      reader.fail("dictionary with a repeated key");
+  }
+
+  Dictionary::Values values;
+  switch (reader.read<std::uint8_t>())
+  {
+  case 0:
+    values = reader.readArray<int>();
+    break;
+  case 1:
+    values = reader.readArray<double>();
+    break;
+  case 2:
+    values = reader.readBits();
+    break;
+  default:
+    reader.fail("dictionary with unknown values");
+  }
+
+  if (std::visit([](const auto &column) { return column.size(); }, values) != keys.size())
+    reader.fail("dictionary with a value count that differs from its key count");
+  dictionary.setValues(std::move(values));
+  return dictionary;
+}
+
+// Whether the word refers to a value or a name of the context.
+auto isValidWord(const Context &context, const Word &word) -> bool
+{
+  switch (word.type)
+  {
+  case WordType::IntegerNumber:
+    return word.index < context.integerNumbers.size();
+  case WordType::IntegerArray:
+    return word.index < context.integerArrays.size();
+  case WordType::DoubleNumber:
+    return word.index < context.doubleNumbers.size();
+  case WordType::DoubleArray:
+    return word.index < context.doubleArrays.size();
+  case WordType::Boolean:
+    return word.index < context.booleans.size();
+  case WordType::BooleanArray:
+    return word.index < context.booleanArrays.size();
+  case WordType::IntegerRange:
+    return word.index < context.integerRanges.size();
+  case WordType::Dictionary:
+    return word.index < context.dictionaries.size();
+  case WordType::NestedIntegerArray:
+    return word.index < context.nestedIntegerArrays.size();
+  case WordType::NestedDoubleArray:
+    return word.index < context.nestedDoubleArrays.size();
+  case WordType::NestedBooleanArray:
+    return word.index < context.nestedBooleanArrays.size();
+  case WordType::LongNumber:
+    return word.index < context.longNumbers.size();
+  case WordType::LongArray:
+    return word.index < context.longArrays.size();
+  case WordType::FloatArray:
+    return word.index < context.floatArrays.size();
+  case WordType::Int8Array:
+    return word.index < context.int8Arrays.size();
+  case WordType::Int16Array:
+    return word.index < context.int16Arrays.size();
+  case WordType::UInt8Array:
+    return word.index < context.uint8Arrays.size();
+  case WordType::Tuple:
+    return word.index < context.tuples.size();
+  case WordType::Executor:
+    return word.index < context.executors.size();
+  case WordType::Block:
+    return word.index < context.blocks.size();
+  case WordType::Name:
+    return word.index < context.names.size();
+  case WordType::PlaceHolder:
+  case WordType::Assignment:
+    return true;
+  default:
+    return false;
+  }
+}
+
+auto checkWords(const ImageReader &reader, const Context &context, const std::vector<Word> &words) -> void
+{
+  for (const auto &word : words)
+  {
+    if (!isValidWord(context, word))
+      reader.fail("word that refers to a missing value");
+  }
+}
+
+// Saves the names, the pools and the user defined names, temporaries that were not released are saved too.
+export auto saveContextImage(const Context &context, const std::filesystem::path &path) -> void
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+    throwArrayFileError(path, "could not create the file");
+
+  ImageWriter writer(file);
+  file.write(imageMagic.data(), imageMagic.size());
+  writer.write(imageVersion);
+
+  writer.write<std::uint64_t>(getInternalFunctionNames().size());
+  writer.write<std::uint64_t>(context.names.size());
+  for (const auto &name : context.names)
+    writer.writeString(name);
+
+  writer.writeArray(std::span<const int>(context.integerNumbers.values()));
+  writer.write<std::uint64_t>(context.integerArrays.size());
+  for (const auto &array : context.integerArrays)
+    writer.writeArray(std::span<const int>(array));
+  writer.writeArray(std::span<const double>(context.doubleNumbers.values()));
+  writer.write<std::uint64_t>(context.doubleArrays.size());
+  for (const auto &array : context.doubleArrays)
+    writer.writeArray(std::span<const double>(array));
+  const auto booleans = std::vector<std::uint8_t>(context.booleans.begin(), context.booleans.end());
+  writer.writeArray(std::span<const std::uint8_t>(booleans));
+  writer.write<std::uint64_t>(context.booleanArrays.size());
+  for (const auto &array : context.booleanArrays)
+    writer.writeBits(array);
+  writer.write<std::uint64_t>(context.integerRanges.size());
+  for (const auto &range : context.integerRanges)
+  {
+    writer.write(range.start);
+    writer.write(range.step);
+    writer.write<std::uint64_t>(range.length);
+  }
+  writer.write<std::uint64_t>(context.dictionaries.size());
+  for (const auto &dictionary : context.dictionaries)
+    writeDictionary(writer, dictionary);
+  writer.write<std::uint64_t>(context.nestedIntegerArrays.size());
+  for (const auto &nested : context.nestedIntegerArrays)
+    writer.writeNested(nested);
+  writer.write<std::uint64_t>(context.nestedDoubleArrays.size());
+  for (const auto &nested : context.nestedDoubleArrays)
+    writer.writeNested(nested);
+  writer.write<std::uint64_t>(context.nestedBooleanArrays.size());
+  for (const auto &nested : context.nestedBooleanArrays)
+    writer.writeNested(nested);
+  writer.writeArray(std::span<const std::int64_t>(context.longNumbers.values()));
+  writer.write<std::uint64_t>(context.longArrays.size());
+  for (const auto &array : context.longArrays)
+    writer.writeArray(std::span<const std::int64_t>(array));
+  writer.write<std::uint64_t>(context.floatArrays.size());
+  for (const auto &array : context.floatArrays)
+    writer.writeArray(std::span<const float>(array));
+  writer.write<std::uint64_t>(context.int8Arrays.size());
+  for (const auto &array : context.int8Arrays)
+    writer.writeArray(std::span<const std::int8_t>(array));
+  writer.write<std::uint64_t>(context.int16Arrays.size());
+  for (const auto &array : context.int16Arrays)
+    writer.writeArray(std::span<const std::int16_t>(array));
+  writer.write<std::uint64_t>(context.uint8Arrays.size());
+  for (const auto &array : context.uint8Arrays)
+    writer.writeArray(std::span<const std::uint8_t>(array));
+
+  writer.write<std::uint64_t>(context.tuples.size());
+  for (const auto &tuple : context.tuples)
+  {
+    writer.writeWords(tuple.words);
+    writer.write<std::uint8_t>(tuple.connectedNameIndexOpt.has_value());
+    writer.write<std::uint64_t>(tuple.connectedNameIndexOpt.value_or(0));
+  }
+  writer.write<std::uint64_t>(context.executors.size());
+  for (const auto &executor : context.executors)
+    writer.writeWords(executor.words);
+  writer.write<std::uint64_t>(context.blocks.size());
+  for (const auto &block : context.blocks)
+    writer.writeWords(block.words);
+
+  for (const auto &value : context.userDefinedNames)
+  {
+    writer.write<std::uint8_t>(value.has_value());
+    writer.writeWord(value.value_or(Word{WordType::Name, 0}));
+  }
+
+  if (!file)
+    throwArrayFileError(path, "could not write the file");
+}
+
+// Restores a context saved by saveContextImage. The image is mapped and every array is copied out of it at once,
+// nothing is parsed or executed.
+export auto loadContextImage(const std::filesystem::path &path) -> Context
+{
+  MappedFile file(path);
+  const auto bytes = file.bytes();
+  if (!bytes.starts_with(imageMagic))
+    throwArrayFileError(path, "not a context image");
+
+  ImageReader reader(path, bytes.substr(imageMagic.size()));
+  if (reader.read<std::uint32_t>() != imageVersion)
+    reader.fail("unsupported image version");
+
+  // name ids of the internal functions are their positions, the image has to agree with this build
+  Context context;
+  const auto internalCount = reader.read<std::uint64_t>();
+  const auto nameCount = reader.readCount(sizeof(std::uint64_t));
+  if (internalCount != getInternalFunctionNames().size() || nameCount < internalCount)
+    reader.fail("the image was saved with other internal functions");
+  for (std::uint64_t id = 0; id < nameCount; ++id)
+  {
+    const auto name = reader.readString();
+    if (id < internalCount ? name != context.names[id] : internName(context, name) != id)
+      reader.fail(id < internalCount ? "the image was saved with other internal functions" : "repeated name");
+  }
+
+  context.integerNumbers = reader.readArray<int>();
+  context.integerArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.integerArrays)
+    array = reader.readArray<int>();
+  context.doubleNumbers = reader.readArray<double>();
+  context.doubleArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.doubleArrays)
+    array = reader.readArray<double>();
+  const auto booleans = reader.readArray<std::uint8_t>();
+  context.booleans.assign(booleans.begin(), booleans.end());
+  context.booleanArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.booleanArrays)
+    array = reader.readBits();
+  context.integerRanges.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &range : context.integerRanges)
+  {
+    range.start = reader.read<int>();
+    range.step = reader.read<int>();
+    range.length = static_cast<size_t>(reader.read<std::uint64_t>());
+  }
+  context.dictionaries.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &dictionary : context.dictionaries)
+    dictionary = readDictionary(reader);
+  context.nestedIntegerArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &nested : context.nestedIntegerArrays)
+    nested = reader.readNested<int>();
+  context.nestedDoubleArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &nested : context.nestedDoubleArrays)
+    nested = reader.readNested<double>();
+  context.nestedBooleanArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &nested : context.nestedBooleanArrays)
+    nested = reader.readNested<bool>();
+  context.longNumbers = reader.readArray<std::int64_t>();
+  context.longArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.longArrays)
+    array = reader.readArray<std::int64_t>();
+  context.floatArrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.floatArrays)
+    array = reader.readArray<float>();
+  context.int8Arrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.int8Arrays)
+    array = reader.readArray<std::int8_t>();
+  context.int16Arrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.int16Arrays)
+    array = reader.readArray<std::int16_t>();
+  context.uint8Arrays.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &array : context.uint8Arrays)
+    array = reader.readArray<std::uint8_t>();
+
+  context.tuples.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &tuple : context.tuples)
+  {
+    tuple.words = reader.readWords();
+    const auto isConnected = reader.read<std::uint8_t>() != 0;
+    const auto connected = static_cast<size_t>(reader.read<std::uint64_t>());
+    if (isConnected)
+      tuple.connectedNameIndexOpt = connected;
+  }
+  context.executors.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &executor : context.executors)
+    executor.words = reader.readWords();
+  context.blocks.resize(reader.readCount(sizeof(std::uint64_t)));
+  for (auto &block : context.blocks)
+    block.words = reader.readWords();
+
+  for (auto &value : context.userDefinedNames)
+  {
+    const auto hasValue = reader.read<std::uint8_t>() != 0;
+    const auto word = reader.readWord();
+    if (hasValue)
+      value = word;
+  }
+  if (!reader.atEnd())
+    reader.fail("unexpected data after the image");
+
+  // the words are only used after all pools are read, so they can refer to values of any pool
+  for (const auto &tuple : context.tuples)
+  {
+    checkWords(reader, context, tuple.words);
+    if (tuple.connectedNameIndexOpt && tuple.connectedNameIndexOpt.value() >= context.names.size())
+      reader.fail("tuple connected to a missing name");
+  }
+  for (const auto &executor : context.executors)
+    checkWords(reader, context, executor.words);
+  for (const auto &block : context.blocks)
+    checkWords(reader, context, block.words);
+  for (const auto &value : context.userDefinedNames)
+  {
+    if (value && !isValidWord(context, value.value()))
+      reader.fail("name with a missing value");
+  }
+
+  return context;
+}
+
+} // namespace anka
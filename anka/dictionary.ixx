@@ -0,0 +1,169 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+export module anka:dictionary;
+
+import :bit_array;
+import :thread_pool;
+
+namespace anka
+{
+
+// Map from int keys to the values of one column. Keys and values are stored contiguously in insertion order, the
+// hash table only maps keys to their positions. It uses open addressing with linear probing, so a lookup reads one
+// or two neighbouring slots of 8 bytes.
+export class Dictionary
+{
+public:
+  using Values = std::variant<std::vector<int>, std::vector<double>, BitArray>;
+
+  static constexpr auto npos = std::numeric_limits<size_t>::max();
+
+  Dictionary() = default;
+
+  auto size() const -> size_t
+  {
+    return keyColumn.size();
+  }
+
+  auto keys() const -> const std::vector<int> &
+  {
+    return keyColumn;
+  }
+
+  auto values() const -> const Values &
+  {
+    return valueColumn;
+  }
+
+  // Values of the keys in insertion order, has to have one value per key.
+  auto setValues(Values &&values) -> void
+  {
+    valueColumn = std::move(values);
+  }
+
+  auto reserve(size_t count) -> void
+  {
+    keyColumn.reserve(count);
+    if (getCapacity(count) > slots.size())
+      rehash(getCapacity(count));
+  }
+
+  // Position of the key, a key that was not seen before is added at the end. The flag tells if it was added.
+  auto insert(int key) -> std::pair<size_t, bool>
+  {
+    if (getCapacity(keyColumn.size() + 1) > slots.size())
+      rehash(getCapacity(keyColumn.size() + 1));
+
+    auto slot = getSlot(key);
+    for (; slots[slot].position != emptySlot; slot = (slot + 1) & (slots.size() - 1))
+    {
+      if (slots[slot].key == key)
+        return {slots[slot].position - 1, false};
+    }
+
+    keyColumn.push_back(key);
+    slots[slot] = Slot{key, static_cast<std::uint32_t>(keyColumn.size())};
+    return {keyColumn.size() - 1, true};
+  }
+
+  // Position of the key, npos if it is missing.
+  auto find(int key) const -> size_t
+  {
+    if (slots.empty())
+      return npos;
+
+    for (auto slot = getSlot(key); slots[slot].position != emptySlot; slot = (slot + 1) & (slots.size() - 1))
+    {
+      if (slots[slot].key == key)
+        return slots[slot].position - 1;
+    }
+    return npos;
+  }
+
+  // Values of all keys in one pass over them, nothing if one of the keys is missing.
+  auto lookup(std::span<const int> keys) const -> std::optional<Values>
+  {
+    std::vector<size_t> positions(keys.size());
+    std::atomic<bool> missing = false;
+    parallelFor(keys.size(), [&](size_t begin, size_t end) {
+      for (auto i = begin; i < end; ++i)
+      {
+        positions[i] = find(keys[i]);
+        if (positions[i] == npos)
+          missing.store(true, std::memory_order_relaxed);
+      }
+    });
+    if (missing.load())
+      return std::nullopt;
+
+    return std::visit(
+        [&positions](const auto &column) -> Values {
+          using Column = std::remove_cvref_t<decltype(column)>;
+          Column res(positions.size());
+          // chunks start at multiples of the bit array block size, so they never write the same block
+          parallelFor(positions.size(), [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i)
+            {
+              if constexpr (std::is_same_v<Column, BitArray>)
+                res.set(i, column[positions[i]]);
+              else
+                res[i] = column[positions[i]];
+            }
+          });
+          return res;
+        },
+        valueColumn);
+  }
+
+private:
+  struct Slot
+  {
+    int key = 0;
+    // position + 1 of the key, zero for empty slots
+    std::uint32_t position = 0;
+  };
+
+  static constexpr std::uint32_t emptySlot = 0;
+
+  // Power of two that keeps the table at most half full.
+  static auto getCapacity(size_t count) -> size_t
+  {
+    return std::bit_ceil(std::max<size_t>(16, 2 * count));
+  }
+
+  // Fibonacci hashing spreads consecutive keys over the whole table.
+  auto getSlot(int key) const -> size_t
+  {
+    const auto hash = static_cast<std::uint64_t>(static_cast<std::uint32_t>(key)) * 0x9e3779b97f4a7c15ull;
+    return static_cast<size_t>(hash >> (64 - std::countr_zero(slots.size())));
+  }
+
+  auto rehash(size_t capacity) -> void
+  {
+    slots.assign(capacity, Slot{});
+    for (size_t i = 0; i < keyColumn.size(); ++i)
+    {
+      auto slot = getSlot(keyColumn[i]);
+      while (slots[slot].position != emptySlot)
+        slot = (slot + 1) & (slots.size() - 1);
+      slots[slot] = Slot{keyColumn[i], static_cast<std::uint32_t>(i + 1)};
+    }
+  }
+
+  std::vector<int> keyColumn;
+  Values valueColumn;
+  std::vector<Slot> slots;
+};
+
+} // namespace anka
@@ -1,10 +1,14 @@
 module;
+#include <format>
 #include <optional>
+#include <ostream>
 #include <string>
 
 export module anka:errors;
 
 import :interpreter_state;
+import :tokenizer;
+import :parser;
 
 namespace anka
 {
@@ -16,4 +20,43 @@ export struct ExecutionError
   std::string msg;
 };
 
+// Runs func and writes the errors it throws to errors, token positions of parse errors are shifted by offset.
+export template <typename Func>
+auto reportErrors(Context &context, size_t offset, std::ostream &errors, Func func) -> bool
+{
+  try
+  {
+    func();
+    return true;
+  }
+  catch (const TokenizerError &err)
+  {
+    errors << std::format("Token error at {} character: {}.\n", err.pos, err.ch);
+    return false;
+  }
+  catch (const ParseError &err)
+  {
+    errors << std::format("AST error: {}.\n", err.message);
+    if (err.tokenOpt.has_value())
+    {
+      auto t = err.tokenOpt.value();
+      errors << std::format("Token start: {}, length: {}.\n", t.start + offset, t.len);
+    }
+    return false;
+  }
+  catch (const ExecutionError &err)
+  {
+    errors << err.msg << "\n";
+    if (err.word1.has_value())
+    {
+      errors << std::format("word: {}\n", toString(context, err.word1.value()));
+    }
+    if (err.word2.has_value())
+    {
+      errors << std::format("word: {}\n", toString(context, err.word2.value()));
+    }
+    return false;
+  }
+}
+
 } // namespace anka
@@ -1,9 +1,17 @@
 module;
 #include <algorithm>
 #include <format>
+#include <functional>
+#include <memory>
 #include <numeric>
 #include <optional>
+#include <set>
+#include <span>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -15,9 +23,15 @@ import :interpreter_state;
 import :errors;
 import :type_system;
 import :internal_functions;
+import :bit_array;
+import :nested_array;
+import :thread_pool;
+import :memoization;
+import :profiler;
 
 // forward declerations
-auto executeWords(anka::Context &context, const std::vector<anka::Word> &words) -> std::optional<anka::Word>;
+auto executeWords(anka::Context &context, const std::vector<anka::Word> &words, anka::Instruction *instructions,
+                  std::optional<anka::Word> last) -> std::optional<anka::Word>;
 
 auto getArrayItemType(anka::WordType arrType) -> std::optional<anka::WordType>
 {
@@ -29,11 +43,61 @@ auto getArrayItemType(anka::WordType arrType) -> std::optional<anka::WordType>
     return anka::WordType::DoubleNumber;
   case anka::WordType::BooleanArray:
     return anka::WordType::Boolean;
+  case anka::WordType::NestedIntegerArray:
+    return anka::WordType::IntegerArray;
+  case anka::WordType::NestedDoubleArray:
+    return anka::WordType::DoubleArray;
+  case anka::WordType::NestedBooleanArray:
+    return anka::WordType::BooleanArray;
+  case anka::WordType::LongArray:
+    return anka::WordType::LongNumber;
+  // storage kinds are widened
+  case anka::WordType::FloatArray:
+    return anka::WordType::DoubleNumber;
+  case anka::WordType::Int8Array:
+  case anka::WordType::Int16Array:
+  case anka::WordType::UInt8Array:
+    return anka::WordType::IntegerNumber;
+  default:
+    return std::nullopt;
+  }
+}
+
+auto isNestedArray(anka::WordType type) -> bool
+{
+  return type == anka::WordType::NestedIntegerArray || type == anka::WordType::NestedDoubleArray ||
+         type == anka::WordType::NestedBooleanArray;
+}
+
+// Type of the values in the rows of a nested array, element-wise functions expand through both levels.
+auto getNestedValueType(anka::WordType type) -> std::optional<anka::WordType>
+{
+  switch (type)
+  {
+  case anka::WordType::NestedIntegerArray:
+    return anka::WordType::IntegerNumber;
+  case anka::WordType::NestedDoubleArray:
+    return anka::WordType::DoubleNumber;
+  case anka::WordType::NestedBooleanArray:
+    return anka::WordType::Boolean;
   default:
     return std::nullopt;
   }
 }
 
+// Results of a function called on every row that can be collected, arrays of them are nested arrays.
+auto isRowResult(const anka::TypeVariant &type) -> bool
+{
+  if (anka::isExpandable(type))
+    return true;
+  if (type.index() != 0)
+    return false;
+
+  const auto family = std::get<anka::TypeFamily>(type);
+  return family == anka::TypeFamily::IntArray || family == anka::TypeFamily::DoubleArray ||
+         family == anka::TypeFamily::BoolArray;
+}
+
 struct Interpretation
 {
   std::vector<anka::TypeVariant> arguments;
@@ -76,6 +140,11 @@ auto getAllInterpretations(const anka::Context &context, const std::vector<anka:
   std::vector<Interpretation> allPossibilities;
   allPossibilities.push_back({toType(wordTypes), std::vector<bool>(wordTypes.size())});
 
+  // ints are only taken as longs next to other longs, the int overloads match everything else
+  const auto hasLongs = std::ranges::any_of(wordTypes, [](auto type) {
+    return type == anka::WordType::LongNumber || type == anka::WordType::LongArray;
+  });
+
   for (auto [i, type] : ranges::views::enumerate(wordTypes))
   {
     const auto itemType = getArrayItemType(type);
@@ -89,6 +158,17 @@ auto getAllInterpretations(const anka::Context &context, const std::vector<anka:
       });
     }
 
+    const auto valueType = getNestedValueType(type);
+    if (valueType)
+    {
+      addInterpretation(allPossibilities, [i, &valueType](const Interpretation &possibility) {
+        auto newPossibility = possibility;
+        newPossibility.arguments[i] = anka::toType(valueType.value());
+        newPossibility.expandArray[i] = true;
+        return newPossibility;
+      });
+    }
+
     if (type == anka::WordType::IntegerNumber)
     {
       addInterpretation(allPossibilities, [i, &itemType](const Interpretation &possibility) {
@@ -96,12 +176,18 @@ auto getAllInterpretations(const anka::Context &context, const std::vector<anka:
         newPossibility.arguments[i] = anka::toType(anka::WordType::DoubleNumber);
         return newPossibility;
       });
+      if (hasLongs)
+      {
+        addInterpretation(allPossibilities, [i](const Interpretation &possibility) {
+          auto newPossibility = possibility;
+          newPossibility.arguments[i] = anka::toType(anka::WordType::LongNumber);
+          return newPossibility;
+        });
+      }
     }
     else if (type == anka::WordType::Name)
     {
-      auto word = words[i];
-      auto name = anka::getValue<std::string>(context, word.index);
-      auto allInternalFunctionWithName = anka::getInternalFunctionDefinitionsWithName(name);
+      const auto &allInternalFunctionWithName = anka::getInternalFunctionDefinitionsWithId(words[i].index);
       for (auto &def : allInternalFunctionWithName)
       {
         addInterpretation(allPossibilities, [i, &itemType, &def](const Interpretation &possibility) {
@@ -119,11 +205,50 @@ auto getAllInterpretations(const anka::Context &context, const std::vector<anka:
 
 struct ExecutionInformation
 {
-  anka::InternalFunctionExecuter executer;
-  Interpretation interpretation;
+  const anka::InternalFunctionExecuter *executer;
+  const std::vector<bool> *expandArray;
   std::vector<anka::Word> allWords;
+  bool expandsNestedValues = false;
 };
 
+struct ResolvedOverload
+{
+  const anka::InternalFunctionExecuter *executer;
+  std::vector<bool> expandArray;
+  // the expanded nested arrays are expanded to their values instead of their rows
+  bool expandsNestedValues = false;
+};
+
+// Overload resolution only depends on the function name, the argument types and the names of the internal
+// functions given as arguments. Internal function names have the same id in every context.
+struct DispatchKey
+{
+  size_t nameId;
+  std::vector<anka::WordType> types;
+  std::vector<size_t> functionArguments;
+
+  bool operator==(const DispatchKey &) const = default;
+};
+
+struct DispatchKeyHash
+{
+  inline auto operator()(const DispatchKey &key) const -> size_t
+  {
+    auto ret = key.nameId;
+    for (auto type : key.types)
+    {
+      ret = ret * 31 + static_cast<size_t>(type);
+    }
+    for (auto nameId : key.functionArguments)
+    {
+      ret = ret * 31 + nameId;
+    }
+    return ret;
+  }
+};
+
+using DispatchCache = std::unordered_map<DispatchKey, std::optional<ResolvedOverload>, DispatchKeyHash>;
+
 auto replaceUserDefinedNames(const anka::Context &context, const std::vector<anka::Word> &words)
     -> std::vector<anka::Word>
 {
@@ -132,41 +257,127 @@ auto replaceUserDefinedNames(const anka::Context &context, const std::vector<ank
   {
     if (w.type == anka::WordType::Name)
     {
-      auto name = anka::getValue<std::string>(context, w.index);
-      auto iter = context.userDefinedNames.find(name);
-      if (iter != context.userDefinedNames.end())
-      {
-        replaced[i] = iter->second;
-      }
+      if (const auto &value = context.userDefinedNames[w.index])
+        replaced[i] = value.value();
     }
   }
 
   return replaced;
 }
 
-auto findOverload(const anka::Context &context, const std::string &name, const anka::Word &word)
-    -> std::optional<ExecutionInformation>
+auto resolveOverload(const anka::Context &context, const std::string &name, const std::vector<anka::Word> &allWords)
+    -> std::optional<ResolvedOverload>
 {
-  const auto allWords = replaceUserDefinedNames(context, anka::getAllWords(context, word));
   const auto interpretations = getAllInterpretations(context, allWords);
-  for (auto interpretation : interpretations)
+  for (auto &interpretation : interpretations)
   {
     auto func = anka::getInternalFunction(name, interpretation.arguments);
     if (func)
     {
-      auto isExpanding = std::ranges::any_of(interpretation.expandArray, [](bool v) { return v; });
+      auto expandsRows = false;
+      auto expandsNestedValues = false;
+      auto expandsElements = false;
+      for (size_t i = 0; i < allWords.size(); ++i)
+      {
+        if (!interpretation.expandArray[i])
+          continue;
+
+        if (!isNestedArray(allWords[i].type))
+          expandsElements = true;
+        else if (anka::isExpandable(interpretation.arguments[i]))
+          expandsNestedValues = true;
+        else
+          expandsRows = true;
+      }
+
+      // the function is called per row of nested arrays, per value of nested arrays or per element of arrays, only
+      // one of them
+      if (expandsRows + expandsNestedValues + expandsElements > 1)
+        continue;
 
-      // we don't support array of arrays
-      if (isExpanding && !anka::isExpandable(func.value().first.returnType))
+      if (expandsRows && !isRowResult(func->first.returnType))
         continue;
 
-      return ExecutionInformation{func.value().second, interpretation, allWords};
+      // results per element can not be arrays
+      if ((expandsNestedValues || expandsElements) && !anka::isExpandable(func->first.returnType))
+        continue;
+
+      return ResolvedOverload{&func->second, interpretation.expandArray, expandsNestedValues};
     }
   }
 
   return std::nullopt;
 }
 
+auto createDispatchKey(size_t nameId, const std::vector<anka::Word> &allWords) -> DispatchKey
+{
+  DispatchKey key{nameId, anka::getWordTypes(allWords), {}};
+  for (const auto &word : allWords)
+  {
+    if (word.type == anka::WordType::Name)
+      key.functionArguments.push_back(word.index);
+  }
+  return key;
+}
+
+auto matchesCallSite(const anka::Context &context, const anka::CallSite &callSite,
+                     const std::vector<anka::Word> &allWords) -> bool
+{
+  if (callSite.namesVersion != context.namesVersion || callSite.arguments.size() != allWords.size())
+    return false;
+
+  for (size_t i = 0; i < allWords.size(); ++i)
+  {
+    const auto &cached = callSite.arguments[i];
+    if (cached.type != allWords[i].type)
+      return false;
+    if (cached.type == anka::WordType::Name && cached.index != allWords[i].index)
+      return false;
+  }
+  return true;
+}
+
+auto findOverload(const anka::Context &context, size_t nameId, const anka::Word &word, anka::CallSite *callSite)
+    -> std::optional<ExecutionInformation>
+{
+  // the internal functions never change, so resolutions are valid for the lifetime of the thread
+  thread_local DispatchCache cache;
+
+  auto allWords = anka::getAllWords(context, word);
+  if (callSite != nullptr && matchesCallSite(context, *callSite, allWords))
+  {
+    for (size_t i = 0; i < allWords.size(); ++i)
+    {
+      if (allWords[i].type == anka::WordType::Name)
+        allWords[i] = callSite->resolvedArguments[i];
+    }
+    return ExecutionInformation{callSite->executer, &callSite->expandArray, std::move(allWords),
+                                callSite->expandsNestedValues};
+  }
+
+  auto resolvedWords = replaceUserDefinedNames(context, allWords);
+  auto key = createDispatchKey(nameId, resolvedWords);
+
+  auto iter = cache.find(key);
+  if (iter == cache.end())
+  {
+    iter = cache.emplace(std::move(key), resolveOverload(context, context.names[nameId], resolvedWords)).first;
+  }
+
+  if (!iter->second)
+    return std::nullopt;
+
+  if (callSite != nullptr)
+  {
+    *callSite = anka::CallSite{context.namesVersion,      std::move(allWords),
+                               resolvedWords,             iter->second->executer,
+                               iter->second->expandArray, iter->second->expandsNestedValues};
+  }
+
+  return ExecutionInformation{iter->second->executer, &iter->second->expandArray, std::move(resolvedWords),
+                              iter->second->expandsNestedValues};
+}
+
 auto foldPlaceholder(anka::Context &context, const anka::Word &placeholder, const anka::Word &rhs) -> anka::Word
 {
   using namespace anka;
@@ -191,7 +402,24 @@ auto foldPlaceholder(anka::Context &context, const anka::Word &placeholder, cons
   throw anka::ExecutionError{placeholder, rhs, std::format("Placeholder _{} is out of range.", placeholder.index)};
 }
 
-auto foldtuple(anka::Context &context, const anka::Word &w1, const anka::Word &w2) -> anka::Word
+// Largest number of arguments of the internal functions with the name a tuple is connected to.
+auto getConnectedArity(const anka::Context &context, const anka::Tuple &tup) -> std::optional<size_t>
+{
+  if (!tup.connectedNameIndexOpt)
+    return std::nullopt;
+
+  const auto &found = anka::getInternalFunctionDefinitionsWithId(tup.connectedNameIndexOpt.value());
+  if (found.empty())
+    return std::nullopt;
+
+  auto maxArgIter = std::max_element(found.begin(), found.end(), [](const auto &def1, const auto &def2) {
+    return def1.argumentTypes.size() < def2.argumentTypes.size();
+  });
+  return maxArgIter->argumentTypes.size();
+}
+
+auto foldtuple(anka::Context &context, const anka::Word &w1, const anka::Word &w2, const anka::Instruction *instruction)
+    -> anka::Word
 {
   auto &&tup = anka::getValue<const anka::Tuple &>(context, w2.index);
 
@@ -221,24 +449,14 @@ auto foldtuple(anka::Context &context, const anka::Word &w1, const anka::Word &w
     }
   }
 
-  if (tup.connectedNameIndexOpt)
+  const auto arity = instruction != nullptr ? instruction->connectedArity : getConnectedArity(context, tup);
+  if (arity)
   {
-    const auto &connectedName = anka::getValue<std::string>(context, tup.connectedNameIndexOpt.value());
-    auto found = getInternalFunctionDefinitionsWithName(connectedName);
-
-    if (!found.empty())
+    int nrWordsToInsert = std::min(static_cast<int>(arity.value()) - static_cast<int>(tup.words.size()),
+                                   static_cast<int>(wordsToBeInserted.size()));
+    if (nrWordsToInsert > 0)
     {
-      auto maxArgIter = std::max_element(found.begin(), found.end(), [](const auto &def1, const auto &def2) {
-        return def1.argumentTypes.size() < def2.argumentTypes.size();
-      });
-
-      int nrWordsToInsert =
-          std::min(static_cast<int>(maxArgIter->argumentTypes.size()) - static_cast<int>(tup.words.size()),
-                   static_cast<int>(wordsToBeInserted.size()));
-      if (nrWordsToInsert > 0)
-      {
-        words.insert(words.end(), wordsToBeInserted.begin(), wordsToBeInserted.begin() + nrWordsToInsert);
-      }
+      words.insert(words.end(), wordsToBeInserted.begin(), wordsToBeInserted.begin() + nrWordsToInsert);
     }
   }
 
@@ -277,29 +495,484 @@ auto createExecutorBlocks(anka::Context &context, const std::vector<anka::Word>
   return sentences;
 }
 
+// Branches of executors on smaller inputs run one after the other, starting them on other threads would take longer
+// than the branches. A branch runs its functions on one thread, so on inputs that functions split over the thread
+// pool the branches only run concurrently when there are enough of them to keep every thread busy.
+constexpr size_t concurrentBranchThreshold = 1 << 12;
+
+auto getElementCount(const anka::Context &context, const anka::Word &word) -> size_t
+{
+  using namespace anka;
+  const auto valueOpt = getFoldableWord(context, word);
+  if (!valueOpt)
+    return 0;
+
+  const auto &value = valueOpt.value();
+  switch (value.type)
+  {
+  case WordType::IntegerArray:
+    return context.integerArrays[value.index].size();
+  case WordType::DoubleArray:
+    return context.doubleArrays[value.index].size();
+  case WordType::BooleanArray:
+    return context.booleanArrays[value.index].size();
+  case WordType::IntegerRange:
+    return context.integerRanges[value.index].length;
+  case WordType::NestedIntegerArray:
+    return context.nestedIntegerArrays[value.index].values().size();
+  case WordType::NestedDoubleArray:
+    return context.nestedDoubleArrays[value.index].values().size();
+  case WordType::NestedBooleanArray:
+    return context.nestedBooleanArrays[value.index].values().size();
+  case WordType::LongArray:
+    return context.longArrays[value.index].size();
+  case WordType::FloatArray:
+  case WordType::Int8Array:
+  case WordType::Int16Array:
+  case WordType::UInt8Array:
+    return visitStorageArray(context, value, [](auto values) { return values.size(); });
+  case WordType::Dictionary:
+    return context.dictionaries[value.index].size();
+  case WordType::Tuple: {
+    size_t count = 0;
+    for (const auto &element : context.tuples[value.index].words)
+      count += getElementCount(context, element);
+    return count;
+  }
+  default:
+    return 1;
+  }
+}
+
+// Whether executing the words can assign a name, also through the blocks and executors they refer to.
+auto assignsNames(const anka::Context &context, const std::vector<anka::Word> &words) -> bool
+{
+  using namespace anka;
+  std::vector<Word> stack(words.begin(), words.end());
+  std::set<Word> seen;
+  while (!stack.empty())
+  {
+    const auto word = stack.back();
+    stack.pop_back();
+    if (!seen.insert(word).second)
+      continue;
+
+    switch (word.type)
+    {
+    case WordType::Assignment:
+      return true;
+    case WordType::Name:
+      if (!isInternalFunction(word.index) && context.userDefinedNames[word.index])
+        stack.push_back(context.userDefinedNames[word.index].value());
+      break;
+    case WordType::Tuple:
+      stack.insert(stack.end(), context.tuples[word.index].words.begin(), context.tuples[word.index].words.end());
+      break;
+    case WordType::Executor:
+      stack.insert(stack.end(), context.executors[word.index].words.begin(),
+                   context.executors[word.index].words.end());
+      break;
+    case WordType::Block:
+      stack.insert(stack.end(), context.blocks[word.index].words.begin(), context.blocks[word.index].words.end());
+      break;
+    default:
+      break;
+    }
+  }
+  return false;
+}
+
+auto shouldRunConcurrently(const anka::Context &context, const std::vector<std::vector<anka::Word>> &blocks,
+                           const anka::Word &rhs) -> bool
+{
+  const auto elementCount = getElementCount(context, rhs);
+  return blocks.size() > 1 && anka::getThreadCount() > 1 && elementCount >= concurrentBranchThreshold &&
+         (elementCount < anka::parallelThreshold || blocks.size() >= anka::getThreadCount()) &&
+         std::ranges::none_of(blocks, [&context](const auto &block) { return assignsNames(context, block); });
+}
+
+// Runs every branch on the thread pool in a context of its own, which reads the values of the context in place and
+// keeps the values the branch creates. The context is only read while the branches run, their results are moved back
+// in order afterwards. The words of an error refer to the context of its branch, so they are moved back too.
+auto executeConcurrently(anka::Context &context, const std::vector<std::vector<anka::Word>> &blocks)
+    -> std::vector<anka::Word>
+{
+  using namespace anka;
+  loadInternalFunctions();
+
+  // the jobs create the contexts, inheriting copies the names
+  std::vector<std::optional<Context>> branchContexts(blocks.size());
+  std::vector<Word> res(blocks.size());
+  std::vector<std::optional<ExecutionError>> errors(blocks.size());
+  const std::function<void(size_t)> job = [&](size_t i) {
+    auto &branchContext = branchContexts[i].emplace(Inherit{context});
+    try
+    {
+      res[i] = executeWords(branchContext, blocks[i], nullptr, std::nullopt).value();
+    }
+    catch (ExecutionError &err)
+    {
+      errors[i] = std::move(err);
+    }
+  };
+  getThreadPool().run(blocks.size(), job);
+
+  for (size_t i = 0; i < blocks.size(); ++i)
+  {
+    if (!errors[i])
+      continue;
+
+    auto err = std::move(errors[i].value());
+    for (auto *word : {&err.word1, &err.word2})
+    {
+      if (word->has_value())
+        *word = moveWord(branchContexts[i].value(), context, word->value());
+    }
+    throw err;
+  }
+
+  for (size_t i = 0; i < blocks.size(); ++i)
+    res[i] = moveWord(branchContexts[i].value(), context, res[i]);
+  return res;
+}
+
 auto foldExecutor(anka::Context &context, const anka::Word &w1, const anka::Word &w2) -> anka::Word
 {
   using namespace anka;
   auto &&blocks = createExecutorBlocks(context, anka::getValue<const anka::Executor &>(context, w2.index).words, w1);
 
   std::vector<Word> res;
-  for (auto &&block : blocks)
+  if (shouldRunConcurrently(context, blocks, w1))
+  {
+    res = executeConcurrently(context, blocks);
+  }
+  else
   {
-    res.push_back(executeWords(context, block).value());
+    for (auto &&block : blocks)
+    {
+      res.push_back(executeWords(context, block, nullptr, std::nullopt).value());
+    }
   }
   return createWord(context, Tuple{res, false});
 }
 
+// Looks up an int key or all keys of an int array in one pass, ranges are materialized first.
+auto foldDictionary(anka::Context &context, const anka::Word &dictionaryWord, const anka::Word &rhs) -> anka::Word
+{
+  using namespace anka;
+  const auto keysWord = materialize(context, rhs);
+  const auto isScalar = keysWord.type == WordType::IntegerNumber;
+  if (!isScalar && keysWord.type != WordType::IntegerArray)
+    throw anka::ExecutionError{rhs, dictionaryWord, "Dictionaries are looked up with int keys."};
+
+  const auto keys = isScalar ? std::span<const int>(&context.integerNumbers[keysWord.index], 1)
+                             : std::span<const int>(context.integerArrays[keysWord.index]);
+  auto valuesOpt = context.dictionaries[dictionaryWord.index].lookup(keys);
+  if (!valuesOpt)
+    throw anka::ExecutionError{rhs, dictionaryWord, "Key not found."};
+
+  return std::visit(
+      [&](auto &&values) {
+        if (!isScalar)
+          return createWord(context, std::move(values));
+
+        auto value = values[0];
+        return createWord(context, value);
+      },
+      std::move(valuesOpt.value()));
+}
+
+using RowResults = std::variant<std::monostate, std::vector<int>, std::vector<double>, anka::BitArray,
+                                std::vector<std::int64_t>, anka::NestedArray<int>, anka::NestedArray<double>,
+                                anka::NestedArray<bool>>;
+
+template <typename T> auto getRowResults(RowResults &results) -> T &
+{
+  if (std::holds_alternative<std::monostate>(results))
+    results.emplace<T>();
+  return std::get<T>(results);
+}
+
+auto appendRowResult(const anka::Context &context, const anka::Word &word, RowResults &results) -> void
+{
+  using namespace anka;
+  switch (word.type)
+  {
+  case WordType::IntegerNumber:
+    getRowResults<std::vector<int>>(results).push_back(context.integerNumbers[word.index]);
+    break;
+  case WordType::DoubleNumber:
+    getRowResults<std::vector<double>>(results).push_back(context.doubleNumbers[word.index]);
+    break;
+  case WordType::Boolean:
+    getRowResults<BitArray>(results).push_back(context.booleans[word.index]);
+    break;
+  case WordType::LongNumber:
+    getRowResults<std::vector<std::int64_t>>(results).push_back(context.longNumbers[word.index]);
+    break;
+  case WordType::IntegerArray:
+    getRowResults<NestedArray<int>>(results).push_back(context.integerArrays[word.index]);
+    break;
+  case WordType::DoubleArray:
+    getRowResults<NestedArray<double>>(results).push_back(context.doubleArrays[word.index]);
+    break;
+  case WordType::BooleanArray:
+    getRowResults<NestedArray<bool>>(results).push_back(context.booleanArrays[word.index]);
+    break;
+  default:
+    throw anka::ExecutionError{word, std::nullopt, "Could not collect the result of a row."};
+  }
+}
+
+auto getRowCount(const anka::Context &context, const anka::Word &word) -> size_t
+{
+  switch (word.type)
+  {
+  case anka::WordType::NestedIntegerArray:
+    return context.nestedIntegerArrays[word.index].size();
+  case anka::WordType::NestedDoubleArray:
+    return context.nestedDoubleArrays[word.index].size();
+  default:
+    return context.nestedBooleanArrays[word.index].size();
+  }
+}
+
+auto getRowOffsets(const anka::Context &context, const anka::Word &word) -> const std::vector<size_t> &
+{
+  switch (word.type)
+  {
+  case anka::WordType::NestedIntegerArray:
+    return context.nestedIntegerArrays[word.index].offsets();
+  case anka::WordType::NestedDoubleArray:
+    return context.nestedDoubleArrays[word.index].offsets();
+  default:
+    return context.nestedBooleanArrays[word.index].offsets();
+  }
+}
+
+// Empty array of the type of the rows of a nested array.
+auto createRowBuffer(anka::Context &context, const anka::Word &nested) -> anka::Word
+{
+  switch (nested.type)
+  {
+  case anka::WordType::NestedIntegerArray:
+    return anka::createWord(context, std::vector<int>{});
+  case anka::WordType::NestedDoubleArray:
+    return anka::createWord(context, std::vector<double>{});
+  default:
+    return anka::createWord(context, anka::BitArray{});
+  }
+}
+
+auto copyRow(anka::Context &context, const anka::Word &nested, size_t row, const anka::Word &buffer) -> void
+{
+  switch (nested.type)
+  {
+  case anka::WordType::NestedIntegerArray: {
+    const auto values = context.nestedIntegerArrays[nested.index].row(row);
+    context.integerArrays[buffer.index].assign(values.begin(), values.end());
+    break;
+  }
+  case anka::WordType::NestedDoubleArray: {
+    const auto values = context.nestedDoubleArrays[nested.index].row(row);
+    context.doubleArrays[buffer.index].assign(values.begin(), values.end());
+    break;
+  }
+  default: {
+    const auto &array = context.nestedBooleanArrays[nested.index];
+    const auto values = array.values().begin();
+    const auto &offsets = array.offsets();
+    context.booleanArrays[buffer.index] = anka::BitArray(values + offsets[row], values + offsets[row + 1]);
+    break;
+  }
+  }
+}
+
+// Copy of the values of a nested array as a flat array.
+auto copyNestedValues(anka::Context &context, const anka::Word &nested) -> anka::Word
+{
+  switch (nested.type)
+  {
+  case anka::WordType::NestedIntegerArray:
+    return anka::createWord(context, std::vector<int>(context.nestedIntegerArrays[nested.index].values()));
+  case anka::WordType::NestedDoubleArray:
+    return anka::createWord(context, std::vector<double>(context.nestedDoubleArrays[nested.index].values()));
+  default:
+    return anka::createWord(context, anka::BitArray(context.nestedBooleanArrays[nested.index].values()));
+  }
+}
+
+// Calls the function once per row of the expanded nested arrays. Every nested argument gets one buffer that the rows
+// are copied to, so rows do not allocate, and a function that works in place writes over the buffer. Scalar results
+// are collected into an array and array results into a nested array.
+auto foldRows(anka::Context &context, const ExecutionInformation &info) -> std::optional<anka::Word>
+{
+  using namespace anka;
+
+  auto words = info.allWords;
+  const auto &expandArray = *info.expandArray;
+  const std::vector<bool> noExpansion(words.size());
+  const auto mark = markContext(context);
+
+  std::optional<size_t> rowCount;
+  std::vector<size_t> rowArguments;
+  for (size_t i = 0; i < words.size(); ++i)
+  {
+    if (!expandArray[i])
+      continue;
+
+    const auto count = getRowCount(context, words[i]);
+    if (rowCount && rowCount.value() != count)
+      throw anka::ExecutionError{words[i], std::nullopt, "Array size mismatch"};
+    rowCount = count;
+    rowArguments.push_back(i);
+  }
+
+  std::vector<Word> nestedWords;
+  for (auto i : rowArguments)
+  {
+    nestedWords.push_back(words[i]);
+    words[i] = createRowBuffer(context, words[i]);
+  }
+  if (rowArguments.size() == 1)
+    context.ownedArgument = words[rowArguments.front()];
+
+  // without rows the function is called once on empty rows to find the type of the result
+  RowResults results;
+  const auto rowMark = markContext(context);
+  for (size_t row = 0; row < std::max<size_t>(rowCount.value(), 1); ++row)
+  {
+    for (size_t i = 0; i < rowArguments.size() && row < rowCount.value(); ++i)
+      copyRow(context, nestedWords[i], row, words[rowArguments[i]]);
+
+    auto resultOpt = (*info.executer)(context, words, noExpansion);
+    if (!resultOpt)
+      return std::nullopt;
+
+    appendRowResult(context, resultOpt.value(), results);
+    anka::truncateContext(context, rowMark);
+  }
+  anka::truncateContext(context, mark);
+
+  return std::visit(
+      [&](auto &&values) -> Word {
+        using Values = std::remove_cvref_t<decltype(values)>;
+        if constexpr (std::is_same_v<Values, std::monostate>)
+          throw anka::ExecutionError{std::nullopt, std::nullopt, "Could not collect the result of a row."};
+        else if (rowCount.value() == 0)
+          return createWord(context, Values{});
+        else
+          return createWord(context, std::move(values));
+      },
+      std::move(results));
+}
+
+template <typename T>
+auto nestValues(anka::Context &context, const anka::ContextMark &mark, typename anka::NestedArray<T>::Values values,
+                std::vector<size_t> &&offsets) -> anka::Word
+{
+  anka::truncateContext(context, mark);
+  return anka::createWord(context, anka::NestedArray<T>(std::move(values), std::move(offsets)));
+}
+
+// Calls an element-wise function on the values of the expanded nested arrays, which need the same rows, and gives the
+// results those rows. The values are copied to flat arrays the function expands and can write over.
+auto foldNestedValues(anka::Context &context, const ExecutionInformation &info) -> std::optional<anka::Word>
+{
+  using namespace anka;
+
+  auto words = info.allWords;
+  const auto &expandArray = *info.expandArray;
+  const auto mark = markContext(context);
+
+  std::optional<std::vector<size_t>> offsets;
+  std::vector<size_t> valueArguments;
+  for (size_t i = 0; i < words.size(); ++i)
+  {
+    if (!expandArray[i])
+      continue;
+
+    const auto &rowOffsets = getRowOffsets(context, words[i]);
+    if (offsets && offsets.value() != rowOffsets)
+      throw anka::ExecutionError{words[i], std::nullopt, "Array size mismatch"};
+    if (!offsets)
+      offsets = rowOffsets;
+    valueArguments.push_back(i);
+  }
+
+  for (auto i : valueArguments)
+    words[i] = copyNestedValues(context, words[i]);
+  if (valueArguments.size() == 1)
+    context.ownedArgument = words[valueArguments.front()];
+
+  const auto resultOpt = (*info.executer)(context, words, expandArray);
+  if (!resultOpt)
+    return std::nullopt;
+
+  // a single value comes back as a scalar
+  const auto &result = resultOpt.value();
+  switch (result.type)
+  {
+  case WordType::IntegerNumber:
+    return nestValues<int>(context, mark, {context.integerNumbers[result.index]}, std::move(offsets.value()));
+  case WordType::DoubleNumber:
+    return nestValues<double>(context, mark, {context.doubleNumbers[result.index]}, std::move(offsets.value()));
+  case WordType::Boolean:
+    return nestValues<bool>(context, mark, {static_cast<bool>(context.booleans[result.index])},
+                            std::move(offsets.value()));
+  case WordType::IntegerArray:
+    return nestValues<int>(context, mark, std::move(context.integerArrays[result.index]), std::move(offsets.value()));
+  case WordType::DoubleArray:
+    return nestValues<double>(context, mark, std::move(context.doubleArrays[result.index]),
+                              std::move(offsets.value()));
+  case WordType::BooleanArray:
+    return nestValues<bool>(context, mark, std::move(context.booleanArrays[result.index]),
+                            std::move(offsets.value()));
+  default:
+    throw anka::ExecutionError{result, std::nullopt, "Could not collect the result of a row."};
+  }
+}
+
 auto foldFunction(anka::Context &context, const ExecutionInformation &info) -> std::optional<anka::Word>
 {
-  return info.executer(context, info.allWords, info.interpretation.expandArray);
+  if (info.expandsNestedValues)
+    return foldNestedValues(context, info);
+
+  const auto &expandArray = *info.expandArray;
+  for (size_t i = 0; i < info.allWords.size(); ++i)
+  {
+    if (expandArray[i] && isNestedArray(info.allWords[i].type))
+      return foldRows(context, info);
+  }
+
+  return (*info.executer)(context, info.allWords, *info.expandArray);
 }
 
-auto checkIfNameIsAvailable(anka::Context &context, const std::string &name) -> bool
+// Integer ranges stay lazy through the functions that have a closed form for them, ioata creates them.
+auto tryFoldRange(anka::Context &context, size_t nameId, const anka::Word &rhs, const anka::Instruction *instruction)
+    -> std::optional<anka::Word>
 {
-  if (!anka::getInternalFunctionDefinitionsWithName(name).empty())
+  const auto function =
+      instruction != nullptr ? instruction->rangeFunction : anka::getRangeFunction(context.names[nameId]);
+  if (function == nullptr)
+    return std::nullopt;
+
+  std::vector<anka::Word> arguments;
+  for (size_t i = 0; i < anka::getWordCount(context, rhs); ++i)
+  {
+    auto wordOpt = anka::getWord(context, rhs, i);
+    if (!wordOpt)
+      return std::nullopt;
+    arguments.push_back(wordOpt.value());
+  }
+  return function(context, arguments);
+}
+
+auto checkIfNameIsAvailable(anka::Context &context, size_t nameId) -> bool
+{
+  if (anka::isInternalFunction(nameId))
     return false;
-  if (context.userDefinedNames.contains(name))
+  if (context.userDefinedNames[nameId])
     return false;
   return true;
 }
@@ -315,7 +988,60 @@ auto getUnwrapedFoldableWord(const anka::Context &context, const anka::Word &wor
   throw anka::ExecutionError(word, std::nullopt, "Could not fold words");
 }
 
-auto fold(anka::Context &context, const anka::Word &lhs, const anka::Word &rhs) -> anka::Word
+namespace anka
+{
+// Resolves what does not depend on the values: which names are internal functions, their array kernels and the
+// arity of connected tuples. Overloads are resolved on first execution and kept per word.
+export auto compile(const Context &context, const std::vector<Word> &words) -> CompiledWords
+{
+  CompiledWords compiled{words, std::vector<Instruction>(words.size())};
+  for (size_t i = 0; i < words.size(); ++i)
+  {
+    const auto &word = words[i];
+    auto &instruction = compiled.instructions[i];
+    if (word.type == WordType::Name)
+    {
+      instruction.isInternalFunction = isInternalFunction(word.index);
+      if (instruction.isInternalFunction)
+      {
+        const auto &name = context.names[word.index];
+        instruction.unaryIntKernel = getUnaryArrayKernel<int>(name);
+        instruction.unaryDoubleKernel = getUnaryArrayKernel<double>(name);
+        instruction.boundIntKernel = getBoundArrayKernel<int>(name);
+        instruction.boundDoubleKernel = getBoundArrayKernel<double>(name);
+        instruction.rangeFunction = getRangeFunction(name);
+      }
+    }
+    else if (word.type == WordType::Tuple)
+    {
+      instruction.connectedArity = getConnectedArity(context, context.tuples[word.index]);
+    }
+  }
+  return compiled;
+}
+} // namespace anka
+
+auto getCompiledBlock(anka::Context &context, const anka::Word &word) -> std::shared_ptr<anka::CompiledWords>;
+
+// A pure block or executor applied to an argument it was applied to before returns the memoized result.
+template <typename Func>
+auto foldMemoized(anka::Context &context, const anka::Word &lhs, const anka::Word &rhs, Func func) -> anka::Word
+{
+  if (context.memo.capacity == 0 || assignsNames(context, {lhs}))
+    return func();
+
+  std::optional<size_t> hash;
+  if (auto resultOpt = anka::findMemoized(context, lhs, rhs, hash))
+    return resultOpt.value();
+
+  auto res = func();
+  anka::memoize(context, lhs, rhs, hash, res);
+  return res;
+}
+
+// owned is the array in rhs that the function called by lhs can write its result over.
+auto fold(anka::Context &context, const anka::Word &lhs, const anka::Word &rhs, anka::Instruction *instruction,
+          std::optional<anka::Word> owned) -> anka::Word
 {
   using namespace anka;
   if (context.assignNext)
@@ -325,11 +1051,10 @@ auto fold(anka::Context &context, const anka::Word &lhs, const anka::Word &rhs)
     if (lhs.type != WordType::Name)
       throw anka::ExecutionError{lhs, rhs, "Could not assign to non-name word."};
 
-    const auto &name = context.names[lhs.index];
-    if (!checkIfNameIsAvailable(context, name))
+    if (!checkIfNameIsAvailable(context, lhs.index))
       throw anka::ExecutionError{lhs, std::nullopt, "Name already taken."};
 
-    context.userDefinedNames[name] = getUnwrapedFoldableWord(context, rhs);
+    setUserDefinedName(context, lhs.index, getUnwrapedFoldableWord(context, rhs));
     return lhs;
   }
 
@@ -341,31 +1066,57 @@ auto fold(anka::Context &context, const anka::Word &lhs, const anka::Word &rhs)
 
   if (rhs.type == WordType::Name)
   {
-    return fold(context, lhs, getUnwrapedFoldableWord(context, rhs));
+    return fold(context, lhs, getUnwrapedFoldableWord(context, rhs), instruction, std::nullopt);
   }
 
   if (lhs.type == WordType::Name)
   {
-    const auto &name = context.names[lhs.index];
-    if (context.userDefinedNames.contains(name))
-      return fold(context, getUnwrapedFoldableWord(context, lhs), rhs);
+    if (const auto &value = context.userDefinedNames[lhs.index])
+    {
+      if (value->type != WordType::Block)
+        return fold(context, value.value(), rhs, nullptr, owned);
+
+      ProfileScope scope{ProfilePhase::Block, context.names[lhs.index]};
+      return fold(context, value.value(), rhs, nullptr, owned);
+    }
   }
 
   if (rhs.type == WordType::Block)
   {
-    auto &&block = getValue<const Block &>(context, rhs.index);
-    auto words = std::vector<Word>{lhs};
-    words.insert(words.end(), block.words.begin(), block.words.end());
-    return executeWords(context, words).value();
+    // lhs applied to the result of the block
+    auto compiled = getCompiledBlock(context, rhs);
+    if (compiled->words.empty())
+      return lhs;
+
+    auto res = executeWords(context, compiled->words, compiled->instructions.data(), std::nullopt).value();
+    return fold(context, lhs, res, instruction, std::nullopt);
   }
 
   if (lhs.type == WordType::Name)
   {
-    const auto &name = context.names[lhs.index];
-    auto interpretation = findOverload(context, name, rhs);
+    if (auto rangeOpt = tryFoldRange(context, lhs.index, rhs, instruction))
+      return rangeOpt.value();
+
+    // the other functions need the elements of ranges, a materialized range belongs to the call
+    const auto arguments = materialize(context, rhs);
+    if (rhs.type == WordType::IntegerRange)
+      owned = arguments;
+
+    std::optional<ExecutionInformation> interpretation;
+    {
+      ProfileScope scope{ProfilePhase::Dispatch, context.names[lhs.index]};
+      interpretation =
+          findOverload(context, lhs.index, arguments, instruction != nullptr ? &instruction->callSite : nullptr);
+    }
     if (interpretation)
     {
+      ProfileScope scope{ProfilePhase::Builtin, context.names[lhs.index]};
+      if (scope.isActive())
+        scope.setElements(getElementCount(context, arguments));
+
+      context.ownedArgument = owned;
       auto wordOpt = foldFunction(context, interpretation.value());
+      context.ownedArgument = std::nullopt;
       if (!wordOpt)
       {
         throw anka::ExecutionError{rhs, lhs, "Could not fold words."};
@@ -376,7 +1127,7 @@ auto fold(anka::Context &context, const anka::Word &lhs, const anka::Word &rhs)
   }
   else if (lhs.type == WordType::Tuple)
   {
-    return foldtuple(context, rhs, lhs);
+    return foldtuple(context, rhs, lhs, instruction);
   }
   else if (lhs.type == WordType::PlaceHolder)
   {
@@ -384,52 +1135,263 @@ auto fold(anka::Context &context, const anka::Word &lhs, const anka::Word &rhs)
   }
   else if (lhs.type == WordType::Executor)
   {
-    return foldExecutor(context, rhs, lhs);
+    ProfileScope scope{ProfilePhase::Executor, "executor"};
+    return foldMemoized(context, lhs, rhs, [&]() { return foldExecutor(context, rhs, lhs); });
+  }
+  else if (lhs.type == WordType::Dictionary)
+  {
+    return foldDictionary(context, lhs, rhs);
   }
   else if (lhs.type == WordType::Block)
   {
-    auto &&block = getValue<const Block &>(context, lhs.index);
-    auto words = block.words;
-    words.push_back(rhs);
-    return executeWords(context, words).value();
+    return foldMemoized(context, lhs, rhs, [&]() {
+      auto compiled = getCompiledBlock(context, lhs);
+      return executeWords(context, compiled->words, compiled->instructions.data(), rhs).value();
+    });
   }
 
   throw anka::ExecutionError{rhs, lhs, "Could not fold words."};
 }
 
-auto executeWords(anka::Context &context, const std::vector<anka::Word> &words) -> std::optional<anka::Word>
+template <typename T> auto getPipelineScalar(const anka::Context &context, const anka::Word &word) -> std::optional<T>
+{
+  if (word.type == anka::WordType::IntegerNumber)
+    return static_cast<T>(anka::getValue<int>(context, word.index));
+  if constexpr (std::is_same_v<T, double>)
+  {
+    if (word.type == anka::WordType::DoubleNumber)
+      return anka::getValue<double>(context, word.index);
+  }
+  return std::nullopt;
+}
+
+template <typename T> auto getUnaryKernel(const anka::Instruction &instruction) -> anka::UnaryArrayKernel<T>
+{
+  if constexpr (std::is_same_v<T, int>)
+    return instruction.unaryIntKernel;
+  else
+    return instruction.unaryDoubleKernel;
+}
+
+template <typename T> auto getBoundKernel(const anka::Instruction &instruction) -> anka::BoundArrayKernel<T>
+{
+  if constexpr (std::is_same_v<T, int>)
+    return instruction.boundIntKernel;
+  else
+    return instruction.boundDoubleKernel;
+}
+
+// Collects the element-wise stages to the left of words[end], returns them in execution order together with the
+// index of the first word that was not collected. Compiled words already know their kernels.
+template <typename T>
+auto collectPipeline(const anka::Context &context, const std::vector<anka::Word> &words,
+                     const anka::Instruction *instructions, size_t end)
+    -> std::pair<std::vector<anka::PipelineStage<T>>, size_t>
 {
-  using namespace ranges;
   using namespace anka;
 
-  if (words.empty())
+  std::vector<PipelineStage<T>> stages;
+  auto i = end;
+  while (i > 0)
+  {
+    const auto &word = words[i - 1];
+    if (word.type == WordType::Name)
+    {
+      auto kernel = instructions != nullptr ? getUnaryKernel<T>(instructions[i - 1])
+                                            : getUnaryArrayKernel<T>(context.names[word.index]);
+      if (!kernel)
+        break;
+
+      stages.push_back({kernel, nullptr, T{}});
+      i -= 1;
+    }
+    else if (word.type == WordType::Tuple && i >= 2)
+    {
+      // name[scalar] applied to an array
+      const auto &tup = context.tuples[word.index];
+      const auto &name = words[i - 2];
+      if (!tup.connectedNameIndexOpt || tup.words.size() != 1 || name.type != WordType::Name ||
+          name.index != tup.connectedNameIndexOpt.value())
+        break;
+
+      auto scalar = getPipelineScalar<T>(context, tup.words.front());
+      auto kernel = instructions != nullptr ? getBoundKernel<T>(instructions[i - 2])
+                                            : getBoundArrayKernel<T>(context.names[name.index]);
+      if (!scalar || !kernel)
+        break;
+
+      stages.push_back({nullptr, kernel, scalar.value()});
+      i -= 2;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  return {std::move(stages), i};
+}
+
+template <typename T>
+auto foldPipeline(anka::Context &context, const std::vector<anka::Word> &words, const anka::Instruction *instructions,
+                  size_t end, const anka::Word &array, bool isOwned) -> std::optional<std::pair<anka::Word, size_t>>
+{
+  auto [stages, next] = collectPipeline<T>(context, words, instructions, end);
+  if (stages.size() < 2)
     return std::nullopt;
 
-  const auto &init = words.back();
-  auto rv = words | views::reverse | views::drop(1);
+  anka::ProfileScope scope{anka::ProfilePhase::Builtin, "pipeline"};
+  const auto &vec = anka::getValue<std::vector<T>>(context, array.index);
+  scope.setElements(vec.size());
+  if (isOwned)
+  {
+    anka::applyPipeline(vec, stages, anka::getArray<T>(context, array.index));
+    return std::make_pair(array, next);
+  }
+
+  auto res = anka::applyPipeline(vec, stages);
+  return std::make_pair(anka::createWord(context, std::move(res)), next);
+}
+
+// A chain of element-wise functions applied to an array is executed in a single pass without intermediate arrays.
+auto tryFoldPipeline(anka::Context &context, const std::vector<anka::Word> &words,
+                     const anka::Instruction *instructions, size_t end, const anka::Word &rhs,
+                     const std::optional<anka::Word> &owned) -> std::optional<std::pair<anka::Word, size_t>>
+{
+  using namespace anka;
+
+  if (context.assignNext)
+    return std::nullopt;
+
+  const auto arrayOpt = getFoldableWord(context, rhs);
+  if (!arrayOpt)
+    return std::nullopt;
+
+  const auto isOwned = owned == arrayOpt;
+  if (arrayOpt->type == WordType::IntegerArray)
+    return foldPipeline<int>(context, words, instructions, end, arrayOpt.value(), isOwned);
+  if (arrayOpt->type == WordType::DoubleArray)
+    return foldPipeline<double>(context, words, instructions, end, arrayOpt.value(), isOwned);
+
+  return std::nullopt;
+}
+
+// Internal functions return new values. A tuple connected to a function passes the owned array on to it, as long
+// as it holds the array once.
+auto getOwnedWord(const anka::Context &context, bool isCall, bool isBinding, const anka::Word &result,
+                  const std::optional<anka::Word> &owned) -> std::optional<anka::Word>
+{
+  using namespace anka;
+  if (isCall && getArrayItemType(result.type))
+    return result;
+
+  if (isBinding && owned && result.type == WordType::Tuple &&
+      std::ranges::count(context.tuples[result.index].words, owned.value()) == 1)
+    return owned;
+
+  return std::nullopt;
+}
+
+// Folds the words from right to left. Compiled words come with their instructions, last is folded as if it
+// followed the words.
+auto executeWords(anka::Context &context, const std::vector<anka::Word> &words, anka::Instruction *instructions,
+                  std::optional<anka::Word> last) -> std::optional<anka::Word>
+{
+  using namespace anka;
+
+  if (words.empty())
+    return last;
+
+  auto rhs = last.value_or(words.back());
+  auto end = last ? words.size() : words.size() - 1;
+
+  // array in rhs that nothing else references, the words themselves and the values of names are shared
+  std::optional<Word> owned;
+  while (end > 0)
+  {
+    if (auto fused = tryFoldPipeline(context, words, instructions, end, rhs, owned))
+    {
+      std::tie(rhs, end) = fused.value();
+      owned = rhs;
+      continue;
+    }
+
+    const auto &lhs = words[end - 1];
+    auto *instruction = instructions != nullptr ? &instructions[end - 1] : nullptr;
+    const auto isCall = !context.assignNext && lhs.type == WordType::Name &&
+                        (instruction != nullptr ? instruction->isInternalFunction : isInternalFunction(lhs.index));
+    const auto isBinding = !context.assignNext && lhs.type == WordType::Tuple;
+
+    rhs = fold(context, lhs, rhs, instruction, owned);
+    owned = getOwnedWord(context, isCall, isBinding, rhs, owned);
+    end -= 1;
+  }
 
-  return std::accumulate(rv.begin(), rv.end(), init,
-                         [&context](const Word &rhs, const Word &lhs) { return fold(context, lhs, rhs); });
+  return rhs;
+}
+
+auto getCompiledBlock(anka::Context &context, const anka::Word &word) -> std::shared_ptr<anka::CompiledWords>
+{
+  if (context.blocks.isInherited(word.index))
+  {
+    auto &compiled = context.inheritedBlocks[word.index];
+    if (!compiled)
+      compiled = std::make_shared<anka::CompiledWords>(anka::compile(context, context.blocks[word.index].words));
+    return compiled;
+  }
+
+  auto &block = context.blocks[word.index];
+  if (!block.compiled)
+    block.compiled = std::make_shared<anka::CompiledWords>(anka::compile(context, block.words));
+
+  // the caller keeps the compiled words alive, new blocks created while executing may move the block pool
+  return block.compiled;
 }
 
 namespace anka
 {
-export auto execute(Context &context, const std::vector<Sentence> &sentences) -> std::optional<Word>
+export auto compile(const Context &context, const std::vector<Sentence> &sentences) -> std::vector<CompiledWords>
+{
+  ProfileScope scope{ProfilePhase::Compile, "compile"};
+  std::vector<CompiledWords> compiled;
+  compiled.reserve(sentences.size());
+  for (const auto &sentence : sentences)
+  {
+    compiled.push_back(compile(context, sentence.words));
+  }
+  return compiled;
+}
+
+export auto execute(Context &context, std::vector<CompiledWords> &sentences) -> std::optional<Word>
 {
   if (sentences.empty())
     return std::nullopt;
 
+  // values created while executing a sentence only outlive it through user defined names or as the result
+  const auto mark = markContext(context);
+
   std::optional<Word> wordOpt = std::nullopt;
-  for (const auto &sentence : sentences)
+  for (auto &sentence : sentences)
   {
     if (sentence.words.empty())
       continue;
 
-    wordOpt = executeWords(context, sentence.words);
+    wordOpt = executeWords(context, sentence.words, sentence.instructions.data(), std::nullopt);
     if (wordOpt.has_value())
       wordOpt = getFoldableWord(context, wordOpt.value());
+
+    if (wordOpt.has_value())
+      releaseTemporaries(context, mark, std::span<Word>(&wordOpt.value(), 1));
+    else
+      releaseTemporaries(context, mark);
   }
 
   return wordOpt;
 }
-} // namespace anka
\ No newline at end of file
+
+export auto execute(Context &context, const std::vector<Sentence> &sentences) -> std::optional<Word>
+{
+  auto compiled = compile(context, sentences);
+  return execute(context, compiled);
+}
+} // namespace anka
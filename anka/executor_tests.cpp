@@ -2,6 +2,10 @@
 
 #include <doctest/doctest.h>
 
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
 #include <string_view>
 
 
@@ -153,4 +157,470 @@ TEST_CASE("binaryOptAlgorithms")
   CHECK_EQ(executeText("filter[odd] (1 2 3 4 5)"), "(1 3 5)");
   CHECK_EQ(executeText("filter |equals[3] _1| (3 2 -3 4 3)"), "(3 3)");
 }
+
+TEST_CASE("known reduction operators")
+{
+  CHECK_EQ(executeText("min[2] (1 3)"), "(1 2)");
+  CHECK_EQ(executeText("max[2.5] (1.0 3.0)"), "(2.5 3.0)");
+  CHECK_EQ(executeText("foldl[max] (3 7 2)"), "7");
+  CHECK_EQ(executeText("foldl[min] (3.5 1.5 2.0)"), "1.5");
+  CHECK_EQ(executeText("scanl[max] (1 3 2 5)"), "(1 3 3 5)");
+  CHECK_EQ(executeText("scanl[mul] (1 2 3 4)"), "(1 2 6 24)");
+  CHECK_EQ(executeText("foldl[max] ((1 5) (4 2 3))"), "(5 4)");
+
+  // large arrays are reduced and scanned chunk by chunk
+  CHECK_EQ(executeText("foldl[max] ioata 100000"), "100000");
+  CHECK_EQ(executeText("foldl[min] scanl[min] neg ioata 100000"), "-100000");
+  CHECK_EQ(executeText("foldl[add] to_long ioata 100000"), "5000050000");
+  CHECK_EQ(executeText("x: scanl[add] to_long ioata 100000\nfoldl[max] x"), "5000050000");
+}
+
+TEST_CASE("element-wise kernels")
+{
+  CHECK_EQ(executeText("sum add |_1 _1| ioata 300"), "90300");
+  CHECK_EQ(executeText("sum filter |greater_than[150] _1| ioata 300"), "33825");
+  CHECK_EQ(executeText("length filter[not] equals[(true false true) true]"), "1");
+  CHECK_EQ(executeText("sub [10 (1 2 3)]"), "(9 8 7)");
+  CHECK_EQ(executeText("mul [(1.0 2.0 3.0) 1.5]"), "(1.5 3.0 4.5)");
+}
+
+TEST_CASE("fused pipelines")
+{
+  CHECK_EQ(executeText("neg dec dec inc (10 11 12 13)"), "(-9 -10 -11 -12)");
+  CHECK_EQ(executeText("mul[2] inc (1 2 3)"), "(4 6 8)");
+  CHECK_EQ(executeText("sqrt mul[2.0] add[1] (1.0 7.0)"), "(2.0 4.0)");
+  CHECK_EQ(executeText("sum neg inc (1 2 3)"), "-9");
+  CHECK_EQ(executeText("inc2: {inc inc}\n inc2 dec dec (1 2)"), "(1 2)");
+}
+
+TEST_CASE("boolean arrays")
+{
+  CHECK_EQ(executeText("and[(true false true) (true true false)]"), "(true false false)");
+  CHECK_EQ(executeText("or[(true false false) false]"), "(true false false)");
+  CHECK_EQ(executeText("not (true false)"), "(false true)");
+  CHECK_EQ(executeText("count odd (1 2 3 5)"), "3");
+  CHECK_EQ(executeText("sort (true false true false)"), "(false false true true)");
+  CHECK_EQ(executeText("filter[not] (true false true false)"), "(false false)");
+  CHECK_EQ(executeText("foldl[and] (true true false)"), "false");
+  CHECK_EQ(executeText("length filter[odd] ioata 1000"), "500");
+  CHECK_EQ(executeText("count not odd ioata 1000"), "500");
+}
+
+TEST_CASE("large arrays")
+{
+  const auto prefix = std::string{"x: ioata 100000\nones: div[x x]\n"};
+  CHECK_EQ(executeText(prefix + "length filter[odd] x"), "50000");
+  CHECK_EQ(executeText(prefix + "positives: is_positive x\nlength filter[positives x]"), "100000");
+  CHECK_EQ(executeText(prefix + "y: scanl[add] ones\nall_of equals[x y]"), "true");
+  CHECK_EQ(executeText(prefix + "y: sort neg x\nz: sub[x 100001]\nall_of equals[y z]"), "true");
+  CHECK_EQ(executeText(prefix + "foldl[add] ones"), "100000");
+  CHECK_EQ(executeText(prefix + "any_of is_negative x"), "false");
+  CHECK_EQ(executeText(prefix + "count even x"), "50000");
+}
+
+TEST_CASE("compiled blocks")
+{
+  CHECK_EQ(executeText("inc2: {inc inc}\ninc2 5\ninc2 (1 2)\ninc2 1.5"), "3.5");
+  CHECK_EQ(executeText("avg: {div |{to_double sum} length|}\navg (1 2 3)\navg (1.0 2.0 6.0)"), "3.0");
+
+  anka::Context context;
+  const auto content = std::string_view{"inc2: {inc inc}\ninc2 5\ninc2 6"};
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+  CHECK_EQ(anka::toString(context, anka::execute(context, sentences).value()), "8");
+
+  const auto &block = context.blocks[anka::findUserDefinedName(context, "inc2").value().index];
+  REQUIRE(block.compiled);
+  CHECK(block.compiled->instructions[0].isInternalFunction);
+  CHECK_NE(block.compiled->instructions[0].callSite.executer, nullptr);
+}
+
+TEST_CASE("integer ranges")
+{
+  CHECK_EQ(executeText("mul[3] neg inc ioata 4"), executeText("mul[3] neg inc (1 2 3 4)"));
+  CHECK_EQ(executeText("sub[10] dec ioata 4"), executeText("sub[10] dec (1 2 3 4)"));
+  CHECK_EQ(executeText("sub[ioata 4 2]"), "(-1 0 1 2)");
+  CHECK_EQ(executeText("add[2] ioata 0"), "()");
+  CHECK_EQ(executeText("sum mul[2] ioata 1000"), "1001000");
+  CHECK_EQ(executeText("x: ioata 5\nsum filter[odd] x"), "9");
+  CHECK_EQ(executeText("x: ioata 3\nadd[x x]"), "(2 4 6)");
+
+  // sum and length have closed forms, so nothing is materialized
+  anka::Context context;
+  const auto content = std::string_view{"x: mul[2] inc ioata 10000\nl: length x\ns: sum x\nadd[l s]"};
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+  CHECK_EQ(anka::toString(context, anka::execute(context, sentences).value()), "100040000");
+  CHECK(context.integerArrays.empty());
+}
+
+TEST_CASE("owned arrays")
+{
+  // intermediate results are overwritten, values of names and literals are not
+  CHECK_EQ(executeText("sort filter[odd] inc mul[3] (5 2 4 1)"), "(7 13)");
+  CHECK_EQ(executeText("scanl[add] sort neg (3 1 2)"), "(-3 -5 -6)");
+  CHECK_EQ(executeText("filter[(true false true)] mul[2] (1 2 3)"), "(2 6)");
+  CHECK_EQ(executeText("sort not (true false true)"), "(false false true)");
+  CHECK_EQ(executeText("x: (3 1 2)\ny: sort x\nx"), "(3 1 2)");
+  CHECK_EQ(executeText("x: neg (3 1 2)\ny: inc sort x\nx"), "(-3 -1 -2)");
+  CHECK_EQ(executeText("|sort neg| mul[1] (3 1 2)"), "[(1 2 3) (-3 -1 -2)]");
+  CHECK_EQ(executeText("add |_1 _1| mul[1] (1 2 3)"), "(2 4 6)");
+  CHECK_EQ(executeText("f: {sort inc inc}\nx: (3 1 2)\ny: f x\nadd[y x]"), "(6 5 7)");
+  CHECK_EQ(executeText("f: {sort inc inc}\nx: (3 1 2)\ny: f x\nz: f x\nadd[y z]"), "(6 8 10)");
+  CHECK_EQ(executeText("length filter[even] ioata 100000"), "50000");
+  CHECK_EQ(executeText("sum sub[50000] filter[odd] mul[1] ioata 100000"), "0");
+}
+
+TEST_CASE("sorting")
+{
+  CHECK_EQ(executeText("sort (3 -1 2 -5)"), "(-5 -1 2 3)");
+  CHECK_EQ(executeText("sort (2.5 -1.0 0.0 -3.5)"), "(-3.5 -1.0 0.0 2.5)");
+  // large arrays are radix sorted, only the ascending order gives this sum
+  CHECK_EQ(executeText("x: sort neg ioata 300\ny: ioata 300\nsum mul[x y]"), "-4545100");
+
+  CHECK_EQ(executeText("grade (30 10 20 10)"), "(2 4 3 1)");
+  CHECK_EQ(executeText("grade (true false true)"), "(2 1 3)");
+
+  CHECK_EQ(executeText("top[2] (5 1 4 3)"), "(5 4)");
+  CHECK_EQ(executeText("bottom[2] (5 1 4 3)"), "(1 3)");
+  CHECK_EQ(executeText("top[10] (1.5 2.5)"), "(2.5 1.5)");
+  CHECK_EQ(executeText("top[0] (1 2)"), "()");
+  CHECK_EQ(executeText("top[2] (true false true)"), "(true true)");
+  CHECK_EQ(executeText("bottom[2] (true false true)"), "(false true)");
+  CHECK_EQ(executeText("top[3] mul[7] ioata 100000"), "(700000 699993 699986)");
+  CHECK_THROWS_AS(executeText("top[-1] (1 2)"), const anka::ExecutionError &);
+
+  CHECK_EQ(executeText("unique (3 1 3 2 1)"), "(3 1 2)");
+  CHECK_EQ(executeText("unique (false false)"), "(false)");
+  CHECK_EQ(executeText("length unique mul[0] ioata 1000"), "1");
+}
+
+TEST_CASE("dictionaries")
+{
+  CHECK_EQ(executeText("dict[(3 1 2) (30 10 20)]"), "(3: 30 1: 10 2: 20)");
+  CHECK_EQ(executeText("d: dict[(3 1 2) (1.5 2.5 3.5)]\nd (2 3 2)"), "(3.5 1.5 3.5)");
+  CHECK_EQ(executeText("d: dict[(3 1) (true false)]\nd 1"), "false");
+  CHECK_EQ(executeText("d: dict[(3 1) (30 10)]\nkeys d"), "(3 1)");
+  CHECK_EQ(executeText("d: dict[(3 1) (30 10)]\n|d inc| (1 3)"), "[(10 30) (2 4)]");
+  // every key of a large array is looked up in one pass
+  CHECK_EQ(executeText("k: ioata 100000\nn: neg k\nd: dict[k n]\nv: d k\nall_of equals[v n]"), "true");
+  CHECK_THROWS_AS(executeText("d: dict[(3 1) (30 10)]\nd 2"), const anka::ExecutionError &);
+  CHECK_THROWS_AS(executeText("dict[(1 1) (10 20)]"), const anka::ExecutionError &);
+  CHECK_THROWS_AS(executeText("dict[(1 2) (10 20 30)]"), const anka::ExecutionError &);
+
+  CHECK_EQ(executeText("count_by (5 3 5 5 1 3)"), "(5: 3 3: 2 1: 1)");
+  CHECK_EQ(executeText("group (5 3 5 5 1 3)"), "(1 2 1 1 3 2)");
+}
+
+TEST_CASE("nested arrays")
+{
+  CHECK_EQ(executeText("((1 2) (3))"), "((1 2) (3))");
+
+  const auto data = std::string{"data: ((1000 2000 3000) (4000) (5000 6000) (7000 8000 9000) (10000))\n"};
+  CHECK_EQ(executeText(data + "sum data"), "(6000 4000 11000 24000 10000)");
+  CHECK_EQ(executeText(data + "top[3] foldl[add] data"), "(24000 11000 10000)");
+  CHECK_EQ(executeText("sum ((1.5 2.5) (1.0))"), "(4.0 1.0)");
+
+  // other functions are called per row
+  CHECK_EQ(executeText(data + "length data"), "(3 1 2 3 1)");
+  CHECK_EQ(executeText("sort ((3 1 2) (5 4))"), "((1 2 3) (4 5))");
+  CHECK_EQ(executeText("top[1] ((3 1 2) (5 4))"), "((3) (5))");
+  CHECK_EQ(executeText("filter[odd] ((1 2 3) (4 6))"), "((1 3) ())");
+
+  // element-wise functions are called on the values and keep the rows
+  CHECK_EQ(executeText("inc ((1 2) (3))"), "((2 3) (4))");
+  CHECK_EQ(executeText("mul[2] ((1 2) (3))"), "((2 4) (6))");
+  CHECK_EQ(executeText("odd ((1 2) (3))"), "((true false) (true))");
+  CHECK_EQ(executeText("inc ((5))"), "((6))");
+  CHECK_EQ(executeText("n: ((1 2) (3))\nequals[n n]"), "((true true) (true))");
+  CHECK_THROWS_AS(executeText("n: ((1 2) (3))\nm: ((1) (2 3))\nequals[n m]"), const anka::ExecutionError &);
+
+  // boolean rows
+  CHECK_EQ(executeText("((true false) (true))"), "((true false) (true))");
+  CHECK_EQ(executeText("not ((true false) (true))"), "((false true) (false))");
+  CHECK_EQ(executeText("sort ((true false) (true))"), "((false true) (true))");
+  CHECK_EQ(executeText("count ((true false true) (false))"), "(2 0)");
+}
+
+TEST_CASE("storage kinds")
+{
+  // sums are accumulated in 64 bits
+  CHECK_EQ(executeText("sum ioata 100000"), "5000050000");
+  CHECK_EQ(executeText("sum (2000000000 2000000000)"), "4000000000");
+  CHECK_EQ(executeText("sum ((2000000000 2000000000) (1))"), "(4000000000 1)");
+  CHECK_EQ(executeText("foldl[add] (2000000000 2000000000)"), "4000000000");
+  CHECK_EQ(executeText("sum to_long ioata 100000"), "5000050000");
+  CHECK_EQ(executeText("sum to_uint8 (200 200 200)"), "600");
+  CHECK_EQ(executeText("sum to_float (0.5 1.25)"), "1.75");
+  CHECK_EQ(executeText("to_double sum to_long (1 2)"), "3.0");
+
+  // narrowing wraps around
+  CHECK_EQ(executeText("to_int8 (1 2 300 -129)"), "(1 2 44 127)");
+  CHECK_EQ(executeText("to_int (2.5 -1.5)"), "(2 -1)");
+  CHECK_EQ(executeText("length to_int16 (1 2 3)"), "3");
+
+  // elements of the storage kinds are widened, ints are taken as longs next to longs
+  CHECK_EQ(executeText("add[1] to_int8 (1 2 3)"), "(2 3 4)");
+  CHECK_EQ(executeText("neg to_float (0.5 1.5)"), "(-0.5 -1.5)");
+  CHECK_EQ(executeText("x: to_int16 (1 2 3)\nmul[x x]"), "(1 4 9)");
+  CHECK_EQ(executeText("x: to_long (1 2 3)\nadd[x 1]"), "(2 3 4)");
+  CHECK_EQ(executeText("x: to_long 65536\nmul[x] 65536"), "4294967296");
+
+  // sorting keeps the kind
+  CHECK_EQ(executeText("sort to_long (3 -1 2)"), "(-1 2 3)");
+  CHECK_EQ(executeText("bottom[3] sort neg to_long ioata 300"), "(-300 -299 -298)");
+  CHECK_EQ(executeText("grade to_float (0.5 -1.5 2.0)"), "(2 1 3)");
+  CHECK_EQ(executeText("top[2] to_int8 (5 -3 7 1)"), "(7 5)");
+  CHECK_EQ(executeText("bottom[2] to_uint8 (200 3 100)"), "(3 100)");
+  CHECK_EQ(executeText("unique to_int16 (3 1 3 2 1)"), "(3 1 2)");
+}
+
+TEST_CASE("concurrent executor branches")
+{
+  // inputs this large run the branches of an executor on the thread pool
+  CHECK_EQ(executeText("|sum length| ioata 20000"), "[200010000 20000]");
+  CHECK_EQ(executeText("dbl: {mul[2]}\nx: ioata 10000\n|{sum dbl} {top[2]} {sum filter[odd]}| x"),
+           "[100010000 (10000 9999) 25000000]");
+  CHECK_EQ(executeText("|{sum neg} {sum sort neg}| ioata 5000"), "[-12502500 -12502500]");
+  CHECK_EQ(executeText("|sum length| ((1 2 3) (4 5 6 7))"), "[(6 22) (3 4)]");
+  CHECK_THROWS_AS(executeText("|sum {equals}| ioata 10000"), const anka::ExecutionError &);
+
+  // the shorter array is created by the branch, the error refers to it in the context
+  anka::Context context;
+  const auto content = std::string_view{"|sum {add[(1 2 3)] top[2]}| ioata 10000"};
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+  try
+  {
+    anka::execute(context, sentences);
+    FAIL("expected an array size mismatch");
+  }
+  catch (const anka::ExecutionError &err)
+  {
+    CHECK_EQ(err.msg, "Array size mismatch");
+    REQUIRE(err.word1.has_value());
+    CHECK_EQ(anka::toString(context, err.word1.value()), "(10000 9999)");
+  }
+}
+
+TEST_CASE("memoization")
+{
+  anka::Context context;
+  anka::setMemoCapacity(context, 2);
+  const auto content =
+      std::string_view{"avg: {div |{to_double sum} length|}\nx: (1.0 2.0 6.0)\navg x\navg (1.0 2.0 6.0)"};
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+
+  auto res = anka::execute(context, sentences);
+  REQUIRE(res.has_value());
+  CHECK_EQ(anka::toString(context, res.value()), "3.0");
+
+  // the least recently used entry of the inner block was dropped, the entries outlive the temporaries
+  REQUIRE_EQ(context.memo.entries.size(), 2);
+  for (const auto &entry : context.memo.entries)
+    CHECK_EQ(anka::toString(context, entry.argument), "(1.0 2.0 6.0)");
+  CHECK_EQ(res.value(), context.memo.entries.front().result);
+
+  anka::setMemoCapacity(context, 0);
+  CHECK(context.memo.entries.empty());
+}
+
+TEST_CASE("profiler")
+{
+  anka::startProfiling(true);
+  CHECK_EQ(executeText("sq: {mul[_1 _1]}\nsum sq ioata 10"), "385");
+  anka::stopProfiling();
+
+  const auto report = anka::getProfileReport();
+  CHECK_NE(report.find("builtin"), std::string::npos);
+  CHECK_NE(report.find("sq"), std::string::npos);
+  CHECK_NE(report.find("integerArrays"), std::string::npos);
+  CHECK_NE(anka::getChromeTrace().find("\"cat\": \"dispatch\""), std::string::npos);
+
+  // nothing is recorded while profiling is off
+  executeText("sum ioata 10");
+  CHECK_EQ(anka::getProfileReport(), report);
+
+  anka::Context context;
+  anka::createWord(context, std::vector<int>{1, 2, 3});
+  CHECK_NE(anka::getMemoryReport(context).find("integerArrays"), std::string::npos);
+}
+
+TEST_CASE("temporaries are released")
+{
+  anka::Context context;
+  const auto content = std::string_view{"inc2: {inc inc}\nval: inc2 (1 2 3)\nsum dec inc2 val"};
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+  const auto mark = anka::markContext(context);
+
+  auto res = anka::execute(context, sentences);
+  REQUIRE(res.has_value());
+  CHECK_EQ(anka::toString(context, res.value()), "15");
+  CHECK_EQ(context.integerArrays.size(), mark.integerArrays + 1);
+  CHECK_EQ(anka::toString(context, anka::findUserDefinedName(context, "val").value()), "(3 4 5)");
+}
+
+TEST_CASE("repeated execution keeps the context flat")
+{
+  anka::Context context;
+  const auto content = std::string_view{"sum mul[_1 _1] ioata inc 4"};
+  const auto nameCount = context.names.size();
+  for (auto i = 0; i < 100; ++i)
+  {
+    const auto mark = anka::markContext(context);
+    auto tokens = anka::extractTokens(content);
+    auto sentences = anka::parse(content, tokens, context);
+    CHECK_EQ(anka::toString(context, anka::execute(context, sentences).value()), "55");
+    anka::releaseTemporaries(context, mark);
+  }
+
+  CHECK(context.integerNumbers.empty());
+  CHECK(context.integerArrays.empty());
+  CHECK(context.tuples.empty());
+  CHECK_EQ(context.names.size(), nameCount);
+}
+TEST_CASE("array files")
+{
+  anka::Context context;
+  const auto content = std::string_view{"ints: ioata 100\ndoubles: to_double ints\nbools: even ints\n"
+                                        "longs: to_long ints\nfloats: to_float doubles\nbytes: to_uint8 ints"};
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+  anka::execute(context, sentences);
+
+  const auto directory = std::filesystem::temp_directory_path();
+  for (const auto name : {"ints", "doubles", "bools", "longs", "floats", "bytes"})
+  {
+    const auto path = directory / std::format("anka_array_files_{}.npy", name);
+    const auto word = anka::findUserDefinedName(context, name).value();
+    anka::saveArray(context, word, path);
+    const auto loaded = anka::loadArray(context, path);
+    std::filesystem::remove(path);
+
+    CHECK_EQ(loaded.type, word.type);
+    CHECK_EQ(anka::toString(context, loaded), anka::toString(context, word));
+  }
+
+  CHECK_THROWS_AS(anka::loadArray(context, directory / "anka_array_files_missing.npy"), const anka::ExecutionError &);
+  CHECK_THROWS_AS(anka::saveArray(context, anka::Word{anka::WordType::IntegerNumber, 0}, directory / "x.npy"),
+                  const anka::ExecutionError &);
+}
+
+TEST_CASE("context images")
+{
+  anka::Context context;
+  anka::injectInternalConstants(context);
+  const auto content = std::string_view{"avg: {div |{to_double sum} length|}\nxs: (3 1 2)\nd: dict[(1 2) (0.5 1.5)]\n"
+                                        "rows: ((1 2) (3))\nbits: odd rows\nflags: even ioata 70\nr: ioata 5\n"
+                                        "sq: {mul[_1 _1]}"};
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+  anka::execute(context, sentences);
+
+  const auto path = std::filesystem::temp_directory_path() / "anka_context_image.bin";
+  anka::saveContextImage(context, path);
+  auto loaded = anka::loadContextImage(path);
+  std::filesystem::remove(path);
+
+  const auto run = [&loaded](const std::string_view text) {
+    auto tokens = anka::extractTokens(text);
+    auto sentences = anka::parse(text, tokens, loaded);
+    return anka::toString(loaded, anka::execute(loaded, sentences).value());
+  };
+  CHECK_EQ(run("avg xs"), "2.0");
+  CHECK_EQ(run("d (2 1)"), "(1.5 0.5)");
+  CHECK_EQ(run("sum rows"), "(3 3)");
+  CHECK_EQ(run("bits"), "((true false) (true))");
+  CHECK_EQ(run("length filter[flags] ioata 70"), "35");
+  CHECK_EQ(run("sum sq r"), "55");
+  CHECK_EQ(run("mul[pi] 1.0"), run("pi"));
+  CHECK_EQ(loaded.names, context.names);
+
+  const auto broken = std::filesystem::temp_directory_path() / "anka_context_image_broken.bin";
+  std::ofstream(broken, std::ios::binary) << "ANKAIMG\n\x01";
+  CHECK_THROWS_AS(anka::loadContextImage(broken), const anka::ExecutionError &);
+  std::filesystem::remove(broken);
+}
+
+TEST_CASE("batches")
+{
+  const auto directory = std::filesystem::temp_directory_path() / "anka_batch";
+  std::filesystem::create_directories(directory);
+
+  std::vector<std::string> scripts;
+  for (int i = 0; i < 40; ++i)
+  {
+    const auto path = (directory / std::format("script_{:02}.anka", i)).string();
+    std::ofstream(path) << std::format("x: ioata {}\nsum x", (i + 1) * 1000);
+    scripts.push_back(path);
+  }
+  const auto failing = (directory / "script_40.anka").string();
+  std::ofstream(failing) << "avg: {div |{to_double sum} length|}\navg ioata (1 2 3)";
+  scripts.push_back(failing);
+  std::ofstream(directory / "notes.txt") << "sum ioata 10";
+
+  CHECK_EQ(anka::getBatchScripts(directory.string()), scripts);
+
+  const auto list = std::filesystem::temp_directory_path() / "anka_batch_list.txt";
+  std::ofstream(list) << scripts[2] << "\n\n" << scripts[1] << "\n";
+  CHECK_EQ(anka::getBatchScripts(list.string()), std::vector<std::string>{scripts[2], scripts[1]});
+
+  scripts.push_back((directory / "missing.anka").string());
+  const auto results = anka::runBatch(scripts, 0);
+  REQUIRE_EQ(results.size(), scripts.size());
+  for (int i = 0; i < 40; ++i)
+  {
+    const auto n = (i + 1) * 1000;
+    CHECK(results[i].success);
+    CHECK_EQ(results[i].path, scripts[i]);
+    CHECK_EQ(results[i].output, std::format("{}\n", n * (n + 1) / 2));
+    CHECK(results[i].errors.empty());
+  }
+  CHECK_FALSE(results[40].success);
+  CHECK_FALSE(results[40].errors.empty());
+  CHECK_FALSE(results[41].success);
+  CHECK_NE(results[41].errors.find("could not open the file"), std::string::npos);
+
+  std::filesystem::remove_all(directory);
+  std::filesystem::remove(list);
+}
+
+auto executeStream(const std::string_view content, const std::vector<std::vector<int>> &chunks) -> std::string
+{
+  anka::Context context;
+  auto tokens = anka::extractTokens(content);
+  auto sentences = anka::parse(content, tokens, context);
+
+  anka::StreamExecution stream(context, sentences, "x");
+  std::ostringstream output;
+  for (auto chunk : chunks)
+  {
+    stream.executeChunk(anka::createWord(context, std::move(chunk)), output);
+  }
+
+  if (auto resultOpt = stream.getResult())
+    return anka::toString(context, resultOpt.value());
+  return output.str();
+}
+
+TEST_CASE("streaming")
+{
+  const auto chunks = std::vector<std::vector<int>>{{1, -2, 3}, {-4, 5}, {6}};
+  CHECK_EQ(executeStream("sum filter[is_positive] x", chunks), "15");
+  CHECK_EQ(executeStream("length x", chunks), "6");
+  CHECK_EQ(executeStream("foldl[mul] x", chunks), "720");
+  CHECK_EQ(executeStream("any_of is_positive x", chunks), "true");
+  CHECK_EQ(executeStream("all_of is_positive x", chunks), "false");
+  CHECK_EQ(executeStream("y: 10\nadd[y] x", chunks), "11\n8\n13\n6\n15\n16\n");
+  CHECK_THROWS_AS(executeStream("inc sum x", chunks), const anka::ExecutionError &);
+
+  // reductions merge only over element-wise functions and filters of the input
+  CHECK_EQ(executeStream("sum mul[2] filter[is_positive] x", chunks), "30");
+  CHECK_THROWS_AS(executeStream("length unique x", chunks), const anka::ExecutionError &);
+  CHECK_THROWS_AS(executeStream("sum top[3] x", chunks), const anka::ExecutionError &);
+  CHECK_THROWS_AS(executeStream("count is_positive sort x", chunks), const anka::ExecutionError &);
+}
+
 #endif
\ No newline at end of file
@@ -1,9 +1,14 @@
 module;
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <numbers>
 #include <numeric>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -22,6 +27,11 @@ export module anka:internal_functions;
 import :errors;
 import :type_system;
 import :interpreter_state;
+import :bit_array;
+import :thread_pool;
+import :sorting;
+import :dictionary;
+import :nested_array;
 
 namespace anka
 {
@@ -29,6 +39,148 @@ namespace anka
 template <typename R, typename T> using BinaryOpt = R (*)(T, T);
 template <typename T> using FilterFunc = bool (*)(T);
 
+// Reduces large arrays chunk by chunk on the thread pool, the chunk results are combined in order.
+template <typename R, typename ChunkFunc, typename CombineFunc>
+auto reduceChunks(size_t size, ChunkFunc chunkFunc, CombineFunc combine) -> R
+{
+  const auto chunkCount = getChunkCount(size);
+  auto partials = std::make_unique<R[]>(chunkCount);
+  parallelFor(size, [&](size_t begin, size_t end) { partials[begin / parallelChunkSize] = chunkFunc(begin, end); });
+
+  return std::accumulate(partials.get() + 1, partials.get() + chunkCount, partials[0], combine);
+}
+
+auto toBlock(bool value) -> BitArray::Block
+{
+  return value ? ~BitArray::Block{0} : BitArray::Block{0};
+}
+
+// Writes func(i) for i in [0, count) to the bits of consecutive blocks.
+template <typename Func> auto packBits(BitArray::Block *out, size_t count, Func func) -> void
+{
+  for (size_t begin = 0; begin < count; begin += BitArray::bitsPerBlock)
+  {
+    const auto blockSize = std::min(BitArray::bitsPerBlock, count - begin);
+    BitArray::Block block = 0;
+    for (size_t i = 0; i < blockSize; ++i)
+      block |= static_cast<BitArray::Block>(func(begin + i)) << i;
+    out[begin / BitArray::bitsPerBlock] = block;
+  }
+}
+
+// Number of set bits in the blocks covering [begin, end), begin is a multiple of the block size.
+auto countBits(std::span<const BitArray::Block> blocks, size_t begin, size_t end) -> size_t
+{
+  size_t res = 0;
+  for (auto blockIndex = begin / BitArray::bitsPerBlock; blockIndex < BitArray::getBlockCount(end); ++blockIndex)
+  {
+    res += std::popcount(blocks[blockIndex]);
+  }
+  return res;
+}
+
+// Copies the values in [begin, end) whose bit is set to out, begin is a multiple of the block size.
+template <typename T>
+auto compactRange(std::span<const BitArray::Block> blocks, const std::vector<T> &vec, size_t begin, size_t end, T *out)
+    -> void
+{
+  for (auto blockIndex = begin / BitArray::bitsPerBlock; blockIndex < BitArray::getBlockCount(end); ++blockIndex)
+  {
+    auto block = blocks[blockIndex];
+    const auto offset = blockIndex * BitArray::bitsPerBlock;
+    if (block == ~BitArray::Block{0})
+    {
+      // out is never after the values, it is at them when compacting in place
+      if (out != vec.data() + offset)
+        std::copy_n(vec.data() + offset, BitArray::bitsPerBlock, out);
+      out += BitArray::bitsPerBlock;
+      continue;
+    }
+
+    for (; block != 0; block &= block - 1)
+    {
+      *out++ = vec[offset + std::countr_zero(block)];
+    }
+  }
+}
+
+// Keeps the values whose bit is set in the mask. Large arrays are compacted chunk by chunk on the thread pool,
+// the chunk offsets are known up front from the popcounts.
+template <typename T> auto compact(const BitArray &mask, const std::vector<T> &vec) -> std::vector<T>
+{
+  const auto blocks = mask.blocks();
+  if (vec.size() < parallelThreshold)
+  {
+    std::vector<T> ret(mask.count());
+    compactRange(blocks, vec, 0, vec.size(), ret.data());
+    return ret;
+  }
+
+  const auto chunkCount = getChunkCount(vec.size());
+  std::vector<size_t> offsets(chunkCount + 1, 0);
+  for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+  {
+    offsets[chunk + 1] = offsets[chunk] + countBits(blocks, getChunkBegin(chunk), getChunkEnd(chunk, vec.size()));
+  }
+
+  std::vector<T> ret(offsets.back());
+  parallelFor(vec.size(), [&](size_t begin, size_t end) {
+    compactRange(blocks, vec, begin, end, ret.data() + offsets[begin / parallelChunkSize]);
+  });
+  return ret;
+}
+
+auto compact(const BitArray &mask, const BitArray &vec) -> BitArray
+{
+  BitArray ret;
+  ret.reserve(mask.count());
+
+  const auto blocks = mask.blocks();
+  for (size_t blockIndex = 0; blockIndex < blocks.size(); ++blockIndex)
+  {
+    for (auto block = blocks[blockIndex]; block != 0; block &= block - 1)
+    {
+      ret.push_back(vec[blockIndex * BitArray::bitsPerBlock + std::countr_zero(block)]);
+    }
+  }
+  return ret;
+}
+
+// Same as compact, but keeps the values in the storage of vec. Large arrays are compacted chunk by chunk to the
+// start of their chunk on the thread pool, then the chunks are moved down in order.
+template <typename T> auto compactInPlace(const BitArray &mask, std::vector<T> &vec) -> void
+{
+  const auto blocks = mask.blocks();
+  if (vec.size() < parallelThreshold)
+  {
+    compactRange(blocks, vec, 0, vec.size(), vec.data());
+    vec.resize(mask.count());
+    return;
+  }
+
+  const auto chunkCount = getChunkCount(vec.size());
+  std::vector<size_t> counts(chunkCount);
+  parallelFor(vec.size(), [&](size_t begin, size_t end) {
+    counts[begin / parallelChunkSize] = countBits(blocks, begin, end);
+    compactRange(blocks, vec, begin, end, vec.data() + begin);
+  });
+
+  size_t size = 0;
+  for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+  {
+    const auto begin = getChunkBegin(chunk);
+    if (size != begin)
+      std::copy_n(vec.begin() + begin, counts[chunk], vec.begin() + size);
+    size += counts[chunk];
+  }
+  vec.resize(size);
+}
+
+auto compactInPlace(const BitArray &mask, BitArray &vec) -> void
+{
+  vec = compact(mask, vec);
+}
+
 auto ioata(int n) -> std::vector<int>
 {
   std::vector<int> res;
@@ -82,15 +234,115 @@ template <typename T> auto abs(T n) -> T
   return std::abs(n);
 }
 
-template <typename T> auto length(const std::vector<T> &vec) -> int
+template <typename T> auto length(const Array<T> &vec) -> int
 {
   return static_cast<int>(vec.size());
 }
 
-template <typename T> auto sort(const std::vector<T> &vec) -> std::vector<T>
+template <typename T> auto sortInPlace(Array<T> &vec) -> void
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    // all false values come first, only their count is needed
+    const auto falseCount = vec.size() - vec.count();
+    auto blocks = vec.blocks();
+    std::fill_n(blocks.begin(), falseCount / BitArray::bitsPerBlock, BitArray::Block{0});
+    std::fill(blocks.begin() + falseCount / BitArray::bitsPerBlock, blocks.end(), ~BitArray::Block{0});
+    if (falseCount % BitArray::bitsPerBlock != 0)
+      blocks[falseCount / BitArray::bitsPerBlock] &= ~BitArray::Block{0} << (falseCount % BitArray::bitsPerBlock);
+    vec.clearTail();
+  }
+  else
+  {
+    sortValues(vec);
+  }
+}
+
+template <typename T> auto sort(const Array<T> &vec) -> Array<T>
+{
+  auto res = vec;
+  sortInPlace<T>(res);
+  return res;
+}
+
+// Positions of the values in ascending order, they start at 1 like ioata. Equal values keep their order.
+template <typename T> auto grade(const Array<T> &vec) -> std::vector<int>
+{
+  std::vector<int> res;
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    res.reserve(vec.size());
+    for (auto value : {false, true})
+    {
+      for (size_t i = 0; i < vec.size(); ++i)
+      {
+        if (vec[i] == value)
+          res.push_back(static_cast<int>(i));
+      }
+    }
+  }
+  else
+  {
+    res = gradeValues(vec);
+  }
+
+  for (auto &index : res)
+  {
+    ++index;
+  }
+  return res;
+}
+
+auto checkSelectionCount(int count) -> size_t
+{
+  if (count < 0)
+    throw ExecutionError{std::nullopt, std::nullopt, "Top and bottom expect a count that is not negative."};
+  return static_cast<size_t>(count);
+}
+
+template <typename T> auto selectInPlace(int count, Array<T> &vec, bool largest) -> void
+{
+  const auto size = std::min(checkSelectionCount(count), vec.size());
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    // the selected values are the trues or the falses, followed by the others
+    const auto trueCount = vec.count();
+    const auto firstCount = std::min(size, largest ? trueCount : vec.size() - trueCount);
+    vec = BitArray(size, !largest);
+    for (size_t i = 0; i < firstCount; ++i)
+    {
+      vec.set(i, largest);
+    }
+  }
+  else
+  {
+    selectValues(vec, size, largest);
+  }
+}
+
+// The count largest values in descending order.
+template <typename T> auto topInPlace(int count, Array<T> &vec) -> void
+{
+  selectInPlace<T>(count, vec, true);
+}
+
+template <typename T> auto top(int count, const Array<T> &vec) -> Array<T>
+{
+  auto res = vec;
+  topInPlace<T>(count, res);
+  return res;
+}
+
+// The count smallest values in ascending order.
+template <typename T> auto bottomInPlace(int count, Array<T> &vec) -> void
+{
+  selectInPlace<T>(count, vec, false);
+}
+
+template <typename T> auto bottom(int count, const Array<T> &vec) -> Array<T>
 {
   auto res = vec;
-  std::sort(res.begin(), res.end());
+  bottomInPlace<T>(count, res);
   return res;
 }
 
@@ -113,6 +365,16 @@ template <typename T> auto div(T v1, T v2) -> T
   return v1 / v2;
 }
 
+template <typename T> auto minimum(T v1, T v2) -> T
+{
+  return v2 < v1 ? v2 : v1;
+}
+
+template <typename T> auto maximum(T v1, T v2) -> T
+{
+  return v1 < v2 ? v2 : v1;
+}
+
 auto andFun(bool b1, bool b2) -> bool
 {
   return b1 and b2;
@@ -148,173 +410,612 @@ template <typename T> auto lessThan(T v1, T v2) -> bool
   return v2 < v1;
 }
 
-template <typename T> auto sum(const std::vector<T> &vec) -> T
+// Associative functions that foldl and scanl recognise. Their kernels call the operator directly instead of through
+// the function pointer, so the loops can be vectorised.
+enum class KnownOperator
 {
-  return std::accumulate(vec.begin(), vec.end(), (T)0);
-}
+  None,
+  Add,
+  Mul,
+  Min,
+  Max
+};
 
-auto all_of(const std::vector<bool> &vec) -> bool
+template <typename T> auto findKnownOperator(anka::BinaryOpt<T, T> func) -> KnownOperator
 {
-  return std::all_of(vec.begin(), vec.end(), std::identity());
+  if (func == &anka::add<T>)
+    return KnownOperator::Add;
+  if (func == &anka::mul<T>)
+    return KnownOperator::Mul;
+  if (func == &anka::minimum<T>)
+    return KnownOperator::Min;
+  if (func == &anka::maximum<T>)
+    return KnownOperator::Max;
+  return KnownOperator::None;
 }
 
-auto any_of(const std::vector<bool> &vec) -> bool
+template <KnownOperator Op, typename T> auto applyOperator(T lhs, T rhs) -> T
 {
-  return std::any_of(vec.begin(), vec.end(), std::identity());
+  if constexpr (Op == KnownOperator::Add)
+    return lhs + rhs;
+  else if constexpr (Op == KnownOperator::Mul)
+    return lhs * rhs;
+  else if constexpr (Op == KnownOperator::Min)
+    return minimum(lhs, rhs);
+  else
+    return maximum(lhs, rhs);
 }
 
-auto none_of(const std::vector<bool> &vec) -> bool
+template <typename T> auto applyOperator(KnownOperator op, T lhs, T rhs) -> T
 {
-  return std::none_of(vec.begin(), vec.end(), std::identity());
+  switch (op)
+  {
+  case KnownOperator::Add:
+    return applyOperator<KnownOperator::Add>(lhs, rhs);
+  case KnownOperator::Mul:
+    return applyOperator<KnownOperator::Mul>(lhs, rhs);
+  case KnownOperator::Min:
+    return applyOperator<KnownOperator::Min>(lhs, rhs);
+  default:
+    return applyOperator<KnownOperator::Max>(lhs, rhs);
+  }
 }
 
-template <typename T> auto to_double(T val) -> double
-{
-  return val;
-}
+// Independent accumulators, so that consecutive elements do not wait for each other's result.
+constexpr size_t accumulatorCount = 8;
 
-template <typename T, typename R> auto foldl(anka::BinaryOpt<T, R> func, const std::vector<T> &vec) -> R
+// Reduces count > 0 values, the values are converted to R first.
+template <KnownOperator Op, typename R, typename T> auto reduceBlock(const T *values, size_t count) -> R
 {
-  if (vec.empty())
-    return (R)0;
-  return std::accumulate(vec.begin() + 1, vec.end(), vec.front(), func);
-}
+  if (count < accumulatorCount)
+  {
+    auto res = static_cast<R>(values[0]);
+    for (size_t i = 1; i < count; ++i)
+      res = applyOperator<Op>(res, static_cast<R>(values[i]));
+    return res;
+  }
 
-template <typename T, typename R> auto scanl(anka::BinaryOpt<T, R> func, const std::vector<T> &vec) -> std::vector<R>
-{
-  if (vec.empty())
-    return vec;
-  std::vector<R> res;
-  res.resize(vec.size());
-  std::partial_sum(vec.begin(), vec.end(), res.begin(), func);
+  std::array<R, accumulatorCount> accumulators;
+  for (size_t k = 0; k < accumulatorCount; ++k)
+    accumulators[k] = static_cast<R>(values[k]);
+
+  auto i = accumulatorCount;
+  for (; i + accumulatorCount <= count; i += accumulatorCount)
+  {
+    for (size_t k = 0; k < accumulatorCount; ++k)
+      accumulators[k] = applyOperator<Op>(accumulators[k], static_cast<R>(values[i + k]));
+  }
+  for (; i < count; ++i)
+    accumulators[0] = applyOperator<Op>(accumulators[0], static_cast<R>(values[i]));
+
+  auto res = accumulators[0];
+  for (size_t k = 1; k < accumulatorCount; ++k)
+    res = applyOperator<Op>(res, accumulators[k]);
   return res;
 }
 
-template <typename T, typename FuncType> auto filter(FuncType func, const std::vector<T> &vec) -> std::vector<T>
+// Doubles are summed pairwise, the rounding error grows with the logarithm of the count instead of the count.
+constexpr size_t pairwiseBlockSize = 256;
+
+template <typename R, typename T> auto pairwiseSum(const T *values, size_t count) -> R
 {
-  std::vector<T> ret;
-  if (vec.empty())
-    return ret;
+  if (count <= pairwiseBlockSize)
+    return reduceBlock<KnownOperator::Add, R>(values, count);
 
-  std::copy_if(vec.begin(), vec.end(), std::back_inserter(ret), func);
+  const auto half = count / 2;
+  return pairwiseSum<R>(values, half) + pairwiseSum<R>(values + half, count - half);
+}
 
-  return ret;
+template <typename R, typename T> auto reduceRange(KnownOperator op, const T *values, size_t count) -> R
+{
+  switch (op)
+  {
+  case KnownOperator::Add:
+    if constexpr (std::is_floating_point_v<R>)
+      return pairwiseSum<R>(values, count);
+    else
+      return reduceBlock<KnownOperator::Add, R>(values, count);
+  case KnownOperator::Mul:
+    return reduceBlock<KnownOperator::Mul, R>(values, count);
+  case KnownOperator::Min:
+    return reduceBlock<KnownOperator::Min, R>(values, count);
+  default:
+    return reduceBlock<KnownOperator::Max, R>(values, count);
+  }
 }
 
-template <typename T>
-auto filterWithVec(const std::vector<bool> &filterResults, const std::vector<T> &vec) -> std::vector<T>
+// Reduces values.size() > 0 values with a known operator, large arrays chunk by chunk on the thread pool.
+template <typename R, typename T> auto reduceValues(KnownOperator op, std::span<const T> values) -> R
 {
-  if (filterResults.size() != vec.size())
-    throw ExecutionError{std::nullopt, std::nullopt, "Filter expects given arrays to have the same size."};
+  if (values.size() < parallelThreshold)
+    return reduceRange<R>(op, values.data(), values.size());
 
-  auto i = 0;
-  auto filterFunc = [&filterResults, &i](T) { return filterResults[i++]; };
-  return filter<T>(filterFunc, vec);
+  return reduceChunks<R>(
+      values.size(),
+      [op, values](size_t begin, size_t end) { return reduceRange<R>(op, values.data() + begin, end - begin); },
+      [op](R lhs, R rhs) { return applyOperator(op, lhs, rhs); });
 }
 
-export using InternalFunctionExecuter = std::function<std::optional<anka::Word>(
-    anka::Context &, const std::vector<anka::Word> &, const std::vector<bool> &expandArray)>;
-
-export struct InternalFunctionDefinition
+// Running results of count > 0 values. The running sum of doubles is compensated (Kahan), the error of the
+// additions is carried to the next one.
+template <KnownOperator Op, typename T> auto scanBlock(const T *values, T *res, size_t count) -> void
 {
-  std::string name;
-  TypeList argumentTypes;
-  TypeVariant returnType;
-  void *funcPtr = nullptr;
-};
+  auto acc = values[0];
+  res[0] = acc;
+  if constexpr (Op == KnownOperator::Add && std::is_floating_point_v<T>)
+  {
+    T compensation = 0;
+    for (size_t i = 1; i < count; ++i)
+    {
+      const auto value = values[i] - compensation;
+      const auto next = acc + value;
+      compensation = (next - acc) - value;
+      acc = next;
+      res[i] = acc;
+    }
+  }
+  else
+  {
+    for (size_t i = 1; i < count; ++i)
+    {
+      acc = applyOperator<Op>(acc, values[i]);
+      res[i] = acc;
+    }
+  }
+}
 
-export struct InternalFunctionDefinitionHash
+// Writes the running results of vec to res, which has the size of vec and can be vec itself.
+template <KnownOperator Op, typename T> auto scanChunks(const std::vector<T> &vec, std::vector<T> &res) -> void
 {
-  inline size_t operator()(const InternalFunctionDefinition &k) const
+  if (vec.size() < parallelThreshold)
   {
-    return std::hash<std::string>()(k.name) ^ anka::hash(k.argumentTypes);
+    scanBlock<Op>(vec.data(), res.data(), vec.size());
+    return;
   }
-};
 
-export struct InternalFunctionDefinitionEqual
-{
-  inline bool operator()(const InternalFunctionDefinition &k1, const InternalFunctionDefinition &k2) const
+  // scan every chunk on its own, then combine the total of the preceding chunks with each one
+  parallelFor(vec.size(),
+              [&](size_t begin, size_t end) { scanBlock<Op>(vec.data() + begin, res.data() + begin, end - begin); });
+
+  const auto chunkCount = getChunkCount(vec.size());
+  auto carries = std::make_unique<T[]>(chunkCount);
+  carries[0] = res[getChunkEnd(0, vec.size()) - 1];
+  for (size_t chunk = 1; chunk < chunkCount; ++chunk)
   {
-    return (k1.name == k2.name) && (k1.argumentTypes == k2.argumentTypes);
+    carries[chunk] = applyOperator<Op>(carries[chunk - 1], res[getChunkEnd(chunk, vec.size()) - 1]);
   }
-};
 
-export using InternalFunctionMaptype =
-    std::unordered_map<InternalFunctionDefinition, InternalFunctionExecuter, InternalFunctionDefinitionHash,
-                       InternalFunctionDefinitionEqual>;
+  parallelFor(vec.size(), [&](size_t begin, size_t end) {
+    const auto chunk = begin / parallelChunkSize;
+    if (chunk == 0)
+      return;
 
-auto getInternalFunctions() -> const InternalFunctionMaptype &;
+    const T carry = carries[chunk - 1];
+    for (auto i = begin; i < end; ++i)
+    {
+      res[i] = applyOperator<Op>(carry, res[i]);
+    }
+  });
+}
 
-export auto getAllInternalFunctionDefinitions() -> std::vector<InternalFunctionDefinition>
+// Running results of vec.size() > 0 values with a known operator.
+template <typename T> auto scanValues(KnownOperator op, const std::vector<T> &vec, std::vector<T> &res) -> void
 {
-  const auto &internalFunctions = anka::getInternalFunctions();
-  auto kv = ranges::views::keys(internalFunctions);
-  std::vector<anka::InternalFunctionDefinition> definitions{kv.begin(), kv.end()};
-  return definitions;
+  switch (op)
+  {
+  case KnownOperator::Add:
+    return scanChunks<KnownOperator::Add>(vec, res);
+  case KnownOperator::Mul:
+    return scanChunks<KnownOperator::Mul>(vec, res);
+  case KnownOperator::Min:
+    return scanChunks<KnownOperator::Min>(vec, res);
+  default:
+    return scanChunks<KnownOperator::Max>(vec, res);
+  }
 }
 
-template <typename T>
-auto getInternalFunctionDefinition(const std::string &name) -> std::optional<InternalFunctionDefinition>
+// The sum is accumulated in R, the sums of ints and of the storage kinds are widened so that they do not overflow.
+template <typename T, typename R = T> auto sum(const std::vector<T> &vec) -> R
 {
-  const auto &internalFunctions = anka::getInternalFunctions();
-  auto type = anka::getType<T>();
-  auto funcType = std::get<anka::FunctionType>(type);
-  const auto arguments = std::vector<TypeVariant>(funcType.arguments.begin(), funcType.arguments.end());
-  const auto definition = anka::InternalFunctionDefinition{name, arguments, funcType.returnType, nullptr};
-  auto iter = internalFunctions.find(definition);
+  if (vec.empty())
+    return (R)0;
 
-  if (iter == internalFunctions.end())
-  {
-    return std::nullopt;
-  }
+  return reduceValues<R>(KnownOperator::Add, std::span<const T>(vec));
+}
 
-  return iter->first;
+auto all_of(const BitArray &vec) -> bool
+{
+  return vec.all();
 }
 
-export auto getInternalFunction(const std::string &name, const std::vector<anka::TypeVariant> &arguments)
-    -> std::optional<std::pair<InternalFunctionDefinition, InternalFunctionExecuter>>
+auto any_of(const BitArray &vec) -> bool
 {
-  const auto &internalFunctions = anka::getInternalFunctions();
-  // anka::WordType::Name is a dummy => fix this!!!, do we really need the result type in the definition?
-  const auto definition = anka::InternalFunctionDefinition{name, arguments, anka::TypeFamily::Void, nullptr};
+  return vec.any();
+}
 
-  auto iter = internalFunctions.find(definition);
-  if (iter == internalFunctions.end())
-    return std::nullopt;
+auto none_of(const BitArray &vec) -> bool
+{
+  return vec.none();
+}
 
-  return std::make_pair(iter->first, iter->second);
+auto count(const BitArray &vec) -> int
+{
+  return static_cast<int>(vec.count());
 }
 
-export auto toString(InternalFunctionDefinition definition) -> std::string
+template <typename T> auto to_double(T val) -> double
 {
-  auto argText = anka::toString(definition.argumentTypes);
+  return static_cast<double>(val);
+}
 
-  return fmt::format("[{}] -> {}", fmt::join(argText, ", "), anka::toString({definition.returnType}));
+// Explicit conversions, values that do not fit the narrower type wrap around like the C++ conversions.
+template <typename R, typename T> auto convert(T val) -> R
+{
+  return static_cast<R>(val);
 }
 
-template <typename T>
-auto getValueWithConversion(anka::Context &context, anka::Word word) -> ValueReturnType<T>::ReturnType
+template <typename R, typename T> auto convertArray(const std::vector<T> &vec) -> std::vector<R>
 {
-  if constexpr (std::is_same_v<T, double>)
+  std::vector<R> res(vec.size());
+  std::ranges::transform(vec, res.begin(), [](T value) { return static_cast<R>(value); });
+  return res;
+}
+
+// Known operators fold in R, so that ints are added and multiplied without overflowing. Other functions are called
+// with the values of T.
+template <typename T, typename R = T> auto foldl(anka::BinaryOpt<T, T> func, const Array<T> &vec) -> R
+{
+  if (vec.empty())
+    return (R)0;
+
+  if constexpr (std::is_same_v<T, bool>)
   {
-    if (word.type == WordType::IntegerNumber)
-    {
-      auto iVal = anka::getValue<int>(context, word.index);
-      return static_cast<T>(iVal);
-    }
-    return anka::getValue<T>(context, word.index);
+    if (func == &anka::andFun)
+      return vec.all();
+    if (func == &anka::orFun)
+      return vec.any();
   }
-  else
+  else if (const auto op = findKnownOperator<T>(func); op != KnownOperator::None)
   {
-    return anka::getValue<T>(context, word.index);
+    return reduceValues<R>(op, std::span<const T>(vec));
   }
+
+  // other functions are called in order, they do not have to be associative
+  return static_cast<R>(std::accumulate(vec.begin() + 1, vec.end(), vec.front(), func));
 }
 
-template <typename T>
-auto getValue(anka::Context &context, const std::vector<anka::Word> &words, const std::vector<bool> &expandArray,
-              size_t arrIndex, size_t index) -> ValueReturnType<T>::ReturnType
+// Writes the running results to res, which has the size of vec and can be vec itself.
+template <typename T, typename R>
+auto scanInto(anka::BinaryOpt<T, R> func, const std::vector<T> &vec, std::vector<R> &res) -> void
 {
-  auto word = words[index];
+  if (vec.empty())
+    return;
+
+  if (const auto op = findKnownOperator<T>(func); op != KnownOperator::None)
+  {
+    scanValues(op, vec, res);
+    return;
+  }
+
+  std::partial_sum(vec.begin(), vec.end(), res.begin(), func);
+}
+
+template <typename T, typename R> auto scanl(anka::BinaryOpt<T, R> func, const Array<T> &vec) -> Array<R>
+{
+  if (vec.empty())
+    return vec;
+
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    BitArray res;
+    res.reserve(vec.size());
+    auto acc = vec.front();
+    res.push_back(acc);
+    for (size_t i = 1; i < vec.size(); ++i)
+    {
+      acc = func(acc, vec[i]);
+      res.push_back(acc);
+    }
+    return res;
+  }
+  else
+  {
+    std::vector<R> res(vec.size());
+    scanInto(func, vec, res);
+    return res;
+  }
+}
+
+template <typename T> auto scanlInPlace(anka::BinaryOpt<T, T> func, Array<T> &vec) -> void
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    for (size_t i = 1; i < vec.size(); ++i)
+    {
+      vec.set(i, func(vec[i - 1], vec[i]));
+    }
+  }
+  else
+  {
+    scanInto(func, vec, vec);
+  }
+}
+
+// Bit i of the mask is func(vec[i]).
+template <typename T, typename FuncType> auto evaluateMask(FuncType func, const std::vector<T> &vec) -> BitArray
+{
+  BitArray mask(vec.size());
+  auto blocks = mask.blocks();
+  auto fillMask = [&](size_t begin, size_t end) {
+    packBits(blocks.data() + begin / BitArray::bitsPerBlock, end - begin,
+             [&](size_t i) { return func(vec[begin + i]); });
+  };
+
+  if (vec.size() >= parallelThreshold)
+    parallelFor(vec.size(), fillMask);
+  else
+    fillMask(0, vec.size());
+  return mask;
+}
+
+template <typename T, typename FuncType> auto filter(FuncType func, const Array<T> &vec) -> Array<T>
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    // the kept values are either all true or all false values, only their count is needed
+    const auto keepTrue = func(true);
+    const auto keepFalse = func(false);
+    if (keepTrue && keepFalse)
+      return vec;
+    if (!keepTrue && !keepFalse)
+      return BitArray{};
+
+    const auto trueCount = vec.count();
+    return BitArray(keepTrue ? trueCount : vec.size() - trueCount, keepTrue);
+  }
+  else
+  {
+    // evaluate the predicate into a mask first, then compact with it
+    return compact(evaluateMask(func, vec), vec);
+  }
+}
+
+template <typename T, typename FuncType> auto filterInPlace(FuncType func, Array<T> &vec) -> void
+{
+  if constexpr (std::is_same_v<T, bool>)
+    vec = filter<T>(func, vec);
+  else
+    compactInPlace(evaluateMask(func, vec), vec);
+}
+
+template <typename T> auto filterWithVec(const BitArray &filterResults, const Array<T> &vec) -> Array<T>
+{
+  if (filterResults.size() != vec.size())
+    throw ExecutionError{std::nullopt, std::nullopt, "Filter expects given arrays to have the same size."};
+
+  return compact(filterResults, vec);
+}
+
+template <typename T> auto filterWithVecInPlace(const BitArray &filterResults, Array<T> &vec) -> void
+{
+  if (filterResults.size() != vec.size())
+    throw ExecutionError{std::nullopt, std::nullopt, "Filter expects given arrays to have the same size."};
+
+  compactInPlace(filterResults, vec);
+}
+
+// First occurrences of the values in their order. Equal values are next to each other in the grade, and the first
+// of them is the first occurrence.
+template <typename T> auto unique(const Array<T> &vec) -> Array<T>
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    BitArray res;
+    if (!vec.empty())
+      res.push_back(vec.front());
+    if (vec.any() && !vec.all())
+      res.push_back(!vec.front());
+    return res;
+  }
+  else
+  {
+    const auto order = gradeValues(vec);
+    BitArray mask(vec.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+      if (i == 0 || vec[order[i]] != vec[order[i - 1]])
+        mask.set(order[i], true);
+    }
+    return compact(mask, vec);
+  }
+}
+
+// Nested arrays
+
+// Reduces every row in one pass over the values, the rows are split between the threads.
+template <typename R, typename T, typename RowFunc>
+auto reduceRows(const NestedArray<T> &nested, RowFunc rowFunc) -> std::vector<R>
+{
+  std::vector<R> res(nested.size());
+  parallelFor(nested.size(), [&](size_t begin, size_t end) {
+    for (auto i = begin; i < end; ++i)
+    {
+      res[i] = rowFunc(nested.row(i));
+    }
+  });
+  return res;
+}
+
+template <typename T, typename R = T> auto sumRows(const NestedArray<T> &nested) -> std::vector<R>
+{
+  return reduceRows<R>(nested, [](std::span<const T> row) {
+    return row.empty() ? R{0} : reduceRange<R>(KnownOperator::Add, row.data(), row.size());
+  });
+}
+
+template <typename T> auto foldlRows(anka::BinaryOpt<T, T> func, const NestedArray<T> &nested) -> std::vector<T>
+{
+  const auto op = findKnownOperator<T>(func);
+  return reduceRows<T>(nested, [func, op](std::span<const T> row) {
+    if (row.empty())
+      return T{0};
+    if (op != KnownOperator::None)
+      return reduceRange<T>(op, row.data(), row.size());
+    return std::accumulate(row.begin() + 1, row.end(), row.front(), func);
+  });
+}
+
+// Dictionaries
+
+template <typename T> auto dict(const std::vector<int> &keys, const Array<T> &values) -> Dictionary
+{
+  if (keys.size() != values.size())
+    throw ExecutionError{std::nullopt, std::nullopt, "Dict expects as many values as keys."};
+
+  Dictionary res;
+  res.reserve(keys.size());
+  for (auto key : keys)
+  {
+    if (!res.insert(key).second)
+      throw ExecutionError{std::nullopt, std::nullopt, fmt::format("Dict got the key {} more than once.", key)};
+  }
+  res.setValues(Array<T>(values));
+  return res;
+}
+
+// Number of occurrences of every value, keyed in the order of their first occurrence.
+auto count_by(const std::vector<int> &vec) -> Dictionary
+{
+  Dictionary res;
+  std::vector<int> counts;
+  for (auto value : vec)
+  {
+    const auto [position, inserted] = res.insert(value);
+    if (inserted)
+      counts.push_back(0);
+    ++counts[position];
+  }
+  res.setValues(std::move(counts));
+  return res;
+}
+
+// 1-based group of every value, values are numbered in the order of their first occurrence.
+auto group(const std::vector<int> &vec) -> std::vector<int>
+{
+  Dictionary groups;
+  std::vector<int> res(vec.size());
+  for (size_t i = 0; i < vec.size(); ++i)
+  {
+    res[i] = static_cast<int>(groups.insert(vec[i]).first) + 1;
+  }
+  return res;
+}
+
+auto keys(const Dictionary &dictionary) -> std::vector<int>
+{
+  return dictionary.keys();
+}
+
+export struct InternalFunctionDefinition
+{
+  std::string name;
+  TypeList argumentTypes;
+  TypeVariant returnType;
+  void *funcPtr = nullptr;
+};
+
+export struct InternalFunctionDefinitionHash
+{
+  inline size_t operator()(const InternalFunctionDefinition &k) const
+  {
+    return std::hash<std::string>()(k.name) ^ anka::hash(k.argumentTypes);
+  }
+};
+
+export struct InternalFunctionDefinitionEqual
+{
+  inline bool operator()(const InternalFunctionDefinition &k1, const InternalFunctionDefinition &k2) const
+  {
+    return (k1.name == k2.name) && (k1.argumentTypes == k2.argumentTypes);
+  }
+};
+
+export using InternalFunctionMaptype =
+    std::unordered_map<InternalFunctionDefinition, InternalFunctionExecuter, InternalFunctionDefinitionHash,
+                       InternalFunctionDefinitionEqual>;
+
+auto getInternalFunctions() -> const InternalFunctionMaptype &;
+
+export auto getAllInternalFunctionDefinitions() -> std::vector<InternalFunctionDefinition>
+{
+  const auto &internalFunctions = anka::getInternalFunctions();
+  auto kv = ranges::views::keys(internalFunctions);
+  std::vector<anka::InternalFunctionDefinition> definitions{kv.begin(), kv.end()};
+  return definitions;
+}
+
+template <typename T>
+auto getInternalFunctionDefinition(const std::string &name) -> std::optional<InternalFunctionDefinition>
+{
+  const auto &internalFunctions = anka::getInternalFunctions();
+  auto type = anka::getType<T>();
+  auto funcType = std::get<anka::FunctionType>(type);
+  const auto arguments = std::vector<TypeVariant>(funcType.arguments.begin(), funcType.arguments.end());
+  const auto definition = anka::InternalFunctionDefinition{name, arguments, funcType.returnType, nullptr};
+  auto iter = internalFunctions.find(definition);
+
+  if (iter == internalFunctions.end())
+  {
+    return std::nullopt;
+  }
+
+  return iter->first;
+}
+
+export auto getInternalFunction(const std::string &name, const std::vector<anka::TypeVariant> &arguments)
+    -> const InternalFunctionMaptype::value_type *
+{
+  const auto &internalFunctions = anka::getInternalFunctions();
+  // anka::WordType::Name is a dummy => fix this!!!, do we really need the result type in the definition?
+  const auto definition = anka::InternalFunctionDefinition{name, arguments, anka::TypeFamily::Void, nullptr};
+
+  auto iter = internalFunctions.find(definition);
+  if (iter == internalFunctions.end())
+    return nullptr;
+
+  return &(*iter);
+}
+
+export auto toString(InternalFunctionDefinition definition) -> std::string
+{
+  auto argText = anka::toString(definition.argumentTypes);
+
+  return fmt::format("[{}] -> {}", fmt::join(argText, ", "), anka::toString({definition.returnType}));
+}
+
+template <typename T>
+auto getValueWithConversion(anka::Context &context, anka::Word word) -> ValueReturnType<T>::ReturnType
+{
+  if constexpr (std::is_same_v<T, double> || std::is_same_v<T, std::int64_t>)
+  {
+    if (word.type == WordType::IntegerNumber)
+    {
+      auto iVal = anka::getValue<int>(context, word.index);
+      return static_cast<T>(iVal);
+    }
+    return anka::getValue<T>(context, word.index);
+  }
+  else
+  {
+    return anka::getValue<T>(context, word.index);
+  }
+}
+
+template <typename T>
+auto getValue(anka::Context &context, const std::vector<anka::Word> &words, const std::vector<bool> &expandArray,
+              size_t arrIndex, size_t index) -> ValueReturnType<T>::ReturnType
+{
+  auto word = words[index];
 
   // Internal function as argument
   if constexpr (std::is_function_v<typename std::remove_pointer<T>::type>)
@@ -338,9 +1039,20 @@ auto getValue(anka::Context &context, const std::vector<anka::Word> &words, cons
   {
     auto shouldExpandArray = expandArray[index];
 
+    if (shouldExpandArray && word.type != getWordType<Array<T>>())
+    {
+      return anka::visitStorageArray(context, word, [word, arrIndex](auto values) {
+        if (arrIndex >= values.size())
+        {
+          throw anka::ExecutionError{word, std::nullopt, "Array size mismatch"};
+        }
+        return static_cast<T>(values[arrIndex]);
+      });
+    }
+
     if (shouldExpandArray)
     {
-      auto &&vec = anka::getValue<std::vector<T>>(context, word.index);
+      auto &&vec = anka::getValue<Array<T>>(context, word.index);
       if (arrIndex >= vec.size())
       {
         throw anka::ExecutionError{word, std::nullopt, "Array size mismatch"};
@@ -363,24 +1075,29 @@ auto getArgumentSize(anka::Context &context, const std::vector<anka::Word> &word
   if (!expandArray[index])
     return 1;
 
-  return anka::getItemSize<std::vector<T>>(context, words[index].index);
+  if (words[index].type != getWordType<Array<T>>())
+    return anka::visitStorageArray(context, words[index], [](auto values) { return values.size(); });
+
+  return anka::getItemSize<Array<T>>(context, words[index].index);
 }
 
+// Arrays are passed by reference to the values in the context.
 template <typename... ArgTypes>
 auto createArguments(anka::Context &context, const std::vector<anka::Word> &words, const std::vector<bool> &expandArray,
-                     size_t arrIndex) -> std::tuple<ArgTypes...>
+                     size_t arrIndex) -> std::tuple<typename ValueReturnType<ArgTypes>::ReturnType...>
 {
   // see https://stackoverflow.com/questions/65261797/varadic-template-to-tuple-is-reversed
   // using an initilizer list fixes the order
   size_t i = 0;
-  auto args = std::tuple<ArgTypes...>{getValue<ArgTypes>(context, words, expandArray, arrIndex, i++)...};
+  auto args = std::tuple<typename ValueReturnType<ArgTypes>::ReturnType...>{
+      getValue<ArgTypes>(context, words, expandArray, arrIndex, i++)...};
   return args;
 }
 
 template <typename ReturnType, typename... ArgTypes>
 auto createFunctionExecutor(void *funPtr) -> InternalFunctionExecuter
 {
-  typedef ReturnType (*FunType)(ArgTypes...);
+  typedef ReturnType (*FunType)(typename ValueReturnType<ArgTypes>::ReturnType...);
   FunType func = static_cast<FunType>(funPtr);
 
   auto executor = [func](anka::Context &context, const std::vector<anka::Word> &words,
@@ -431,11 +1148,12 @@ auto createFunctionExecutor(void *funPtr) -> InternalFunctionExecuter
       }
       else
       {
-        std::vector<ReturnType> vec(max_size);
+        Array<ReturnType> vec;
+        vec.reserve(max_size);
         for (auto arrIndex = 0; arrIndex < max_size; ++arrIndex)
         {
           auto args = createArguments<ArgTypes...>(context, words, expandArray, arrIndex);
-          vec[arrIndex] = std::apply(func, args);
+          vec.push_back(std::apply(func, args));
         }
         return anka::createWord(context, std::move(vec));
       }
@@ -445,157 +1163,871 @@ auto createFunctionExecutor(void *funPtr) -> InternalFunctionExecuter
   return executor;
 }
 
-template <typename T> anka::WordType getValueWithInternalFunctions()
+// Storage of the array argument at index if the caller owns it, then the function can write its result there.
+template <typename T>
+auto getOwnedArray(anka::Context &context, const std::vector<anka::Word> &words, size_t index) -> Array<T> *
 {
-  using Decayed = std::decay<T>::type;
+  const auto &owned = context.ownedArgument;
+  if (!owned || words[index] != owned.value() || owned->type != getWordType<Array<T>>() ||
+      std::ranges::count(words, owned.value()) != 1 || anka::isInherited(context, owned.value()))
+    return nullptr;
 
-  if constexpr (std::is_same_v<Decayed, anka::BinaryOpt<int, int>>)
-    return anka::WordType::Name;
-  else if constexpr (std::is_same_v<Decayed, anka::BinaryOpt<double, double>>)
-    return anka::WordType::Name;
-  else
-    return anka::getWordType<T>;
+  return &anka::getArray<T>(context, owned->index);
 }
 
-template <typename ReturnType, typename... ArgTypes>
-auto addInternalFunction(InternalFunctionMaptype &map, std::string &&name, void *ptr)
+// Calls InPlace with the other arguments and the array, the last argument, when the caller owns the array.
+// Otherwise the copying function in fallback is called.
+template <auto InPlace, typename T, typename... ArgTypes>
+auto createInPlaceExecutor(InternalFunctionExecuter fallback) -> InternalFunctionExecuter
 {
-  InternalFunctionDefinition def;
-  def.name = name;
-  def.returnType = anka::getType<ReturnType>();
-  def.argumentTypes = std::vector<anka::TypeVariant>{anka::getType<ArgTypes>()...};
-  def.funcPtr = ptr;
+  auto executor = [fallback](anka::Context &context, const std::vector<anka::Word> &words,
+                             const std::vector<bool> &expandArray) -> std::optional<anka::Word> {
+    constexpr auto arrayIndex = sizeof...(ArgTypes);
+    auto *owned = std::ranges::none_of(expandArray, std::identity{}) ? getOwnedArray<T>(context, words, arrayIndex)
+                                                                      : nullptr;
+    if (owned == nullptr)
+      return fallback(context, words, expandArray);
+
+    auto args = createArguments<ArgTypes...>(context, words, expandArray, 0);
+    std::apply([owned](auto &&...values) { InPlace(values..., *owned); }, args);
+    return words[arrayIndex];
+  };
 
-  map[def] = createFunctionExecutor<ReturnType, ArgTypes...>(ptr);
+  return executor;
 }
 
-export auto getInternalFunctions() -> const InternalFunctionMaptype &
-{
-  static std::optional<InternalFunctionMaptype> functionMapOpt;
+template <typename T> struct FunctionPointerTraits;
 
-  if (functionMapOpt.has_value())
-    return functionMapOpt.value();
+template <typename R, typename... Args> struct FunctionPointerTraits<R (*)(Args...)>
+{
+  using ReturnType = R;
+  static constexpr size_t arity = sizeof...(Args);
+};
 
-  InternalFunctionMaptype map;
-  addInternalFunction<std::vector<int>, int>(map, "ioata", &anka::ioata);
+// Element-wise kernels work on blocks of contiguous values. The function is a template argument so it is
+// inlined into the loops and the compiler can vectorise them.
+constexpr size_t kernelBlockSize = 256;
 
-  addInternalFunction<bool, int>(map, "odd", &anka::odd);
-  addInternalFunction<bool, int>(map, "even", &anka::even);
-  addInternalFunction<bool, int>(map, "is_positive", &anka::is_positive<int>);
-  addInternalFunction<bool, double>(map, "is_positive", &anka::is_positive<double>);
-  addInternalFunction<bool, int>(map, "is_negative", &anka::is_negative<int>);
-  addInternalFunction<bool, double>(map, "is_negative", &anka::is_negative<double>);
-
-  addInternalFunction<int, int>(map, "inc", &anka::inc<int>);
-  addInternalFunction<double, double>(map, "inc", &anka::inc<double>);
-  addInternalFunction<int, int>(map, "dec", &anka::dec<int>);
-  addInternalFunction<double, double>(map, "dec", &anka::dec<double>);
-  addInternalFunction<int, int>(map, "neg", &anka::neg<int>);
-  addInternalFunction<double, double>(map, "neg", &anka::neg<double>);
-  addInternalFunction<int, int>(map, "abs", &anka::abs<int>);
-  addInternalFunction<double, double>(map, "abs", &anka::abs<double>);
+// Kernels see boolean arrays as blocks of 64 values.
+template <typename T> using KernelValue = std::conditional_t<std::is_same_v<T, bool>, BitArray::Block, T>;
 
-  typedef double (*DoubleToDoubleFunc)(double);
-  addInternalFunction<double, double>(map, "sqrt", static_cast<DoubleToDoubleFunc>(&std::sqrt));
-  addInternalFunction<double, double>(map, "exp", static_cast<DoubleToDoubleFunc>(&std::exp));
-  addInternalFunction<double, double>(map, "log", static_cast<DoubleToDoubleFunc>(&std::log));
-  addInternalFunction<double, double>(map, "log10", static_cast<DoubleToDoubleFunc>(&std::log10));
-  addInternalFunction<double, double>(map, "sin", static_cast<DoubleToDoubleFunc>(&std::sin));
-  addInternalFunction<double, double>(map, "cos", static_cast<DoubleToDoubleFunc>(&std::cos));
-  addInternalFunction<double, double>(map, "tan", static_cast<DoubleToDoubleFunc>(&std::tan));
-  addInternalFunction<double, double>(map, "floor", static_cast<DoubleToDoubleFunc>(&std::floor));
-  addInternalFunction<double, double>(map, "ceil", static_cast<DoubleToDoubleFunc>(&std::ceil));
-  addInternalFunction<double, double>(map, "trunc", static_cast<DoubleToDoubleFunc>(&std::trunc));
+template <typename T> auto kernelData(const Array<T> &vec, size_t begin) -> const KernelValue<T> *
+{
+  if constexpr (std::is_same_v<T, bool>)
+    return vec.blocks().data() + begin / BitArray::bitsPerBlock;
+  else
+    return vec.data() + begin;
+}
 
-  addInternalFunction<int, std::vector<int>>(map, "length", &anka::length<int>);
-  addInternalFunction<int, std::vector<double>>(map, "length", &anka::length<double>);
-  addInternalFunction<int, std::vector<bool>>(map, "length", &anka::length<bool>);
-
-  addInternalFunction<std::vector<int>, std::vector<int>>(map, "sort", &anka::sort<int>);
-  addInternalFunction<std::vector<double>, std::vector<double>>(map, "sort", &anka::sort<double>);
-  addInternalFunction<std::vector<bool>, std::vector<bool>>(map, "sort", &anka::sort<bool>);
-
-  addInternalFunction<int, int, int>(map, "add", &anka::add<int>);
-  addInternalFunction<double, double, double>(map, "add", &anka::add<double>);
-  addInternalFunction<int, int, int>(map, "sub", &anka::sub<int>);
-  addInternalFunction<double, double, double>(map, "sub", &anka::sub<double>);
-  addInternalFunction<int, int, int>(map, "mul", &anka::mul<int>);
-  addInternalFunction<double, double, double>(map, "mul", &anka::mul<double>);
-  addInternalFunction<int, int, int>(map, "div", &anka::div<int>);
-  addInternalFunction<double, double, double>(map, "div", &anka::div<double>);
-
-  addInternalFunction<bool, bool, bool>(map, "and", &anka::andFun);
-  addInternalFunction<bool, bool, bool>(map, "or", &anka::orFun);
-
-  addInternalFunction<bool, bool, bool>(map, "equals", &anka::equals<bool>);
-  addInternalFunction<bool, int, int>(map, "equals", &anka::equals<int>);
-  addInternalFunction<bool, double, double>(map, "equals", &anka::equals<double>);
-  addInternalFunction<bool, bool, bool>(map, "not_equals", &anka::notEquals<bool>);
-  addInternalFunction<bool, int, int>(map, "not_equals", &anka::notEquals<int>);
-  addInternalFunction<bool, double, double>(map, "not_equals", &anka::notEquals<double>);
-
-  addInternalFunction<bool, bool, bool>(map, "greater_than", &anka::greaterThan<bool>);
-  addInternalFunction<bool, int, int>(map, "greater_than", &anka::greaterThan<int>);
-  addInternalFunction<bool, double, double>(map, "greater_than", &anka::greaterThan<double>);
-
-  addInternalFunction<bool, bool, bool>(map, "less_than", &anka::lessThan<bool>);
-  addInternalFunction<bool, int, int>(map, "less_than", &anka::lessThan<int>);
-  addInternalFunction<bool, double, double>(map, "less_than", &anka::lessThan<double>);
-
-  addInternalFunction<bool, bool>(map, "not", &anka::notFun);
-  addInternalFunction<bool, std::vector<bool>>(map, "all_of", &anka::all_of);
-  addInternalFunction<bool, std::vector<bool>>(map, "any_of", &anka::any_of);
-  addInternalFunction<bool, std::vector<bool>>(map, "none_of", &anka::none_of);
-
-  addInternalFunction<int, std::vector<int>>(map, "sum", &anka::sum<int>);
-  addInternalFunction<double, std::vector<double>>(map, "sum", &anka::sum<double>);
+template <typename T> auto kernelData(Array<T> &vec, size_t begin) -> KernelValue<T> *
+{
+  if constexpr (std::is_same_v<T, bool>)
+    return vec.blocks().data() + begin / BitArray::bitsPerBlock;
+  else
+    return vec.data() + begin;
+}
 
-  addInternalFunction<int, double>(map, "to_double", &anka::to_double<int>);
-  addInternalFunction<double, double>(map, "to_double", &anka::to_double<double>);
+// Functions of booleans are evaluated for a whole block at once by combining the blocks according to the
+// function's truth table.
+template <auto Func> auto applyToBlock(BitArray::Block value) -> BitArray::Block
+{
+  return (value & toBlock(Func(true))) | (~value & toBlock(Func(false)));
+}
 
-  addInternalFunction<bool, anka::BinaryOpt<bool, bool>, std::vector<bool>>(map, "foldl", &anka::foldl<bool, bool>);
-  addInternalFunction<int, anka::BinaryOpt<int, int>, std::vector<int>>(map, "foldl", &anka::foldl<int, int>);
-  addInternalFunction<double, anka::BinaryOpt<double, double>, std::vector<double>>(map, "foldl",
-                                                                                    &anka::foldl<double, double>);
+template <auto Func> auto applyToBlocks(BitArray::Block lhs, BitArray::Block rhs) -> BitArray::Block
+{
+  return (lhs & rhs & toBlock(Func(true, true))) | (lhs & ~rhs & toBlock(Func(true, false))) |
+         (~lhs & rhs & toBlock(Func(false, true))) | (~lhs & ~rhs & toBlock(Func(false, false)));
+}
 
-  addInternalFunction<std::vector<bool>, anka::BinaryOpt<bool, bool>, std::vector<bool>>(map, "scanl",
-                                                                                         &anka::scanl<bool, bool>);
-  addInternalFunction<std::vector<int>, anka::BinaryOpt<int, int>, std::vector<int>>(map, "scanl",
-                                                                                     &anka::scanl<int, int>);
-  addInternalFunction<std::vector<double>, anka::BinaryOpt<double, double>, std::vector<double>>(
-      map, "scanl", &anka::scanl<double, double>);
+template <auto Func, typename R, typename T>
+auto unaryKernel(const KernelValue<T> *in, KernelValue<R> *out, size_t count) -> void
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    static_assert(std::is_same_v<R, bool>, "Functions of booleans should return booleans.");
+    for (size_t i = 0; i < BitArray::getBlockCount(count); ++i)
+      out[i] = applyToBlock<Func>(in[i]);
+  }
+  else if constexpr (std::is_same_v<R, bool>)
+    packBits(out, count, [in](size_t i) { return Func(in[i]); });
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = Func(in[i]);
+  }
+}
+
+template <auto Func, typename R, typename T>
+auto binaryKernel(const KernelValue<T> *lhs, const KernelValue<T> *rhs, KernelValue<R> *out, size_t count) -> void
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    static_assert(std::is_same_v<R, bool>, "Functions of booleans should return booleans.");
+    for (size_t i = 0; i < BitArray::getBlockCount(count); ++i)
+      out[i] = applyToBlocks<Func>(lhs[i], rhs[i]);
+  }
+  else if constexpr (std::is_same_v<R, bool>)
+    packBits(out, count, [lhs, rhs](size_t i) { return Func(lhs[i], rhs[i]); });
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = Func(lhs[i], rhs[i]);
+  }
+}
+
+template <auto Func, typename R, typename T>
+auto binaryKernelScalarRhs(const KernelValue<T> *lhs, T rhs, KernelValue<R> *out, size_t count) -> void
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    static_assert(std::is_same_v<R, bool>, "Functions of booleans should return booleans.");
+    const auto rhsBlock = toBlock(rhs);
+    for (size_t i = 0; i < BitArray::getBlockCount(count); ++i)
+      out[i] = applyToBlocks<Func>(lhs[i], rhsBlock);
+  }
+  else if constexpr (std::is_same_v<R, bool>)
+    packBits(out, count, [lhs, rhs](size_t i) { return Func(lhs[i], rhs); });
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = Func(lhs[i], rhs);
+  }
+}
+
+template <auto Func, typename R, typename T>
+auto binaryKernelScalarLhs(T lhs, const KernelValue<T> *rhs, KernelValue<R> *out, size_t count) -> void
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    static_assert(std::is_same_v<R, bool>, "Functions of booleans should return booleans.");
+    const auto lhsBlock = toBlock(lhs);
+    for (size_t i = 0; i < BitArray::getBlockCount(count); ++i)
+      out[i] = applyToBlocks<Func>(lhsBlock, rhs[i]);
+  }
+  else if constexpr (std::is_same_v<R, bool>)
+    packBits(out, count, [lhs, rhs](size_t i) { return Func(lhs, rhs[i]); });
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = Func(lhs, rhs[i]);
+  }
+}
+
+// Calls func(begin, count) for consecutive blocks of [0, size), large arrays are split between the threads.
+template <typename Func> auto forEachBlock(size_t size, Func func) -> void
+{
+  auto blocks = [&func](size_t begin, size_t end) {
+    for (; begin < end; begin += kernelBlockSize)
+    {
+      func(begin, std::min(kernelBlockSize, end - begin));
+    }
+  };
 
-  addInternalFunction<std::vector<bool>, anka::FilterFunc<bool>, std::vector<bool>>(
+  if (size >= parallelThreshold)
+    parallelFor(size, blocks);
+  else
+    blocks(0, size);
+}
+
+// Whole blocks are written for boolean results, so the bits after the last value are cleared at the end.
+template <typename R> auto finishKernelResult(Array<R> &res) -> void
+{
+  if constexpr (std::is_same_v<R, bool>)
+    res.clearTail();
+}
+
+// The kernels read and write the same index, so res can be one of the arguments.
+template <auto Func, typename R, typename T> auto applyUnaryKernel(const Array<T> &vec, Array<R> &res) -> void
+{
+  forEachBlock(vec.size(), [&](size_t begin, size_t count) {
+    unaryKernel<Func, R, T>(kernelData<T>(vec, begin), kernelData<R>(res, begin), count);
+  });
+  finishKernelResult<R>(res);
+}
+
+template <auto Func, typename R, typename T>
+auto applyBinaryKernel(const Array<T> &lhs, const Array<T> &rhs, Array<R> &res) -> void
+{
+  forEachBlock(lhs.size(), [&](size_t begin, size_t count) {
+    binaryKernel<Func, R, T>(kernelData<T>(lhs, begin), kernelData<T>(rhs, begin), kernelData<R>(res, begin), count);
+  });
+  finishKernelResult<R>(res);
+}
+
+template <auto Func, typename R, typename T> auto applyBinaryKernel(const Array<T> &lhs, T rhs, Array<R> &res) -> void
+{
+  forEachBlock(lhs.size(), [&](size_t begin, size_t count) {
+    binaryKernelScalarRhs<Func, R, T>(kernelData<T>(lhs, begin), rhs, kernelData<R>(res, begin), count);
+  });
+  finishKernelResult<R>(res);
+}
+
+template <auto Func, typename R, typename T> auto applyBinaryKernel(T lhs, const Array<T> &rhs, Array<R> &res) -> void
+{
+  forEachBlock(rhs.size(), [&](size_t begin, size_t count) {
+    binaryKernelScalarLhs<Func, R, T>(lhs, kernelData<T>(rhs, begin), kernelData<R>(res, begin), count);
+  });
+  finishKernelResult<R>(res);
+}
+
+// Array argument the result can be written over, the caller has to own it and the element type has to stay.
+template <typename R, typename T>
+auto findOwnedResult(anka::Context &context, const std::vector<anka::Word> &words,
+                     const std::vector<bool> &expandArray) -> std::optional<anka::Word>
+{
+  if constexpr (std::is_same_v<R, T>)
+  {
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+      if (expandArray[i] && getOwnedArray<T>(context, words, i) != nullptr)
+        return words[i];
+    }
+  }
+  return std::nullopt;
+}
+
+// Writes the result of apply over an owned argument or to a new array of the given size.
+template <typename R, typename Apply>
+auto createKernelResult(anka::Context &context, const std::optional<anka::Word> &owned, size_t size, Apply apply)
+    -> anka::Word
+{
+  if (owned)
+  {
+    apply(anka::getArray<R>(context, owned->index));
+    return owned.value();
+  }
+
+  Array<R> res(size);
+  apply(res);
+  return anka::createWord(context, std::move(res));
+}
+
+// Array argument of a kernel, float and small integer arrays are widened to T first.
+template <typename T>
+auto getKernelArray(anka::Context &context, const anka::Word &word, Array<T> &widened) -> const Array<T> &
+{
+  if constexpr (!std::is_same_v<T, bool>)
+  {
+    if (word.type != getWordType<Array<T>>())
+    {
+      anka::visitStorageArray(context, word, [&widened](auto values) {
+        widened.resize(values.size());
+        std::ranges::transform(values, widened.begin(), [](auto value) { return static_cast<T>(value); });
+      });
+      return widened;
+    }
+  }
+  return anka::getValue<Array<T>>(context, word.index);
+}
+
+// Runs whole arrays through the element-wise kernels, everything else goes to the generic executor.
+template <auto Func, typename ReturnType, typename T>
+auto createKernelExecutor(InternalFunctionExecuter fallback) -> InternalFunctionExecuter
+{
+  constexpr auto arity = FunctionPointerTraits<decltype(Func)>::arity;
+  static_assert(arity == 1 || arity == 2, "Kernels are only available for unary and binary functions.");
+
+  auto executor = [fallback](anka::Context &context, const std::vector<anka::Word> &words,
+                             const std::vector<bool> &expandArray) -> std::optional<anka::Word> {
+    if constexpr (arity == 1)
+    {
+      if (!expandArray[0])
+        return fallback(context, words, expandArray);
+
+      Array<T> widened;
+      auto &&vec = getKernelArray<T>(context, words[0], widened);
+      return createKernelResult<ReturnType>(
+          context, findOwnedResult<ReturnType, T>(context, words, expandArray), vec.size(),
+          [&vec](Array<ReturnType> &res) { applyUnaryKernel<Func, ReturnType, T>(vec, res); });
+    }
+    else
+    {
+      const auto owned = findOwnedResult<ReturnType, T>(context, words, expandArray);
+      Array<T> lhsWidened;
+      Array<T> rhsWidened;
+      if (expandArray[0] && expandArray[1])
+      {
+        auto &&lhs = getKernelArray<T>(context, words[0], lhsWidened);
+        auto &&rhs = getKernelArray<T>(context, words[1], rhsWidened);
+        if (lhs.size() != rhs.size())
+        {
+          auto shorter = lhs.size() < rhs.size() ? words[0] : words[1];
+          throw anka::ExecutionError{shorter, std::nullopt, "Array size mismatch"};
+        }
+        return createKernelResult<ReturnType>(context, owned, lhs.size(), [&lhs, &rhs](Array<ReturnType> &res) {
+          applyBinaryKernel<Func, ReturnType, T>(lhs, rhs, res);
+        });
+      }
+      if (expandArray[0])
+      {
+        auto &&lhs = getKernelArray<T>(context, words[0], lhsWidened);
+        auto rhs = anka::getValueWithConversion<T>(context, words[1]);
+        return createKernelResult<ReturnType>(context, owned, lhs.size(), [&lhs, rhs](Array<ReturnType> &res) {
+          applyBinaryKernel<Func, ReturnType, T>(lhs, rhs, res);
+        });
+      }
+      if (expandArray[1])
+      {
+        auto lhs = anka::getValueWithConversion<T>(context, words[0]);
+        auto &&rhs = getKernelArray<T>(context, words[1], rhsWidened);
+        return createKernelResult<ReturnType>(context, owned, rhs.size(), [lhs, &rhs](Array<ReturnType> &res) {
+          applyBinaryKernel<Func, ReturnType, T>(lhs, rhs, res);
+        });
+      }
+      return fallback(context, words, expandArray);
+    }
+  };
+
+  return executor;
+}
+
+template <typename T> anka::WordType getValueWithInternalFunctions()
+{
+  using Decayed = std::decay<T>::type;
+
+  if constexpr (std::is_same_v<Decayed, anka::BinaryOpt<int, int>>)
+    return anka::WordType::Name;
+  else if constexpr (std::is_same_v<Decayed, anka::BinaryOpt<double, double>>)
+    return anka::WordType::Name;
+  else
+    return anka::getWordType<T>;
+}
+
+template <typename ReturnType, typename... ArgTypes>
+auto addInternalFunction(InternalFunctionMaptype &map, std::string &&name, void *ptr)
+{
+  InternalFunctionDefinition def;
+  def.name = name;
+  def.returnType = anka::getType<ReturnType>();
+  def.argumentTypes = std::vector<anka::TypeVariant>{anka::getType<ArgTypes>()...};
+  def.funcPtr = ptr;
+
+  map[def] = createFunctionExecutor<ReturnType, ArgTypes...>(ptr);
+}
+
+template <auto Func, typename ReturnType, typename T, typename... ArgTypes>
+auto addKernelFunction(InternalFunctionMaptype &map, std::string &&name, ReturnType (*)(T, ArgTypes...))
+{
+  void *ptr = reinterpret_cast<void *>(Func);
+
+  InternalFunctionDefinition def;
+  def.name = name;
+  def.returnType = anka::getType<ReturnType>();
+  def.argumentTypes = std::vector<anka::TypeVariant>{anka::getType<T>(), anka::getType<ArgTypes>()...};
+  def.funcPtr = ptr;
+
+  map[def] = createKernelExecutor<Func, ReturnType, T>(createFunctionExecutor<ReturnType, T, ArgTypes...>(ptr));
+}
+
+// Functions that can write their result over their array argument, the last one, when the caller owns it.
+template <auto InPlace, typename T, typename... ArgTypes>
+auto addInPlaceFunction(InternalFunctionMaptype &map, std::string &&name, void *ptr)
+{
+  InternalFunctionDefinition def;
+  def.name = name;
+  def.returnType = anka::getType<Array<T>>();
+  def.argumentTypes = std::vector<anka::TypeVariant>{anka::getType<ArgTypes>()..., anka::getType<Array<T>>()};
+  def.funcPtr = ptr;
+
+  map[def] =
+      createInPlaceExecutor<InPlace, T, ArgTypes...>(createFunctionExecutor<Array<T>, ArgTypes..., Array<T>>(ptr));
+}
+
+// Element-wise functions with dedicated array kernels
+template <auto Func> auto addKernelFunction(InternalFunctionMaptype &map, std::string &&name)
+{
+  addKernelFunction<Func>(map, std::move(name), Func);
+}
+
+auto createInternalFunctions() -> InternalFunctionMaptype
+{
+  InternalFunctionMaptype map;
+  addInternalFunction<std::vector<int>, int>(map, "ioata", &anka::ioata);
+
+  addKernelFunction<&anka::odd>(map, "odd");
+  addKernelFunction<&anka::even>(map, "even");
+  addKernelFunction<&anka::is_positive<int>>(map, "is_positive");
+  addKernelFunction<&anka::is_positive<double>>(map, "is_positive");
+  addKernelFunction<&anka::is_negative<int>>(map, "is_negative");
+  addKernelFunction<&anka::is_negative<double>>(map, "is_negative");
+
+  addKernelFunction<&anka::inc<int>>(map, "inc");
+  addKernelFunction<&anka::inc<double>>(map, "inc");
+  addKernelFunction<&anka::dec<int>>(map, "dec");
+  addKernelFunction<&anka::dec<double>>(map, "dec");
+  addKernelFunction<&anka::neg<int>>(map, "neg");
+  addKernelFunction<&anka::neg<double>>(map, "neg");
+  addKernelFunction<&anka::abs<int>>(map, "abs");
+  addKernelFunction<&anka::abs<double>>(map, "abs");
+
+  typedef double (*DoubleToDoubleFunc)(double);
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::sqrt)>(map, "sqrt");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::exp)>(map, "exp");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::log)>(map, "log");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::log10)>(map, "log10");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::sin)>(map, "sin");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::cos)>(map, "cos");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::tan)>(map, "tan");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::floor)>(map, "floor");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::ceil)>(map, "ceil");
+  addKernelFunction<static_cast<DoubleToDoubleFunc>(&std::trunc)>(map, "trunc");
+
+  addInternalFunction<int, std::vector<int>>(map, "length", &anka::length<int>);
+  addInternalFunction<int, std::vector<double>>(map, "length", &anka::length<double>);
+  addInternalFunction<int, BitArray>(map, "length", &anka::length<bool>);
+  addInternalFunction<int, std::vector<std::int64_t>>(map, "length", &anka::length<std::int64_t>);
+  addInternalFunction<int, std::vector<float>>(map, "length", &anka::length<float>);
+  addInternalFunction<int, std::vector<std::int8_t>>(map, "length", &anka::length<std::int8_t>);
+  addInternalFunction<int, std::vector<std::int16_t>>(map, "length", &anka::length<std::int16_t>);
+  addInternalFunction<int, std::vector<std::uint8_t>>(map, "length", &anka::length<std::uint8_t>);
+
+  addInPlaceFunction<&anka::sortInPlace<int>, int>(map, "sort", &anka::sort<int>);
+  addInPlaceFunction<&anka::sortInPlace<double>, double>(map, "sort", &anka::sort<double>);
+  addInPlaceFunction<&anka::sortInPlace<bool>, bool>(map, "sort", &anka::sort<bool>);
+  addInPlaceFunction<&anka::sortInPlace<std::int64_t>, std::int64_t>(map, "sort", &anka::sort<std::int64_t>);
+  addInPlaceFunction<&anka::sortInPlace<float>, float>(map, "sort", &anka::sort<float>);
+  addInPlaceFunction<&anka::sortInPlace<std::int8_t>, std::int8_t>(map, "sort", &anka::sort<std::int8_t>);
+  addInPlaceFunction<&anka::sortInPlace<std::int16_t>, std::int16_t>(map, "sort", &anka::sort<std::int16_t>);
+  addInPlaceFunction<&anka::sortInPlace<std::uint8_t>, std::uint8_t>(map, "sort", &anka::sort<std::uint8_t>);
+
+  addInternalFunction<std::vector<int>, std::vector<int>>(map, "grade", &anka::grade<int>);
+  addInternalFunction<std::vector<int>, std::vector<double>>(map, "grade", &anka::grade<double>);
+  addInternalFunction<std::vector<int>, BitArray>(map, "grade", &anka::grade<bool>);
+  addInternalFunction<std::vector<int>, std::vector<std::int64_t>>(map, "grade", &anka::grade<std::int64_t>);
+  addInternalFunction<std::vector<int>, std::vector<float>>(map, "grade", &anka::grade<float>);
+  addInternalFunction<std::vector<int>, std::vector<std::int8_t>>(map, "grade", &anka::grade<std::int8_t>);
+  addInternalFunction<std::vector<int>, std::vector<std::int16_t>>(map, "grade", &anka::grade<std::int16_t>);
+  addInternalFunction<std::vector<int>, std::vector<std::uint8_t>>(map, "grade", &anka::grade<std::uint8_t>);
+
+  addInPlaceFunction<&anka::topInPlace<int>, int, int>(map, "top", &anka::top<int>);
+  addInPlaceFunction<&anka::topInPlace<double>, double, int>(map, "top", &anka::top<double>);
+  addInPlaceFunction<&anka::topInPlace<bool>, bool, int>(map, "top", &anka::top<bool>);
+  addInPlaceFunction<&anka::topInPlace<std::int64_t>, std::int64_t, int>(map, "top", &anka::top<std::int64_t>);
+  addInPlaceFunction<&anka::topInPlace<float>, float, int>(map, "top", &anka::top<float>);
+  addInPlaceFunction<&anka::topInPlace<std::int8_t>, std::int8_t, int>(map, "top", &anka::top<std::int8_t>);
+  addInPlaceFunction<&anka::topInPlace<std::int16_t>, std::int16_t, int>(map, "top", &anka::top<std::int16_t>);
+  addInPlaceFunction<&anka::topInPlace<std::uint8_t>, std::uint8_t, int>(map, "top", &anka::top<std::uint8_t>);
+  addInPlaceFunction<&anka::bottomInPlace<int>, int, int>(map, "bottom", &anka::bottom<int>);
+  addInPlaceFunction<&anka::bottomInPlace<double>, double, int>(map, "bottom", &anka::bottom<double>);
+  addInPlaceFunction<&anka::bottomInPlace<bool>, bool, int>(map, "bottom", &anka::bottom<bool>);
+  addInPlaceFunction<&anka::bottomInPlace<std::int64_t>, std::int64_t, int>(map, "bottom", &anka::bottom<std::int64_t>);
+  addInPlaceFunction<&anka::bottomInPlace<float>, float, int>(map, "bottom", &anka::bottom<float>);
+  addInPlaceFunction<&anka::bottomInPlace<std::int8_t>, std::int8_t, int>(map, "bottom", &anka::bottom<std::int8_t>);
+  addInPlaceFunction<&anka::bottomInPlace<std::int16_t>, std::int16_t, int>(map, "bottom", &anka::bottom<std::int16_t>);
+  addInPlaceFunction<&anka::bottomInPlace<std::uint8_t>, std::uint8_t, int>(map, "bottom", &anka::bottom<std::uint8_t>);
+
+  addInternalFunction<std::vector<int>, std::vector<int>>(map, "unique", &anka::unique<int>);
+  addInternalFunction<std::vector<double>, std::vector<double>>(map, "unique", &anka::unique<double>);
+  addInternalFunction<BitArray, BitArray>(map, "unique", &anka::unique<bool>);
+  addInternalFunction<std::vector<std::int64_t>, std::vector<std::int64_t>>(map, "unique", &anka::unique<std::int64_t>);
+  addInternalFunction<std::vector<float>, std::vector<float>>(map, "unique", &anka::unique<float>);
+  addInternalFunction<std::vector<std::int8_t>, std::vector<std::int8_t>>(map, "unique", &anka::unique<std::int8_t>);
+  addInternalFunction<std::vector<std::int16_t>, std::vector<std::int16_t>>(map, "unique", &anka::unique<std::int16_t>);
+  addInternalFunction<std::vector<std::uint8_t>, std::vector<std::uint8_t>>(map, "unique", &anka::unique<std::uint8_t>);
+
+  addInternalFunction<Dictionary, std::vector<int>, std::vector<int>>(map, "dict", &anka::dict<int>);
+  addInternalFunction<Dictionary, std::vector<int>, std::vector<double>>(map, "dict", &anka::dict<double>);
+  addInternalFunction<Dictionary, std::vector<int>, BitArray>(map, "dict", &anka::dict<bool>);
+  addInternalFunction<Dictionary, std::vector<int>>(map, "count_by", &anka::count_by);
+  addInternalFunction<std::vector<int>, std::vector<int>>(map, "group", &anka::group);
+  addInternalFunction<std::vector<int>, Dictionary>(map, "keys", &anka::keys);
+
+  addKernelFunction<&anka::add<int>>(map, "add");
+  addKernelFunction<&anka::add<double>>(map, "add");
+  addKernelFunction<&anka::sub<int>>(map, "sub");
+  addKernelFunction<&anka::sub<double>>(map, "sub");
+  addKernelFunction<&anka::mul<int>>(map, "mul");
+  addKernelFunction<&anka::mul<double>>(map, "mul");
+  addKernelFunction<&anka::div<int>>(map, "div");
+  addKernelFunction<&anka::div<double>>(map, "div");
+  addKernelFunction<&anka::minimum<int>>(map, "min");
+  addKernelFunction<&anka::minimum<double>>(map, "min");
+  addKernelFunction<&anka::minimum<std::int64_t>>(map, "min");
+  addKernelFunction<&anka::maximum<int>>(map, "max");
+  addKernelFunction<&anka::maximum<double>>(map, "max");
+  addKernelFunction<&anka::maximum<std::int64_t>>(map, "max");
+
+  addKernelFunction<&anka::inc<std::int64_t>>(map, "inc");
+  addKernelFunction<&anka::dec<std::int64_t>>(map, "dec");
+  addKernelFunction<&anka::neg<std::int64_t>>(map, "neg");
+  addKernelFunction<&anka::abs<std::int64_t>>(map, "abs");
+  addKernelFunction<&anka::is_positive<std::int64_t>>(map, "is_positive");
+  addKernelFunction<&anka::is_negative<std::int64_t>>(map, "is_negative");
+  addKernelFunction<&anka::add<std::int64_t>>(map, "add");
+  addKernelFunction<&anka::sub<std::int64_t>>(map, "sub");
+  addKernelFunction<&anka::mul<std::int64_t>>(map, "mul");
+  addKernelFunction<&anka::div<std::int64_t>>(map, "div");
+  addKernelFunction<&anka::equals<std::int64_t>>(map, "equals");
+  addKernelFunction<&anka::notEquals<std::int64_t>>(map, "not_equals");
+  addKernelFunction<&anka::greaterThan<std::int64_t>>(map, "greater_than");
+  addKernelFunction<&anka::lessThan<std::int64_t>>(map, "less_than");
+
+  addKernelFunction<&anka::andFun>(map, "and");
+  addKernelFunction<&anka::orFun>(map, "or");
+
+  addKernelFunction<&anka::equals<bool>>(map, "equals");
+  addKernelFunction<&anka::equals<int>>(map, "equals");
+  addKernelFunction<&anka::equals<double>>(map, "equals");
+  addKernelFunction<&anka::notEquals<bool>>(map, "not_equals");
+  addKernelFunction<&anka::notEquals<int>>(map, "not_equals");
+  addKernelFunction<&anka::notEquals<double>>(map, "not_equals");
+
+  addKernelFunction<&anka::greaterThan<bool>>(map, "greater_than");
+  addKernelFunction<&anka::greaterThan<int>>(map, "greater_than");
+  addKernelFunction<&anka::greaterThan<double>>(map, "greater_than");
+
+  addKernelFunction<&anka::lessThan<bool>>(map, "less_than");
+  addKernelFunction<&anka::lessThan<int>>(map, "less_than");
+  addKernelFunction<&anka::lessThan<double>>(map, "less_than");
+
+  addKernelFunction<&anka::notFun>(map, "not");
+  addInternalFunction<bool, BitArray>(map, "all_of", &anka::all_of);
+  addInternalFunction<bool, BitArray>(map, "any_of", &anka::any_of);
+  addInternalFunction<bool, BitArray>(map, "none_of", &anka::none_of);
+  addInternalFunction<int, BitArray>(map, "count", &anka::count);
+
+  addInternalFunction<std::int64_t, std::vector<int>>(map, "sum", &anka::sum<int, std::int64_t>);
+  addInternalFunction<double, std::vector<double>>(map, "sum", &anka::sum<double>);
+  addInternalFunction<std::vector<std::int64_t>, NestedArray<int>>(map, "sum", &anka::sumRows<int, std::int64_t>);
+  addInternalFunction<std::vector<double>, NestedArray<double>>(map, "sum", &anka::sumRows<double>);
+  addInternalFunction<std::int64_t, std::vector<std::int64_t>>(map, "sum", &anka::sum<std::int64_t>);
+  addInternalFunction<double, std::vector<float>>(map, "sum", &anka::sum<float, double>);
+  addInternalFunction<std::int64_t, std::vector<std::int8_t>>(map, "sum", &anka::sum<std::int8_t, std::int64_t>);
+  addInternalFunction<std::int64_t, std::vector<std::int16_t>>(map, "sum", &anka::sum<std::int16_t, std::int64_t>);
+  addInternalFunction<std::int64_t, std::vector<std::uint8_t>>(map, "sum", &anka::sum<std::uint8_t, std::int64_t>);
+
+  addInternalFunction<int, double>(map, "to_double", &anka::to_double<int>);
+  addInternalFunction<double, double>(map, "to_double", &anka::to_double<double>);
+  addInternalFunction<std::int64_t, double>(map, "to_double", &anka::to_double<std::int64_t>);
+
+  addKernelFunction<&anka::convert<std::int64_t, int>>(map, "to_long");
+  addKernelFunction<&anka::convert<std::int64_t, std::int64_t>>(map, "to_long");
+  addKernelFunction<&anka::convert<int, int>>(map, "to_int");
+  addKernelFunction<&anka::convert<int, std::int64_t>>(map, "to_int");
+  addKernelFunction<&anka::convert<int, double>>(map, "to_int");
+
+  addInternalFunction<std::vector<float>, std::vector<double>>(map, "to_float", &anka::convertArray<float, double>);
+  addInternalFunction<std::vector<float>, std::vector<int>>(map, "to_float", &anka::convertArray<float, int>);
+  addInternalFunction<std::vector<std::int8_t>, std::vector<int>>(map, "to_int8",
+                                                                  &anka::convertArray<std::int8_t, int>);
+  addInternalFunction<std::vector<std::int8_t>, std::vector<std::int64_t>>(
+      map, "to_int8", &anka::convertArray<std::int8_t, std::int64_t>);
+  addInternalFunction<std::vector<std::int16_t>, std::vector<int>>(map, "to_int16",
+                                                                   &anka::convertArray<std::int16_t, int>);
+  addInternalFunction<std::vector<std::int16_t>, std::vector<std::int64_t>>(
+      map, "to_int16", &anka::convertArray<std::int16_t, std::int64_t>);
+  addInternalFunction<std::vector<std::uint8_t>, std::vector<int>>(map, "to_uint8",
+                                                                   &anka::convertArray<std::uint8_t, int>);
+  addInternalFunction<std::vector<std::uint8_t>, std::vector<std::int64_t>>(
+      map, "to_uint8", &anka::convertArray<std::uint8_t, std::int64_t>);
+
+  addInternalFunction<bool, anka::BinaryOpt<bool, bool>, BitArray>(map, "foldl", &anka::foldl<bool, bool>);
+  addInternalFunction<std::int64_t, anka::BinaryOpt<int, int>, std::vector<int>>(map, "foldl",
+                                                                                 &anka::foldl<int, std::int64_t>);
+  addInternalFunction<double, anka::BinaryOpt<double, double>, std::vector<double>>(map, "foldl",
+                                                                                    &anka::foldl<double, double>);
+  addInternalFunction<std::vector<int>, anka::BinaryOpt<int, int>, NestedArray<int>>(map, "foldl",
+                                                                                     &anka::foldlRows<int>);
+  addInternalFunction<std::vector<double>, anka::BinaryOpt<double, double>, NestedArray<double>>(
+      map, "foldl", &anka::foldlRows<double>);
+  addInternalFunction<std::int64_t, anka::BinaryOpt<std::int64_t, std::int64_t>, std::vector<std::int64_t>>(
+      map, "foldl", &anka::foldl<std::int64_t, std::int64_t>);
+
+  addInPlaceFunction<&anka::scanlInPlace<bool>, bool, anka::BinaryOpt<bool, bool>>(map, "scanl",
+                                                                                   &anka::scanl<bool, bool>);
+  addInPlaceFunction<&anka::scanlInPlace<int>, int, anka::BinaryOpt<int, int>>(map, "scanl", &anka::scanl<int, int>);
+  addInPlaceFunction<&anka::scanlInPlace<double>, double, anka::BinaryOpt<double, double>>(
+      map, "scanl", &anka::scanl<double, double>);
+  addInPlaceFunction<&anka::scanlInPlace<std::int64_t>, std::int64_t, anka::BinaryOpt<std::int64_t, std::int64_t>>(
+      map, "scanl", &anka::scanl<std::int64_t, std::int64_t>);
+
+  addInPlaceFunction<&anka::filterInPlace<bool, anka::FilterFunc<bool>>, bool, anka::FilterFunc<bool>>(
       map, "filter", &anka::filter<bool, anka::FilterFunc<bool>>);
-  addInternalFunction<std::vector<int>, anka::FilterFunc<int>, std::vector<int>>(
+  addInPlaceFunction<&anka::filterInPlace<int, anka::FilterFunc<int>>, int, anka::FilterFunc<int>>(
       map, "filter", &anka::filter<int, anka::FilterFunc<int>>);
-  addInternalFunction<std::vector<double>, anka::FilterFunc<double>, std::vector<double>>(
+  addInPlaceFunction<&anka::filterInPlace<double, anka::FilterFunc<double>>, double, anka::FilterFunc<double>>(
       map, "filter", &anka::filter<double, anka::FilterFunc<double>>);
 
-  addInternalFunction<std::vector<bool>, std::vector<bool>, std::vector<bool>>(map, "filter",
-                                                                               &anka::filterWithVec<bool>);
-  addInternalFunction<std::vector<int>, std::vector<bool>, std::vector<int>>(map, "filter", &anka::filterWithVec<int>);
-  addInternalFunction<std::vector<double>, std::vector<bool>, std::vector<double>>(map, "filter",
-                                                                                   &anka::filterWithVec<double>);
+  addInPlaceFunction<&anka::filterWithVecInPlace<bool>, bool, BitArray>(map, "filter", &anka::filterWithVec<bool>);
+  addInPlaceFunction<&anka::filterWithVecInPlace<int>, int, BitArray>(map, "filter", &anka::filterWithVec<int>);
+  addInPlaceFunction<&anka::filterWithVecInPlace<double>, double, BitArray>(map, "filter",
+                                                                            &anka::filterWithVec<double>);
 
-  functionMapOpt = std::move(map);
-  return functionMapOpt.value();
+  return map;
 }
 
-// Internal constants
+// The tables of the internal functions are built by the first thread that uses them, statics are initialised only
+// once even when threads race for them, and never change afterwards. Every context and thread reads the same tables.
+export auto getInternalFunctions() -> const InternalFunctionMaptype &
+{
+  static const auto functionMap = createInternalFunctions();
+  return functionMap;
+}
 
-auto getInternalDoubleConstants() -> const std::unordered_map<std::string, double> &
+// Fusable pipeline stages: element-wise functions that keep the element type, either unary (inc, neg, sqrt...)
+// or binary with a bound scalar lhs (add[1], mul[2]...).
+
+export template <typename T> struct PipelineStage
+{
+  UnaryArrayKernel<T> unary = nullptr;
+  BoundArrayKernel<T> bound = nullptr;
+  T scalar{};
+};
+
+template <typename T> auto createUnaryArrayKernels() -> std::unordered_map<std::string, UnaryArrayKernel<T>>
+{
+  std::unordered_map<std::string, UnaryArrayKernel<T>> map;
+  map["inc"] = &unaryKernel<&anka::inc<T>, T, T>;
+  map["dec"] = &unaryKernel<&anka::dec<T>, T, T>;
+  map["neg"] = &unaryKernel<&anka::neg<T>, T, T>;
+  map["abs"] = &unaryKernel<&anka::abs<T>, T, T>;
+
+  if constexpr (std::is_same_v<T, double>)
+  {
+    typedef double (*DoubleToDoubleFunc)(double);
+    map["sqrt"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::sqrt), double, double>;
+    map["exp"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::exp), double, double>;
+    map["log"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::log), double, double>;
+    map["log10"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::log10), double, double>;
+    map["sin"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::sin), double, double>;
+    map["cos"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::cos), double, double>;
+    map["tan"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::tan), double, double>;
+    map["floor"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::floor), double, double>;
+    map["ceil"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::ceil), double, double>;
+    map["trunc"] = &unaryKernel<static_cast<DoubleToDoubleFunc>(&std::trunc), double, double>;
+  }
+
+  return map;
+}
+
+template <typename T> auto getUnaryArrayKernels() -> const std::unordered_map<std::string, UnaryArrayKernel<T>> &
+{
+  static const auto kernels = createUnaryArrayKernels<T>();
+  return kernels;
+}
+
+template <typename T> auto createBoundArrayKernels() -> std::unordered_map<std::string, BoundArrayKernel<T>>
+{
+  std::unordered_map<std::string, BoundArrayKernel<T>> map;
+  map["add"] = &binaryKernelScalarLhs<&anka::add<T>, T, T>;
+  map["sub"] = &binaryKernelScalarLhs<&anka::sub<T>, T, T>;
+  map["mul"] = &binaryKernelScalarLhs<&anka::mul<T>, T, T>;
+  map["div"] = &binaryKernelScalarLhs<&anka::div<T>, T, T>;
+
+  return map;
+}
+
+template <typename T> auto getBoundArrayKernels() -> const std::unordered_map<std::string, BoundArrayKernel<T>> &
+{
+  static const auto kernels = createBoundArrayKernels<T>();
+  return kernels;
+}
+
+export template <typename T> auto getUnaryArrayKernel(const std::string &name) -> UnaryArrayKernel<T>
+{
+  const auto &map = getUnaryArrayKernels<T>();
+  auto iter = map.find(name);
+  return iter == map.end() ? nullptr : iter->second;
+}
+
+export template <typename T> auto getBoundArrayKernel(const std::string &name) -> BoundArrayKernel<T>
+{
+  const auto &map = getBoundArrayKernels<T>();
+  auto iter = map.find(name);
+  return iter == map.end() ? nullptr : iter->second;
+}
+
+auto wrappingAdd(int lhs, int rhs) -> int
+{
+  return static_cast<int>(static_cast<unsigned>(lhs) + static_cast<unsigned>(rhs));
+}
+
+auto wrappingMul(int lhs, int rhs) -> int
+{
+  return static_cast<int>(static_cast<unsigned>(lhs) * static_cast<unsigned>(rhs));
+}
+
+auto getRangeArgument(const Context &context, const std::vector<Word> &arguments, size_t index)
+    -> std::optional<IntegerRange>
+{
+  if (arguments.size() <= index || arguments[index].type != WordType::IntegerRange)
+    return std::nullopt;
+  return context.integerRanges[arguments[index].index];
+}
+
+auto getIntArgument(const Context &context, const std::vector<Word> &arguments, size_t index) -> std::optional<int>
+{
+  if (arguments.size() <= index || arguments[index].type != WordType::IntegerNumber)
+    return std::nullopt;
+  return context.integerNumbers[arguments[index].index];
+}
+
+auto rangeIoata(Context &context, const std::vector<Word> &arguments) -> std::optional<Word>
+{
+  const auto n = getIntArgument(context, arguments, 0);
+  if (arguments.size() != 1 || !n)
+    return std::nullopt;
+  return createWord(context, IntegerRange{1, 1, static_cast<size_t>(std::max(0, n.value()))});
+}
+
+// Element-wise function of one range, map gives the start and step of the result.
+template <auto map> auto rangeUnary(Context &context, const std::vector<Word> &arguments) -> std::optional<Word>
+{
+  const auto range = getRangeArgument(context, arguments, 0);
+  if (arguments.size() != 1 || !range)
+    return std::nullopt;
+  return createWord(context, map(range.value()));
+}
+
+// Element-wise function of a range and an integer, map gets the range and the integer and whether the integer is
+// the left argument.
+template <auto map> auto rangeBinary(Context &context, const std::vector<Word> &arguments) -> std::optional<Word>
+{
+  if (arguments.size() != 2)
+    return std::nullopt;
+
+  if (auto range = getRangeArgument(context, arguments, 0))
+  {
+    if (auto scalar = getIntArgument(context, arguments, 1))
+      return createWord(context, map(range.value(), scalar.value(), false));
+  }
+  else if (auto range = getRangeArgument(context, arguments, 1))
+  {
+    if (auto scalar = getIntArgument(context, arguments, 0))
+      return createWord(context, map(range.value(), scalar.value(), true));
+  }
+  return std::nullopt;
+}
+
+auto incRange(IntegerRange range) -> IntegerRange
+{
+  return {wrappingAdd(range.start, 1), range.step, range.length};
+}
+
+auto decRange(IntegerRange range) -> IntegerRange
+{
+  return {wrappingAdd(range.start, -1), range.step, range.length};
+}
+
+auto negRange(IntegerRange range) -> IntegerRange
+{
+  return {wrappingMul(range.start, -1), wrappingMul(range.step, -1), range.length};
+}
+
+auto addRange(IntegerRange range, int value, bool) -> IntegerRange
+{
+  return {wrappingAdd(range.start, value), range.step, range.length};
+}
+
+auto subRange(IntegerRange range, int value, bool valueFirst) -> IntegerRange
+{
+  if (valueFirst)
+    return {wrappingAdd(value, wrappingMul(range.start, -1)), wrappingMul(range.step, -1), range.length};
+  return {wrappingAdd(range.start, wrappingMul(value, -1)), range.step, range.length};
+}
+
+auto mulRange(IntegerRange range, int value, bool) -> IntegerRange
+{
+  return {wrappingMul(range.start, value), wrappingMul(range.step, value), range.length};
+}
+
+auto rangeSum(Context &context, const std::vector<Word> &arguments) -> std::optional<Word>
+{
+  const auto range = getRangeArgument(context, arguments, 0);
+  if (arguments.size() != 1 || !range)
+    return std::nullopt;
+
+  // n * start + step * n * (n - 1) / 2 in 64 bits like the sum of the elements
+  const auto n = static_cast<unsigned long long>(range->length);
+  const auto triangle = n % 2 == 0 ? (n / 2) * (n - 1) : n * ((n - 1) / 2);
+  const auto sum = n * static_cast<unsigned long long>(static_cast<long long>(range->start)) +
+                   triangle * static_cast<unsigned long long>(static_cast<long long>(range->step));
+  return createWord(context, static_cast<std::int64_t>(sum));
+}
+
+auto rangeLength(Context &context, const std::vector<Word> &arguments) -> std::optional<Word>
+{
+  const auto range = getRangeArgument(context, arguments, 0);
+  if (arguments.size() != 1 || !range)
+    return std::nullopt;
+  return createWord(context, static_cast<int>(range->length));
+}
+
+auto createRangeFunctions() -> std::unordered_map<std::string, RangeFunction>
+{
+  std::unordered_map<std::string, RangeFunction> map;
+  map["ioata"] = &rangeIoata;
+  map["sum"] = &rangeSum;
+  map["length"] = &rangeLength;
+  map["inc"] = &rangeUnary<&incRange>;
+  map["dec"] = &rangeUnary<&decRange>;
+  map["neg"] = &rangeUnary<&negRange>;
+  map["add"] = &rangeBinary<&addRange>;
+  map["sub"] = &rangeBinary<&subRange>;
+  map["mul"] = &rangeBinary<&mulRange>;
+
+  return map;
+}
+
+auto getRangeFunctions() -> const std::unordered_map<std::string, RangeFunction> &
+{
+  static const auto functions = createRangeFunctions();
+  return functions;
+}
+
+// Returns the function that keeps integer ranges lazy for the name, ioata creates the ranges.
+export auto getRangeFunction(const std::string &name) -> RangeFunction
 {
-  static std::optional<std::unordered_map<std::string, double>> mapOpt;
-  if (mapOpt.has_value())
-    return mapOpt.value();
+  const auto &map = getRangeFunctions();
+  auto iter = map.find(name);
+  return iter == map.end() ? nullptr : iter->second;
+}
 
+// Runs all stages over one block before moving to the next, so only the final result is allocated and the
+// intermediate values stay in cache.
+// Writes the result to res, which has the size of vec and can be vec itself.
+export template <typename T>
+auto applyPipeline(const std::vector<T> &vec, const std::vector<PipelineStage<T>> &stages, std::vector<T> &res)
+    -> void
+{
+  forEachBlock(vec.size(), [&](size_t begin, size_t count) {
+    const T *in = vec.data() + begin;
+    T *out = res.data() + begin;
+    for (const auto &stage : stages)
+    {
+      if (stage.unary)
+        stage.unary(in, out, count);
+      else
+        stage.bound(stage.scalar, in, out, count);
+      in = out;
+    }
+  });
+}
+
+export template <typename T>
+auto applyPipeline(const std::vector<T> &vec, const std::vector<PipelineStage<T>> &stages) -> std::vector<T>
+{
+  std::vector<T> res(vec.size());
+  applyPipeline(vec, stages, res);
+  return res;
+}
+
+// Internal constants
+
+auto createInternalDoubleConstants() -> std::unordered_map<std::string, double>
+{
   std::unordered_map<std::string, double> map;
   map["pi"] = std::numbers::pi;
   map["e"] = std::numbers::e;
 
-  mapOpt = std::move(map);
-  return mapOpt.value();
+  return map;
+}
+
+auto getInternalDoubleConstants() -> const std::unordered_map<std::string, double> &
+{
+  static const auto constants = createInternalDoubleConstants();
+  return constants;
 }
 
 export template <typename T> auto getInternalConstants() -> const std::unordered_map<std::string, T> &
@@ -612,13 +2044,97 @@ export template <typename T> auto getInternalConstants() -> const std::unordered
   ();
 }
 
-export auto getInternalFunctionDefinitionsWithName(const std::string &name) -> std::vector<InternalFunctionDefinition>
+// All overloads of the internal functions grouped by name
+auto createInternalFunctionIndex() -> std::unordered_map<std::string, std::vector<InternalFunctionDefinition>>
 {
-  auto kv = ranges::views::keys(getInternalFunctions());
-  std::vector<anka::InternalFunctionDefinition> definitions{kv.begin(), kv.end()};
+  std::unordered_map<std::string, std::vector<InternalFunctionDefinition>> index;
+  for (auto &&definition : ranges::views::keys(getInternalFunctions()))
+  {
+    index[definition.name].push_back(definition);
+  }
+
+  return index;
+}
+
+auto getInternalFunctionIndex() -> const std::unordered_map<std::string, std::vector<InternalFunctionDefinition>> &
+{
+  static const auto index = createInternalFunctionIndex();
+  return index;
+}
+
+auto createInternalFunctionNames() -> std::vector<std::string>
+{
+  auto names = ranges::views::keys(getInternalFunctionIndex()) | ranges::to<std::vector<std::string>>();
+  std::sort(names.begin(), names.end());
+
+  return names;
+}
+
+auto anka::getInternalFunctionNames() -> const std::vector<std::string> &
+{
+  static const auto names = createInternalFunctionNames();
+  return names;
+}
+
+// Contexts intern the internal function names first, so their name ids are the same in every context.
+auto createInternalFunctionDefinitionsById() -> std::vector<std::vector<InternalFunctionDefinition>>
+{
+  std::vector<std::vector<InternalFunctionDefinition>> definitions;
+  for (const auto &name : getInternalFunctionNames())
+  {
+    definitions.push_back(getInternalFunctionIndex().at(name));
+  }
 
-  return definitions | ranges::views::filter([&name](const auto &def) { return def.name == name; }) |
-         ranges::to<std::vector<InternalFunctionDefinition>>;
+  return definitions;
+}
+
+auto getInternalFunctionDefinitionsById() -> const std::vector<std::vector<InternalFunctionDefinition>> &
+{
+  static const auto definitions = createInternalFunctionDefinitionsById();
+  return definitions;
+}
+
+// Builds the tables of the internal functions that are otherwise built on first use, so that work spread over threads
+// or scripts does not wait for them.
+export auto loadInternalFunctions() -> void
+{
+  getInternalFunctionDefinitionsById();
+  getUnaryArrayKernels<int>();
+  getUnaryArrayKernels<double>();
+  getBoundArrayKernels<int>();
+  getBoundArrayKernels<double>();
+  getRangeFunctions();
+  getInternalConstants<double>();
+}
+
+export auto getInternalFunctionDefinitionsWithId(size_t nameId) -> const std::vector<InternalFunctionDefinition> &
+{
+  static const std::vector<InternalFunctionDefinition> noDefinitions;
+
+  const auto &definitions = getInternalFunctionDefinitionsById();
+  return nameId < definitions.size() ? definitions[nameId] : noDefinitions;
+}
+
+export auto isInternalFunction(size_t nameId) -> bool
+{
+  return nameId < getInternalFunctionNames().size();
+}
+
+export auto getInternalFunctionDefinitionsWithName(const std::string &name)
+    -> const std::vector<InternalFunctionDefinition> &
+{
+  static const std::vector<InternalFunctionDefinition> noDefinitions;
+
+  const auto &index = getInternalFunctionIndex();
+  if (auto iter = index.find(name); iter != index.end())
+    return iter->second;
+
+  return noDefinitions;
+}
+
+export auto isInternalFunction(const std::string &name) -> bool
+{
+  return getInternalFunctionIndex().contains(name);
 }
 
 export auto toType(WordType wtype) -> TypeVariant
@@ -637,6 +2153,28 @@ export auto toType(WordType wtype) -> TypeVariant
     return TypeFamily::Bool;
   case WordType::BooleanArray:
     return TypeFamily::BoolArray;
+  case WordType::IntegerRange:
+    return TypeFamily::IntArray;
+  case WordType::Dictionary:
+    return TypeFamily::Dictionary;
+  case WordType::NestedIntegerArray:
+    return TypeFamily::NestedIntArray;
+  case WordType::NestedDoubleArray:
+    return TypeFamily::NestedDoubleArray;
+  case WordType::NestedBooleanArray:
+    return TypeFamily::NestedBoolArray;
+  case WordType::LongNumber:
+    return TypeFamily::Long;
+  case WordType::LongArray:
+    return TypeFamily::LongArray;
+  case WordType::FloatArray:
+    return TypeFamily::FloatArray;
+  case WordType::Int8Array:
+    return TypeFamily::Int8Array;
+  case WordType::Int16Array:
+    return TypeFamily::Int16Array;
+  case WordType::UInt8Array:
+    return TypeFamily::UInt8Array;
   case WordType::Name:
     return TypeFamily::Void; // return function variant here
   default:
@@ -649,7 +2187,7 @@ template <typename T> auto injectInternalConstants(anka::Context &context) -> vo
   auto &&map = anka::getInternalConstants<T>();
   for (auto &&pair : map)
   {
-    context.userDefinedNames[pair.first] = createWord(context, pair.second);
+    setUserDefinedName(context, internName(context, pair.first), createWord(context, pair.second));
   }
 }
 
@@ -1,9 +1,18 @@
 module;
 #include <algorithm>
+#include <cstdint>
 #include <format>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
 #include <optional>
 #include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 
 #include <fmt/ranges.h>
@@ -17,6 +26,10 @@ module;
 export module anka:interpreter_state;
 
 import :tokenizer;
+import :bit_array;
+import :dictionary;
+import :nested_array;
+import :profiler;
 
 namespace anka
 {
@@ -34,7 +47,18 @@ export enum class WordType
   PlaceHolder,
   Executor,
   Block,
-  Assignment
+  Assignment,
+  IntegerRange,
+  Dictionary,
+  NestedIntegerArray,
+  NestedDoubleArray,
+  LongNumber,
+  LongArray,
+  FloatArray,
+  Int8Array,
+  Int16Array,
+  UInt8Array,
+  NestedBooleanArray
 };
 
 export struct Word
@@ -50,9 +74,76 @@ export struct Sentence
   std::vector<Word> words;
 };
 
+export struct Context;
+
+// Integer array start, start + step, start + 2 * step, ... that is only materialized when a function needs its
+// elements. Arithmetic wraps around like it does on materialized int arrays.
+export struct IntegerRange
+{
+  int start = 0;
+  int step = 1;
+  size_t length = 0;
+
+  auto operator[](size_t index) const -> int
+  {
+    return static_cast<int>(static_cast<unsigned>(start) + static_cast<unsigned>(step) * static_cast<unsigned>(index));
+  }
+
+  auto operator<=>(const IntegerRange &) const = default;
+};
+
+// Function that keeps integer ranges lazy, gets the argument words with the names resolved. Returns nothing if it
+// can not handle the arguments.
+export using RangeFunction = std::optional<Word> (*)(Context &, const std::vector<Word> &);
+
+export using InternalFunctionExecuter =
+    std::function<std::optional<Word>(Context &, const std::vector<Word> &, const std::vector<bool> &expandArray)>;
+
+export template <typename T> using UnaryArrayKernel = void (*)(const T *, T *, size_t);
+export template <typename T> using BoundArrayKernel = void (*)(T, const T *, T *, size_t);
+
+// Overload resolution of the function called at one position of a compiled word list. It is reused while the
+// argument words have the same types, the same names and the user defined names did not change.
+export struct CallSite
+{
+  std::optional<size_t> namesVersion;
+  std::vector<Word> arguments;
+  std::vector<Word> resolvedArguments;
+  const InternalFunctionExecuter *executer = nullptr;
+  std::vector<bool> expandArray;
+  bool expandsNestedValues = false;
+};
+
+// Everything about a word that can be decided before executing it.
+export struct Instruction
+{
+  bool isInternalFunction = false;
+
+  // number of arguments of the internal function a tuple is connected to
+  std::optional<size_t> connectedArity;
+
+  UnaryArrayKernel<int> unaryIntKernel = nullptr;
+  UnaryArrayKernel<double> unaryDoubleKernel = nullptr;
+  BoundArrayKernel<int> boundIntKernel = nullptr;
+  BoundArrayKernel<double> boundDoubleKernel = nullptr;
+  RangeFunction rangeFunction = nullptr;
+
+  CallSite callSite;
+};
+
+// A word list lowered for execution, instructions[i] belongs to words[i].
+export struct CompiledWords
+{
+  std::vector<Word> words;
+  std::vector<Instruction> instructions;
+};
+
 export struct Block
 {
   std::vector<Word> words;
+
+  // compiled on first use, shared so that executing a block does not depend on the block pool
+  std::shared_ptr<CompiledWords> compiled;
 };
 
 export struct Tuple
@@ -71,31 +162,338 @@ export struct PlaceHolder
   size_t index;
 };
 
+// Result of a pure block or executor applied to an argument.
+export struct MemoEntry
+{
+  Word function;
+  Word argument;
+  // hash of the content of the argument, an argument without one only matches itself
+  std::optional<size_t> hash;
+  Word result;
+  size_t lastUse = 0;
+};
+
+// Memoization is off while the capacity is 0. The words of the entries stay alive like the user defined names, the
+// least recently used entry is dropped when the cache is full.
+export struct MemoCache
+{
+  size_t capacity = 0;
+  size_t useCount = 0;
+  std::vector<MemoEntry> entries;
+};
+
+// Names of the internal functions, every context interns them first.
+export auto getInternalFunctionNames() -> const std::vector<std::string> &;
+
+// Values of one word type, a word's index is its position. A pool can continue the pool of another context: the
+// values of that pool keep their indices and are read in place, the values added later are stored after them.
+export template <typename T> class Pool
+{
+public:
+  using value_type = T;
+  using reference = std::vector<T>::reference;
+  using const_reference = std::vector<T>::const_reference;
+
+  Pool() = default;
+  Pool(std::vector<T> values) : values_(std::move(values))
+  {
+  }
+
+  // parent must outlive the pool and must not change while the pool is used
+  auto inherit(const Pool &parent) -> void
+  {
+    parent_ = &parent;
+    base_ = parent.size();
+    values_.clear();
+  }
+
+  auto isInherited(size_t index) const -> bool
+  {
+    return index < base_;
+  }
+
+  // inherited values are only read, the mutable reference is for the values of this pool
+  auto operator[](size_t index) -> reference
+  {
+    return index < base_ ? const_cast<Pool &>(*parent_)[index] : values_[index - base_];
+  }
+
+  auto operator[](size_t index) const -> const_reference
+  {
+    return index < base_ ? (*parent_)[index] : values_[index - base_];
+  }
+
+  auto size() const -> size_t
+  {
+    return base_ + values_.size();
+  }
+
+  auto empty() const -> bool
+  {
+    return size() == 0;
+  }
+
+  auto push_back(T value) -> void
+  {
+    values_.push_back(std::move(value));
+  }
+
+  // sizes at or above the inherited values
+  auto resize(size_t size) -> void
+  {
+    values_.resize(size - base_);
+  }
+
+  auto truncate(size_t size) -> void
+  {
+    values_.erase(values_.begin() + (size - base_), values_.end());
+  }
+
+  template <typename Iter> auto assign(Iter first, Iter last) -> void
+  {
+    values_.assign(first, last);
+  }
+
+  // the values stored in this pool, without the inherited ones
+  auto values() -> std::vector<T> &
+  {
+    return values_;
+  }
+
+  auto values() const -> const std::vector<T> &
+  {
+    return values_;
+  }
+
+  auto begin()
+  {
+    return values_.begin();
+  }
+
+  auto begin() const
+  {
+    return values_.begin();
+  }
+
+  auto end()
+  {
+    return values_.end();
+  }
+
+  auto end() const
+  {
+    return values_.end();
+  }
+
+  friend auto operator==(const Pool &pool, const std::vector<T> &values) -> bool
+  {
+    if (pool.size() != values.size())
+      return false;
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      if (pool[i] != values[i])
+        return false;
+    }
+    return true;
+  }
+
+private:
+  const Pool *parent_ = nullptr;
+  size_t base_ = 0;
+  std::vector<T> values_;
+};
+
+export struct Context;
+
+// Argument of the constructor of a context that inherits from parent, see inheritContext.
+export struct Inherit
+{
+  const Context &parent;
+};
+
 export struct Context
 {
-  std::vector<int> integerNumbers;
-  std::vector<std::vector<int>> integerArrays;
-  std::vector<double> doubleNumbers;
-  std::vector<std::vector<double>> doubleArrays;
-  std::vector<bool> booleans;
-  std::vector<std::vector<bool>> booleanArrays;
-  std::unordered_map<std::string, Word> userDefinedNames;
+  Context();
+  // does not copy the internal function names first, it takes all names of the parent
+  explicit Context(Inherit inherit);
+
+  Pool<int> integerNumbers;
+  Pool<std::vector<int>> integerArrays;
+  Pool<double> doubleNumbers;
+  Pool<std::vector<double>> doubleArrays;
+  Pool<bool> booleans;
+  Pool<BitArray> booleanArrays;
+  Pool<IntegerRange> integerRanges;
+  Pool<Dictionary> dictionaries;
+  Pool<NestedArray<int>> nestedIntegerArrays;
+  Pool<NestedArray<double>> nestedDoubleArrays;
+  Pool<NestedArray<bool>> nestedBooleanArrays;
+  // storage kinds, their elements are widened to int, long or double when functions expand them
+  Pool<std::int64_t> longNumbers;
+  Pool<std::vector<std::int64_t>> longArrays;
+  Pool<std::vector<float>> floatArrays;
+  Pool<std::vector<std::int8_t>> int8Arrays;
+  Pool<std::vector<std::int16_t>> int16Arrays;
+  Pool<std::vector<std::uint8_t>> uint8Arrays;
+
+  // symbol table, a name word's index is the id of its name
   std::vector<std::string> names;
-  std::vector<Tuple> tuples;
-  std::vector<Executor> executors;
-  std::vector<Block> blocks;
+  std::unordered_map<std::string, size_t> nameIds;
+  // values of user defined names indexed by name id
+  std::vector<std::optional<Word>> userDefinedNames;
+
+  Pool<Tuple> tuples;
+  Pool<Executor> executors;
+  Pool<Block> blocks;
 
   bool assignNext = false;
+
+  // array argument of the internal function being called that nothing else references, its storage can be reused
+  std::optional<Word> ownedArgument;
+
+  // changes whenever a user defined name is added or moved
+  size_t namesVersion = 0;
+
+  // compiled words of the inherited blocks, executing writes their call sites so every context compiles its own
+  std::unordered_map<size_t, std::shared_ptr<CompiledWords>> inheritedBlocks;
+
+  MemoCache memo;
 };
 
+Context::Context() : names(getInternalFunctionNames()), userDefinedNames(names.size())
+{
+  for (size_t id = 0; id < names.size(); ++id)
+    nameIds.emplace(names[id], id);
+}
+
+// Makes the context read the values and names of parent in place, the values it creates stay its own and are moved
+// back with moveWord. Parent must outlive the context and must not change while the context is used.
+export auto inheritContext(Context &context, const Context &parent) -> void
+{
+  context.integerNumbers.inherit(parent.integerNumbers);
+  context.integerArrays.inherit(parent.integerArrays);
+  context.doubleNumbers.inherit(parent.doubleNumbers);
+  context.doubleArrays.inherit(parent.doubleArrays);
+  context.booleans.inherit(parent.booleans);
+  context.booleanArrays.inherit(parent.booleanArrays);
+  context.integerRanges.inherit(parent.integerRanges);
+  context.dictionaries.inherit(parent.dictionaries);
+  context.nestedIntegerArrays.inherit(parent.nestedIntegerArrays);
+  context.nestedDoubleArrays.inherit(parent.nestedDoubleArrays);
+  context.nestedBooleanArrays.inherit(parent.nestedBooleanArrays);
+  context.longNumbers.inherit(parent.longNumbers);
+  context.longArrays.inherit(parent.longArrays);
+  context.floatArrays.inherit(parent.floatArrays);
+  context.int8Arrays.inherit(parent.int8Arrays);
+  context.int16Arrays.inherit(parent.int16Arrays);
+  context.uint8Arrays.inherit(parent.uint8Arrays);
+  context.tuples.inherit(parent.tuples);
+  context.executors.inherit(parent.executors);
+  context.blocks.inherit(parent.blocks);
+
+  context.names = parent.names;
+  context.nameIds = parent.nameIds;
+  context.userDefinedNames = parent.userDefinedNames;
+  context.namesVersion = parent.namesVersion;
+  context.inheritedBlocks.clear();
+}
+
+Context::Context(Inherit inherit)
+{
+  inheritContext(*this, inherit.parent);
+}
+
+// Whether the word refers to a value the context reads from the context it inherited from.
+export auto isInherited(const Context &context, const Word &word) -> bool
+{
+  switch (word.type)
+  {
+  case WordType::IntegerNumber:
+    return context.integerNumbers.isInherited(word.index);
+  case WordType::IntegerArray:
+    return context.integerArrays.isInherited(word.index);
+  case WordType::DoubleNumber:
+    return context.doubleNumbers.isInherited(word.index);
+  case WordType::DoubleArray:
+    return context.doubleArrays.isInherited(word.index);
+  case WordType::Boolean:
+    return context.booleans.isInherited(word.index);
+  case WordType::BooleanArray:
+    return context.booleanArrays.isInherited(word.index);
+  case WordType::IntegerRange:
+    return context.integerRanges.isInherited(word.index);
+  case WordType::Dictionary:
+    return context.dictionaries.isInherited(word.index);
+  case WordType::NestedIntegerArray:
+    return context.nestedIntegerArrays.isInherited(word.index);
+  case WordType::NestedDoubleArray:
+    return context.nestedDoubleArrays.isInherited(word.index);
+  case WordType::NestedBooleanArray:
+    return context.nestedBooleanArrays.isInherited(word.index);
+  case WordType::LongNumber:
+    return context.longNumbers.isInherited(word.index);
+  case WordType::LongArray:
+    return context.longArrays.isInherited(word.index);
+  case WordType::FloatArray:
+    return context.floatArrays.isInherited(word.index);
+  case WordType::Int8Array:
+    return context.int8Arrays.isInherited(word.index);
+  case WordType::Int16Array:
+    return context.int16Arrays.isInherited(word.index);
+  case WordType::UInt8Array:
+    return context.uint8Arrays.isInherited(word.index);
+  case WordType::Tuple:
+    return context.tuples.isInherited(word.index);
+  case WordType::Executor:
+    return context.executors.isInherited(word.index);
+  case WordType::Block:
+    return context.blocks.isInherited(word.index);
+  default:
+    return false;
+  }
+}
+
+// Id of the name, a name that was not seen before gets the next id.
+export auto internName(Context &context, const std::string &name) -> size_t
+{
+  auto [iter, inserted] = context.nameIds.emplace(name, context.names.size());
+  if (inserted)
+  {
+    context.names.push_back(name);
+    context.userDefinedNames.emplace_back();
+  }
+  return iter->second;
+}
+
+export auto findNameId(const Context &context, const std::string &name) -> std::optional<size_t>
+{
+  if (auto iter = context.nameIds.find(name); iter != context.nameIds.end())
+    return iter->second;
+  return std::nullopt;
+}
+
+export auto setUserDefinedName(Context &context, size_t nameId, const Word &word) -> void
+{
+  context.userDefinedNames[nameId] = word;
+  ++context.namesVersion;
+}
+
+export auto findUserDefinedName(const Context &context, const std::string &name) -> std::optional<Word>
+{
+  if (auto nameId = findNameId(context, name))
+    return context.userDefinedNames[nameId.value()];
+  return std::nullopt;
+}
+
 export template <typename T> struct ValueReturnType
 {
   using ReturnType = T;
 };
 
-export template <> struct ValueReturnType<std::vector<bool>>
+export template <> struct ValueReturnType<BitArray>
 {
-  using ReturnType = const std::vector<bool> &;
+  using ReturnType = const BitArray &;
 };
 
 export template <> struct ValueReturnType<std::vector<int>>
@@ -108,6 +506,31 @@ export template <> struct ValueReturnType<std::vector<double>>
   using ReturnType = const std::vector<double> &;
 };
 
+export template <> struct ValueReturnType<NestedArray<int>>
+{
+  using ReturnType = const NestedArray<int> &;
+};
+
+export template <> struct ValueReturnType<NestedArray<double>>
+{
+  using ReturnType = const NestedArray<double> &;
+};
+
+export template <> struct ValueReturnType<NestedArray<bool>>
+{
+  using ReturnType = const NestedArray<bool> &;
+};
+
+export template <typename T> struct ValueReturnType<std::vector<T>>
+{
+  using ReturnType = const std::vector<T> &;
+};
+
+export template <> struct ValueReturnType<Dictionary>
+{
+  using ReturnType = const Dictionary &;
+};
+
 export template <> struct ValueReturnType<bool>
 {
   using ReturnType = bool;
@@ -141,12 +564,32 @@ export template <typename T> auto getValue(const Context &context, size_t index)
     return context.blocks[index];
   else if constexpr (std::is_same_v<Decayed, bool>)
     return context.booleans[index];
-  else if constexpr (std::is_same_v<Decayed, std::vector<bool>>)
+  else if constexpr (std::is_same_v<Decayed, BitArray>)
     return context.booleanArrays[index];
   else if constexpr (std::is_same_v<Decayed, double>)
     return context.doubleNumbers[index];
   else if constexpr (std::is_same_v<Decayed, std::vector<double>>)
     return context.doubleArrays[index];
+  else if constexpr (std::is_same_v<Decayed, Dictionary>)
+    return context.dictionaries[index];
+  else if constexpr (std::is_same_v<Decayed, NestedArray<int>>)
+    return context.nestedIntegerArrays[index];
+  else if constexpr (std::is_same_v<Decayed, NestedArray<double>>)
+    return context.nestedDoubleArrays[index];
+  else if constexpr (std::is_same_v<Decayed, NestedArray<bool>>)
+    return context.nestedBooleanArrays[index];
+  else if constexpr (std::is_same_v<Decayed, std::int64_t>)
+    return context.longNumbers[index];
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int64_t>>)
+    return context.longArrays[index];
+  else if constexpr (std::is_same_v<Decayed, std::vector<float>>)
+    return context.floatArrays[index];
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int8_t>>)
+    return context.int8Arrays[index];
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int16_t>>)
+    return context.int16Arrays[index];
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::uint8_t>>)
+    return context.uint8Arrays[index];
   else
     []<bool flag = false>()
     {
@@ -155,20 +598,68 @@ export template <typename T> auto getValue(const Context &context, size_t index)
   ();
 }
 
+// Storage of an array value, for functions that write their result over an argument they own.
+export template <typename T> auto getArray(Context &context, size_t index) -> Array<T> &
+{
+  if constexpr (std::is_same_v<T, int>)
+    return context.integerArrays[index];
+  else if constexpr (std::is_same_v<T, double>)
+    return context.doubleArrays[index];
+  else if constexpr (std::is_same_v<T, std::int64_t>)
+    return context.longArrays[index];
+  else if constexpr (std::is_same_v<T, float>)
+    return context.floatArrays[index];
+  else if constexpr (std::is_same_v<T, std::int8_t>)
+    return context.int8Arrays[index];
+  else if constexpr (std::is_same_v<T, std::int16_t>)
+    return context.int16Arrays[index];
+  else if constexpr (std::is_same_v<T, std::uint8_t>)
+    return context.uint8Arrays[index];
+  else
+    return context.booleanArrays[index];
+}
+
 export template <typename T> auto getItemSize(const Context &context, size_t index) -> size_t
 {
   using Decayed = std::remove_cv<typename std::remove_reference<T>::type>::type;
 
   if constexpr (std::is_same_v<Decayed, std::vector<int>>)
     return context.integerArrays[index].size();
-  else if constexpr (std::is_same_v<Decayed, std::vector<bool>>)
+  else if constexpr (std::is_same_v<Decayed, BitArray>)
     return context.booleanArrays[index].size();
   else if constexpr (std::is_same_v<Decayed, std::vector<double>>)
     return context.doubleArrays[index].size();
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int64_t>>)
+    return context.longArrays[index].size();
   else
     return 1;
 }
 
+// Calls func with the values of a float or small integer array, the storage kinds whose elements are widened to
+// double or int when functions expand them. Other words have no values.
+export template <typename Func> auto visitStorageArray(const Context &context, const Word &word, Func func)
+{
+  switch (word.type)
+  {
+  case WordType::Int8Array:
+    return func(std::span<const std::int8_t>(context.int8Arrays[word.index]));
+  case WordType::Int16Array:
+    return func(std::span<const std::int16_t>(context.int16Arrays[word.index]));
+  case WordType::UInt8Array:
+    return func(std::span<const std::uint8_t>(context.uint8Arrays[word.index]));
+  case WordType::FloatArray:
+    return func(std::span<const float>(context.floatArrays[word.index]));
+  default:
+    return func(std::span<const float>());
+  }
+}
+
+export auto isStorageArray(WordType type) -> bool
+{
+  return type == WordType::Int8Array || type == WordType::Int16Array || type == WordType::UInt8Array ||
+         type == WordType::FloatArray;
+}
+
 export template <typename T> constexpr auto isExpandable() -> bool
 {
   using Decayed = std::remove_cv<typename std::remove_reference<T>::type>::type;
@@ -179,62 +670,713 @@ export template <typename T> constexpr auto isExpandable() -> bool
     return true;
   else if constexpr (std::is_same_v<Decayed, double>)
     return true;
+  else if constexpr (std::is_same_v<Decayed, std::int64_t>)
+    return true;
   else
     return false;
 }
 
+// Name of the pool of the values of the type, for the profiler.
+auto getPoolName(WordType type) -> std::string_view
+{
+  switch (type)
+  {
+  case WordType::IntegerNumber:
+    return "integerNumbers";
+  case WordType::IntegerArray:
+    return "integerArrays";
+  case WordType::DoubleNumber:
+    return "doubleNumbers";
+  case WordType::DoubleArray:
+    return "doubleArrays";
+  case WordType::Boolean:
+    return "booleans";
+  case WordType::BooleanArray:
+    return "booleanArrays";
+  case WordType::IntegerRange:
+    return "integerRanges";
+  case WordType::Dictionary:
+    return "dictionaries";
+  case WordType::NestedIntegerArray:
+    return "nestedIntegerArrays";
+  case WordType::NestedDoubleArray:
+    return "nestedDoubleArrays";
+  case WordType::NestedBooleanArray:
+    return "nestedBooleanArrays";
+  case WordType::LongNumber:
+    return "longNumbers";
+  case WordType::LongArray:
+    return "longArrays";
+  case WordType::FloatArray:
+    return "floatArrays";
+  case WordType::Int8Array:
+    return "int8Arrays";
+  case WordType::Int16Array:
+    return "int16Arrays";
+  case WordType::UInt8Array:
+    return "uint8Arrays";
+  case WordType::Tuple:
+    return "tuples";
+  case WordType::Executor:
+    return "executors";
+  case WordType::Block:
+    return "blocks";
+  default:
+    return "";
+  }
+}
+
+template <typename T> constexpr bool isStorageVector = false;
+template <typename T> constexpr bool isStorageVector<std::vector<T>> = true;
+
+// Bytes of the elements of a value, for the profiler.
+template <typename T> auto getValueBytes(const T &value) -> size_t
+{
+  if constexpr (std::is_same_v<T, BitArray>)
+    return value.blocks().size_bytes();
+  else if constexpr (std::is_same_v<T, NestedArray<int>> || std::is_same_v<T, NestedArray<double>>)
+    return value.values().size() * sizeof(value.values().front()) + value.offsets().size() * sizeof(size_t);
+  else if constexpr (std::is_same_v<T, NestedArray<bool>>)
+    return value.values().blocks().size_bytes() + value.offsets().size() * sizeof(size_t);
+  else if constexpr (std::is_same_v<T, Dictionary>)
+    return value.size() * sizeof(int) +
+           std::visit([](const auto &values) { return getValueBytes(values); }, value.values());
+  else if constexpr (std::is_same_v<T, Tuple> || std::is_same_v<T, Executor> || std::is_same_v<T, Block>)
+    return value.words.size() * sizeof(Word);
+  else if constexpr (isStorageVector<T>)
+    return value.size() * sizeof(typename T::value_type);
+  else
+    return sizeof(T);
+}
+
+template <typename T> auto addToPool(Pool<T> &pool, std::type_identity_t<T> value, WordType type) -> Word
+{
+  if (isProfiling())
+    recordAllocation(getPoolName(type), getValueBytes(value));
+
+  pool.push_back(std::move(value));
+  return Word{type, pool.size() - 1};
+}
+
 export auto createWord(Context &context, int value) -> Word
 {
-  context.integerNumbers.push_back(value);
-  return anka::Word{anka::WordType::IntegerNumber, context.integerNumbers.size() - 1};
+  return addToPool(context.integerNumbers, value, WordType::IntegerNumber);
 }
 
 export auto createWord(Context &context, bool value) -> Word
 {
-  context.booleans.push_back(value);
-  return anka::Word{anka::WordType::Boolean, context.booleans.size() - 1};
+  return addToPool(context.booleans, value, WordType::Boolean);
 }
 
 export auto createWord(Context &context, double value) -> Word
 {
-  context.doubleNumbers.push_back(value);
-  return anka::Word{anka::WordType::DoubleNumber, context.doubleNumbers.size() - 1};
+  return addToPool(context.doubleNumbers, value, WordType::DoubleNumber);
 }
 
 export auto createWord(Context &context, Tuple &&tuple) -> Word
 {
-  context.tuples.push_back(std::move(tuple));
-  return anka::Word{anka::WordType::Tuple, context.tuples.size() - 1};
+  return addToPool(context.tuples, std::move(tuple), WordType::Tuple);
 }
 
 export auto createWord(Context &context, Executor &&executor) -> Word
 {
-  context.executors.push_back(std::move(executor));
-  return anka::Word{anka::WordType::Executor, context.executors.size() - 1};
+  return addToPool(context.executors, std::move(executor), WordType::Executor);
 }
 
 export auto createWord(Context &context, Block &&block) -> Word
 {
-  context.blocks.push_back(std::move(block));
-  return anka::Word{anka::WordType::Block, context.blocks.size() - 1};
+  return addToPool(context.blocks, std::move(block), WordType::Block);
 }
 
 export auto createWord(Context &context, std::vector<int> &&vec) -> Word
 {
-  context.integerArrays.push_back(std::move(vec));
-  return anka::Word{anka::WordType::IntegerArray, context.integerArrays.size() - 1};
+  return addToPool(context.integerArrays, std::move(vec), WordType::IntegerArray);
 }
 
-export auto createWord(Context &context, std::vector<bool> &&vec) -> Word
+export auto createWord(Context &context, BitArray &&vec) -> Word
 {
-  context.booleanArrays.push_back(std::move(vec));
-  return anka::Word{anka::WordType::BooleanArray, context.booleanArrays.size() - 1};
+  return addToPool(context.booleanArrays, std::move(vec), WordType::BooleanArray);
 }
 
 export auto createWord(Context &context, std::vector<double> &&vec) -> Word
 {
-  context.doubleArrays.push_back(std::move(vec));
-  return anka::Word{anka::WordType::DoubleArray, context.doubleArrays.size() - 1};
+  return addToPool(context.doubleArrays, std::move(vec), WordType::DoubleArray);
+}
+
+export auto createWord(Context &context, const IntegerRange &range) -> Word
+{
+  return addToPool(context.integerRanges, range, WordType::IntegerRange);
+}
+
+export auto createWord(Context &context, Dictionary &&dictionary) -> Word
+{
+  return addToPool(context.dictionaries, std::move(dictionary), WordType::Dictionary);
+}
+
+export auto createWord(Context &context, NestedArray<int> &&nested) -> Word
+{
+  return addToPool(context.nestedIntegerArrays, std::move(nested), WordType::NestedIntegerArray);
+}
+
+export auto createWord(Context &context, NestedArray<double> &&nested) -> Word
+{
+  return addToPool(context.nestedDoubleArrays, std::move(nested), WordType::NestedDoubleArray);
+}
+
+export auto createWord(Context &context, NestedArray<bool> &&nested) -> Word
+{
+  return addToPool(context.nestedBooleanArrays, std::move(nested), WordType::NestedBooleanArray);
+}
+
+export auto createWord(Context &context, std::int64_t value) -> Word
+{
+  return addToPool(context.longNumbers, value, WordType::LongNumber);
+}
+
+export auto createWord(Context &context, std::vector<std::int64_t> &&vec) -> Word
+{
+  return addToPool(context.longArrays, std::move(vec), WordType::LongArray);
+}
+
+export auto createWord(Context &context, std::vector<float> &&vec) -> Word
+{
+  return addToPool(context.floatArrays, std::move(vec), WordType::FloatArray);
+}
+
+export auto createWord(Context &context, std::vector<std::int8_t> &&vec) -> Word
+{
+  return addToPool(context.int8Arrays, std::move(vec), WordType::Int8Array);
+}
+
+export auto createWord(Context &context, std::vector<std::int16_t> &&vec) -> Word
+{
+  return addToPool(context.int16Arrays, std::move(vec), WordType::Int16Array);
+}
+
+export auto createWord(Context &context, std::vector<std::uint8_t> &&vec) -> Word
+{
+  return addToPool(context.uint8Arrays, std::move(vec), WordType::UInt8Array);
+}
+
+export auto materialize(const IntegerRange &range) -> std::vector<int>
+{
+  std::vector<int> res(range.length);
+  for (size_t i = 0; i < range.length; ++i)
+  {
+    res[i] = range[i];
+  }
+  return res;
+}
+
+auto isRange(const Context &context, const Word &word) -> bool
+{
+  if (word.type == WordType::Name)
+  {
+    const auto &value = context.userDefinedNames[word.index];
+    return value && value->type == WordType::IntegerRange;
+  }
+  return word.type == WordType::IntegerRange;
+}
+
+// Replaces integer ranges, also in tuples and behind user defined names, with integer arrays.
+export auto materialize(Context &context, const Word &word) -> Word
+{
+  if (word.type == WordType::Name && isRange(context, word))
+    return materialize(context, context.userDefinedNames[word.index].value());
+
+  if (word.type == WordType::IntegerRange)
+    return createWord(context, materialize(context.integerRanges[word.index]));
+
+  if (word.type != WordType::Tuple ||
+      std::ranges::none_of(context.tuples[word.index].words, [&](const Word &w) { return isRange(context, w); }))
+    return word;
+
+  auto tuple = context.tuples[word.index];
+  for (auto &element : tuple.words)
+  {
+    element = materialize(context, element);
+  }
+  return createWord(context, std::move(tuple));
+}
+
+// Pool sizes of a context at a point in time. Everything created after a mark is a temporary
+// that can be released with releaseTemporaries. Names are interned and stay.
+export struct ContextMark
+{
+  size_t integerNumbers = 0;
+  size_t integerArrays = 0;
+  size_t doubleNumbers = 0;
+  size_t doubleArrays = 0;
+  size_t booleans = 0;
+  size_t booleanArrays = 0;
+  size_t integerRanges = 0;
+  size_t dictionaries = 0;
+  size_t nestedIntegerArrays = 0;
+  size_t nestedDoubleArrays = 0;
+  size_t nestedBooleanArrays = 0;
+  size_t longNumbers = 0;
+  size_t longArrays = 0;
+  size_t floatArrays = 0;
+  size_t int8Arrays = 0;
+  size_t int16Arrays = 0;
+  size_t uint8Arrays = 0;
+  size_t tuples = 0;
+  size_t executors = 0;
+  size_t blocks = 0;
+};
+
+export auto markContext(const Context &context) -> ContextMark
+{
+  return ContextMark{context.integerNumbers.size(),      context.integerArrays.size(),
+                     context.doubleNumbers.size(),       context.doubleArrays.size(),
+                     context.booleans.size(),            context.booleanArrays.size(),
+                     context.integerRanges.size(),       context.dictionaries.size(),
+                     context.nestedIntegerArrays.size(), context.nestedDoubleArrays.size(),
+                     context.nestedBooleanArrays.size(), context.longNumbers.size(),
+                     context.longArrays.size(),          context.floatArrays.size(),
+                     context.int8Arrays.size(),          context.int16Arrays.size(),
+                     context.uint8Arrays.size(),         context.tuples.size(),
+                     context.executors.size(),           context.blocks.size()};
+}
+
+// Drops every value created after the mark, the words referring to them can not be used anymore.
+export auto truncateContext(Context &context, const ContextMark &mark) -> void
+{
+  context.integerNumbers.truncate(mark.integerNumbers);
+  context.integerArrays.truncate(mark.integerArrays);
+  context.doubleNumbers.truncate(mark.doubleNumbers);
+  context.doubleArrays.truncate(mark.doubleArrays);
+  context.booleans.truncate(mark.booleans);
+  context.booleanArrays.truncate(mark.booleanArrays);
+  context.integerRanges.truncate(mark.integerRanges);
+  context.dictionaries.truncate(mark.dictionaries);
+  context.nestedIntegerArrays.truncate(mark.nestedIntegerArrays);
+  context.nestedDoubleArrays.truncate(mark.nestedDoubleArrays);
+  context.nestedBooleanArrays.truncate(mark.nestedBooleanArrays);
+  context.longNumbers.truncate(mark.longNumbers);
+  context.longArrays.truncate(mark.longArrays);
+  context.floatArrays.truncate(mark.floatArrays);
+  context.int8Arrays.truncate(mark.int8Arrays);
+  context.int16Arrays.truncate(mark.int16Arrays);
+  context.uint8Arrays.truncate(mark.uint8Arrays);
+  context.tuples.truncate(mark.tuples);
+  context.executors.truncate(mark.executors);
+  context.blocks.truncate(mark.blocks);
+}
+
+constexpr auto releasedIndex = std::numeric_limits<size_t>::max();
+
+// New indices of the items created after the mark, releasedIndex for the ones that are not reachable.
+struct PoolRelocation
+{
+  size_t mark = 0;
+  std::vector<size_t> indices;
+
+  PoolRelocation(size_t mark, size_t size) : mark(mark), indices(size - mark, releasedIndex)
+  {
+  }
+
+  auto isTemporary(size_t index) const -> bool
+  {
+    return index >= mark;
+  }
+};
+
+struct ContextRelocation
+{
+  PoolRelocation integerNumbers;
+  PoolRelocation integerArrays;
+  PoolRelocation doubleNumbers;
+  PoolRelocation doubleArrays;
+  PoolRelocation booleans;
+  PoolRelocation booleanArrays;
+  PoolRelocation integerRanges;
+  PoolRelocation dictionaries;
+  PoolRelocation nestedIntegerArrays;
+  PoolRelocation nestedDoubleArrays;
+  PoolRelocation nestedBooleanArrays;
+  PoolRelocation longNumbers;
+  PoolRelocation longArrays;
+  PoolRelocation floatArrays;
+  PoolRelocation int8Arrays;
+  PoolRelocation int16Arrays;
+  PoolRelocation uint8Arrays;
+  PoolRelocation tuples;
+  PoolRelocation executors;
+  PoolRelocation blocks;
+
+  auto getPool(WordType type) -> PoolRelocation *
+  {
+    switch (type)
+    {
+    case WordType::IntegerNumber:
+      return &integerNumbers;
+    case WordType::IntegerArray:
+      return &integerArrays;
+    case WordType::DoubleNumber:
+      return &doubleNumbers;
+    case WordType::DoubleArray:
+      return &doubleArrays;
+    case WordType::Boolean:
+      return &booleans;
+    case WordType::BooleanArray:
+      return &booleanArrays;
+    case WordType::IntegerRange:
+      return &integerRanges;
+    case WordType::Dictionary:
+      return &dictionaries;
+    case WordType::NestedIntegerArray:
+      return &nestedIntegerArrays;
+    case WordType::NestedDoubleArray:
+      return &nestedDoubleArrays;
+    case WordType::NestedBooleanArray:
+      return &nestedBooleanArrays;
+    case WordType::LongNumber:
+      return &longNumbers;
+    case WordType::LongArray:
+      return &longArrays;
+    case WordType::FloatArray:
+      return &floatArrays;
+    case WordType::Int8Array:
+      return &int8Arrays;
+    case WordType::Int16Array:
+      return &int16Arrays;
+    case WordType::UInt8Array:
+      return &uint8Arrays;
+    case WordType::Tuple:
+      return &tuples;
+    case WordType::Executor:
+      return &executors;
+    case WordType::Block:
+      return &blocks;
+    default:
+      return nullptr;
+    }
+  }
+};
+
+auto getChildWords(const Context &context, const Word &word) -> const std::vector<Word> *
+{
+  switch (word.type)
+  {
+  case WordType::Tuple:
+    return &context.tuples[word.index].words;
+  case WordType::Executor:
+    return &context.executors[word.index].words;
+  case WordType::Block:
+    return &context.blocks[word.index].words;
+  default:
+    return nullptr;
+  }
+}
+
+auto markReachable(const Context &context, ContextRelocation &relocation, const Word &root) -> void
+{
+  std::vector<Word> stack{root};
+  while (!stack.empty())
+  {
+    const auto word = stack.back();
+    stack.pop_back();
+
+    auto pool = relocation.getPool(word.type);
+    // items before the mark can only refer to other items before the mark
+    if (pool == nullptr || !pool->isTemporary(word.index))
+      continue;
+
+    auto &newIndex = pool->indices[word.index - pool->mark];
+    if (newIndex != releasedIndex)
+      continue;
+    newIndex = 0;
+
+    if (auto children = getChildWords(context, word))
+      stack.insert(stack.end(), children->begin(), children->end());
+  }
+}
+
+auto assignNewIndices(PoolRelocation &pool) -> size_t
+{
+  auto next = pool.mark;
+  for (auto &index : pool.indices)
+  {
+    if (index != releasedIndex)
+      index = next++;
+  }
+  return next;
+}
+
+auto relocate(ContextRelocation &relocation, Word &word) -> void
+{
+  auto pool = relocation.getPool(word.type);
+  if (pool != nullptr && pool->isTemporary(word.index))
+    word.index = pool->indices[word.index - pool->mark];
+}
+
+// Returns whether any of the words moved.
+auto relocateChildren(ContextRelocation &relocation, std::vector<Word> &words) -> bool
+{
+  auto moved = false;
+  for (auto &word : words)
+  {
+    const auto previous = word;
+    relocate(relocation, word);
+    moved = moved || previous != word;
+  }
+  return moved;
+}
+
+template <typename T> auto compactPool(Pool<T> &pool, PoolRelocation &relocation) -> void
+{
+  const auto newSize = assignNewIndices(relocation);
+  for (size_t i = 0; i < relocation.indices.size(); ++i)
+  {
+    const auto newIndex = relocation.indices[i];
+    if (newIndex != releasedIndex && newIndex != relocation.mark + i)
+      pool[newIndex] = std::move(pool[relocation.mark + i]);
+  }
+  pool.truncate(newSize);
+}
+
+// Releases every value created after the mark that is not reachable from userDefinedNames, the memo or the given
+// roots. Surviving values are moved down to the mark and the words referring to them (roots included) are updated.
+export auto releaseTemporaries(Context &context, const ContextMark &mark, std::span<Word> roots) -> void
+{
+  ProfileScope scope{ProfilePhase::Release, "releaseTemporaries"};
+  ContextRelocation relocation{{mark.integerNumbers, context.integerNumbers.size()},
+                               {mark.integerArrays, context.integerArrays.size()},
+                               {mark.doubleNumbers, context.doubleNumbers.size()},
+                               {mark.doubleArrays, context.doubleArrays.size()},
+                               {mark.booleans, context.booleans.size()},
+                               {mark.booleanArrays, context.booleanArrays.size()},
+                               {mark.integerRanges, context.integerRanges.size()},
+                               {mark.dictionaries, context.dictionaries.size()},
+                               {mark.nestedIntegerArrays, context.nestedIntegerArrays.size()},
+                               {mark.nestedDoubleArrays, context.nestedDoubleArrays.size()},
+                               {mark.nestedBooleanArrays, context.nestedBooleanArrays.size()},
+                               {mark.longNumbers, context.longNumbers.size()},
+                               {mark.longArrays, context.longArrays.size()},
+                               {mark.floatArrays, context.floatArrays.size()},
+                               {mark.int8Arrays, context.int8Arrays.size()},
+                               {mark.int16Arrays, context.int16Arrays.size()},
+                               {mark.uint8Arrays, context.uint8Arrays.size()},
+                               {mark.tuples, context.tuples.size()},
+                               {mark.executors, context.executors.size()},
+                               {mark.blocks, context.blocks.size()}};
+
+  for (const auto &value : context.userDefinedNames)
+  {
+    if (value)
+      markReachable(context, relocation, value.value());
+  }
+  for (const auto &root : roots)
+    markReachable(context, relocation, root);
+  for (const auto &entry : context.memo.entries)
+  {
+    for (const auto &word : {entry.function, entry.argument, entry.result})
+      markReachable(context, relocation, word);
+  }
+
+  compactPool(context.integerNumbers, relocation.integerNumbers);
+  compactPool(context.integerArrays, relocation.integerArrays);
+  compactPool(context.doubleNumbers, relocation.doubleNumbers);
+  compactPool(context.doubleArrays, relocation.doubleArrays);
+  compactPool(context.booleans, relocation.booleans);
+  compactPool(context.booleanArrays, relocation.booleanArrays);
+  compactPool(context.integerRanges, relocation.integerRanges);
+  compactPool(context.dictionaries, relocation.dictionaries);
+  compactPool(context.nestedIntegerArrays, relocation.nestedIntegerArrays);
+  compactPool(context.nestedDoubleArrays, relocation.nestedDoubleArrays);
+  compactPool(context.nestedBooleanArrays, relocation.nestedBooleanArrays);
+  compactPool(context.longNumbers, relocation.longNumbers);
+  compactPool(context.longArrays, relocation.longArrays);
+  compactPool(context.floatArrays, relocation.floatArrays);
+  compactPool(context.int8Arrays, relocation.int8Arrays);
+  compactPool(context.int16Arrays, relocation.int16Arrays);
+  compactPool(context.uint8Arrays, relocation.uint8Arrays);
+  compactPool(context.tuples, relocation.tuples);
+  compactPool(context.executors, relocation.executors);
+  compactPool(context.blocks, relocation.blocks);
+
+  for (auto i = mark.tuples; i < context.tuples.size(); ++i)
+    relocateChildren(relocation, context.tuples[i].words);
+  for (auto i = mark.executors; i < context.executors.size(); ++i)
+    relocateChildren(relocation, context.executors[i].words);
+  for (auto i = mark.blocks; i < context.blocks.size(); ++i)
+  {
+    auto &block = context.blocks[i];
+    if (relocateChildren(relocation, block.words))
+      block.compiled.reset();
+  }
+
+  // compiled words cache the values of user defined names
+  auto namesChanged = false;
+  for (auto &value : context.userDefinedNames)
+  {
+    if (!value)
+      continue;
+
+    const auto previous = value.value();
+    relocate(relocation, value.value());
+    namesChanged = namesChanged || previous != value.value();
+  }
+  if (namesChanged)
+    ++context.namesVersion;
+  for (auto &root : roots)
+    relocate(relocation, root);
+  for (auto &entry : context.memo.entries)
+  {
+    relocate(relocation, entry.function);
+    relocate(relocation, entry.argument);
+    relocate(relocation, entry.result);
+  }
+}
+
+export auto releaseTemporaries(Context &context, const ContextMark &mark) -> void
+{
+  releaseTemporaries(context, mark, {});
+}
+
+auto isInternalName(size_t nameId) -> bool
+{
+  return nameId < getInternalFunctionNames().size();
+}
+
+// Copies the value of a word to another context, or moves it when the source context is not const. The words of
+// tuples, executors and blocks and the values of user defined names are transferred too, a word that is
+// referenced twice is transferred once. Internal function names have the same id in every context.
+template <typename FromContext>
+auto transferWord(FromContext &from, Context &to, const Word &word, std::map<Word, Word> &transferred) -> Word
+{
+  if (auto iter = transferred.find(word); iter != transferred.end())
+    return iter->second;
+
+  // values are moved back to the context they were inherited from, which holds the inherited ones already
+  if constexpr (!std::is_const_v<FromContext>)
+  {
+    if (isInherited(from, word))
+      return word;
+  }
+
+  const auto take = [](auto &value) {
+    if constexpr (std::is_const_v<FromContext>)
+      return std::remove_cvref_t<decltype(value)>(value);
+    else
+      return std::move(value);
+  };
+  const auto transferWords = [&](const std::vector<Word> &words) {
+    std::vector<Word> res;
+    for (const auto &child : words)
+      res.push_back(transferWord(from, to, child, transferred));
+    return res;
+  };
+
+  Word res = word;
+  switch (word.type)
+  {
+  case WordType::IntegerNumber:
+    res = createWord(to, from.integerNumbers[word.index]);
+    break;
+  case WordType::IntegerArray:
+    res = createWord(to, take(from.integerArrays[word.index]));
+    break;
+  case WordType::DoubleNumber:
+    res = createWord(to, from.doubleNumbers[word.index]);
+    break;
+  case WordType::DoubleArray:
+    res = createWord(to, take(from.doubleArrays[word.index]));
+    break;
+  case WordType::Boolean:
+    res = createWord(to, static_cast<bool>(from.booleans[word.index]));
+    break;
+  case WordType::BooleanArray:
+    res = createWord(to, take(from.booleanArrays[word.index]));
+    break;
+  case WordType::IntegerRange:
+    res = createWord(to, from.integerRanges[word.index]);
+    break;
+  case WordType::Dictionary:
+    res = createWord(to, take(from.dictionaries[word.index]));
+    break;
+  case WordType::NestedIntegerArray:
+    res = createWord(to, take(from.nestedIntegerArrays[word.index]));
+    break;
+  case WordType::NestedDoubleArray:
+    res = createWord(to, take(from.nestedDoubleArrays[word.index]));
+    break;
+  case WordType::NestedBooleanArray:
+    res = createWord(to, take(from.nestedBooleanArrays[word.index]));
+    break;
+  case WordType::LongNumber:
+    res = createWord(to, from.longNumbers[word.index]);
+    break;
+  case WordType::LongArray:
+    res = createWord(to, take(from.longArrays[word.index]));
+    break;
+  case WordType::FloatArray:
+    res = createWord(to, take(from.floatArrays[word.index]));
+    break;
+  case WordType::Int8Array:
+    res = createWord(to, take(from.int8Arrays[word.index]));
+    break;
+  case WordType::Int16Array:
+    res = createWord(to, take(from.int16Arrays[word.index]));
+    break;
+  case WordType::UInt8Array:
+    res = createWord(to, take(from.uint8Arrays[word.index]));
+    break;
+  // containers are registered before their words, blocks can refer to themselves through a name
+  case WordType::Tuple: {
+    auto connectedOpt = from.tuples[word.index].connectedNameIndexOpt;
+    if (connectedOpt && !isInternalName(connectedOpt.value()))
+      connectedOpt = internName(to, from.names[connectedOpt.value()]);
+    res = createWord(to, Tuple{{}, connectedOpt});
+    transferred.emplace(word, res);
+    auto words = transferWords(from.tuples[word.index].words);
+    to.tuples[res.index].words = std::move(words);
+    break;
+  }
+  case WordType::Executor: {
+    res = createWord(to, Executor{});
+    transferred.emplace(word, res);
+    auto words = transferWords(from.executors[word.index].words);
+    to.executors[res.index].words = std::move(words);
+    break;
+  }
+  case WordType::Block: {
+    res = createWord(to, Block{});
+    transferred.emplace(word, res);
+    auto words = transferWords(from.blocks[word.index].words);
+    to.blocks[res.index].words = std::move(words);
+    break;
+  }
+  case WordType::Name: {
+    if (isInternalName(word.index))
+      break;
+    res = Word{WordType::Name, internName(to, from.names[word.index])};
+    transferred.emplace(word, res);
+    if (const auto valueOpt = from.userDefinedNames[word.index])
+      to.userDefinedNames[res.index] = transferWord(from, to, valueOpt.value(), transferred);
+    break;
+  }
+  default:
+    break;
+  }
+
+  transferred.emplace(word, res);
+  return res;
+}
+
+export auto copyWord(const Context &from, Context &to, const Word &word) -> Word
+{
+  std::map<Word, Word> transferred;
+  return transferWord(from, to, word, transferred);
+}
+
+// The values of the word are left empty in the source context. A context that inherits values can only be moved to
+// the context it inherited them from.
+export auto moveWord(Context &from, Context &to, const Word &word) -> Word
+{
+  std::map<Word, Word> transferred;
+  return transferWord(from, to, word, transferred);
 }
 
 
@@ -264,8 +1406,28 @@ export template <typename T> anka::WordType getWordType()
     return WordType::DoubleArray;
   else if constexpr (std::is_same_v<Decayed, bool>)
     return WordType::Boolean;
-  else if constexpr (std::is_same_v<Decayed, std::vector<bool>>)
+  else if constexpr (std::is_same_v<Decayed, BitArray>)
     return WordType::BooleanArray;
+  else if constexpr (std::is_same_v<Decayed, Dictionary>)
+    return WordType::Dictionary;
+  else if constexpr (std::is_same_v<Decayed, NestedArray<int>>)
+    return WordType::NestedIntegerArray;
+  else if constexpr (std::is_same_v<Decayed, NestedArray<double>>)
+    return WordType::NestedDoubleArray;
+  else if constexpr (std::is_same_v<Decayed, NestedArray<bool>>)
+    return WordType::NestedBooleanArray;
+  else if constexpr (std::is_same_v<Decayed, std::int64_t>)
+    return WordType::LongNumber;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int64_t>>)
+    return WordType::LongArray;
+  else if constexpr (std::is_same_v<Decayed, std::vector<float>>)
+    return WordType::FloatArray;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int8_t>>)
+    return WordType::Int8Array;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int16_t>>)
+    return WordType::Int16Array;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::uint8_t>>)
+    return WordType::UInt8Array;
   else
     []<bool flag = false>()
     {
@@ -318,6 +1480,28 @@ auto anka::toString(anka::WordType type) -> std::string
     return "_X";
   case anka::WordType::Executor:
     return "||";
+  case anka::WordType::IntegerRange:
+    return "(int)";
+  case anka::WordType::Dictionary:
+    return "dict";
+  case anka::WordType::NestedIntegerArray:
+    return "((int))";
+  case anka::WordType::NestedDoubleArray:
+    return "((double))";
+  case anka::WordType::NestedBooleanArray:
+    return "((bool))";
+  case anka::WordType::LongNumber:
+    return "long";
+  case anka::WordType::LongArray:
+    return "(long)";
+  case anka::WordType::FloatArray:
+    return "(float)";
+  case anka::WordType::Int8Array:
+    return "(int8)";
+  case anka::WordType::Int16Array:
+    return "(int16)";
+  case anka::WordType::UInt8Array:
+    return "(uint8)";
   case anka::WordType::Block:
   default:
     return "unknownType";
@@ -0,0 +1,178 @@
+module;
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+export module anka:memoization;
+
+import :interpreter_state;
+import :bit_array;
+
+namespace anka
+{
+
+auto combineHash(size_t seed, size_t value) -> size_t
+{
+  return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+template <typename Container> auto hashElements(size_t seed, const Container &container) -> size_t
+{
+  using T = typename Container::value_type;
+  for (const auto &element : container)
+    seed = combineHash(seed, std::hash<T>{}(element));
+  return seed;
+}
+
+// Hash of the content of the word, nothing for values that are only compared by identity.
+auto hashValue(const Context &context, const Word &word) -> std::optional<size_t>
+{
+  const auto seed = static_cast<size_t>(word.type);
+  switch (word.type)
+  {
+  case WordType::IntegerNumber:
+    return combineHash(seed, std::hash<int>{}(context.integerNumbers[word.index]));
+  case WordType::IntegerArray:
+    return hashElements(seed, context.integerArrays[word.index]);
+  case WordType::DoubleNumber:
+    return combineHash(seed, std::hash<double>{}(context.doubleNumbers[word.index]));
+  case WordType::DoubleArray:
+    return hashElements(seed, context.doubleArrays[word.index]);
+  case WordType::Boolean:
+    return combineHash(seed, std::hash<bool>{}(context.booleans[word.index]));
+  case WordType::BooleanArray: {
+    const auto &array = context.booleanArrays[word.index];
+    return hashElements(combineHash(seed, array.size()), array.blocks());
+  }
+  case WordType::IntegerRange: {
+    const auto &range = context.integerRanges[word.index];
+    return combineHash(combineHash(combineHash(seed, static_cast<size_t>(range.start)), static_cast<size_t>(range.step)),
+                       range.length);
+  }
+  case WordType::LongNumber:
+    return combineHash(seed, std::hash<std::int64_t>{}(context.longNumbers[word.index]));
+  case WordType::LongArray:
+    return hashElements(seed, context.longArrays[word.index]);
+  case WordType::FloatArray:
+  case WordType::Int8Array:
+  case WordType::Int16Array:
+  case WordType::UInt8Array:
+    return visitStorageArray(context, word, [seed](auto values) { return hashElements(seed, values); });
+  case WordType::Tuple: {
+    auto hash = seed;
+    for (const auto &element : context.tuples[word.index].words)
+    {
+      const auto elementHash = hashValue(context, element);
+      if (!elementHash)
+        return std::nullopt;
+      hash = combineHash(hash, elementHash.value());
+    }
+    return hash;
+  }
+  default:
+    return std::nullopt;
+  }
+}
+
+auto equalValues(const Context &context, const Word &lhs, const Word &rhs) -> bool
+{
+  if (lhs == rhs)
+    return true;
+  if (lhs.type != rhs.type)
+    return false;
+
+  switch (lhs.type)
+  {
+  case WordType::IntegerNumber:
+    return context.integerNumbers[lhs.index] == context.integerNumbers[rhs.index];
+  case WordType::IntegerArray:
+    return context.integerArrays[lhs.index] == context.integerArrays[rhs.index];
+  case WordType::DoubleNumber:
+    return context.doubleNumbers[lhs.index] == context.doubleNumbers[rhs.index];
+  case WordType::DoubleArray:
+    return context.doubleArrays[lhs.index] == context.doubleArrays[rhs.index];
+  case WordType::Boolean:
+    return context.booleans[lhs.index] == context.booleans[rhs.index];
+  case WordType::BooleanArray:
+    return context.booleanArrays[lhs.index] == context.booleanArrays[rhs.index];
+  case WordType::IntegerRange:
+    return context.integerRanges[lhs.index] == context.integerRanges[rhs.index];
+  case WordType::LongNumber:
+    return context.longNumbers[lhs.index] == context.longNumbers[rhs.index];
+  case WordType::LongArray:
+    return context.longArrays[lhs.index] == context.longArrays[rhs.index];
+  case WordType::FloatArray:
+  case WordType::Int8Array:
+  case WordType::Int16Array:
+  case WordType::UInt8Array:
+    return visitStorageArray(context, lhs, [&context, &rhs](auto lhsValues) {
+      return visitStorageArray(context, rhs,
+                               [lhsValues](auto rhsValues) { return std::ranges::equal(lhsValues, rhsValues); });
+    });
+  case WordType::Tuple:
+    return std::ranges::equal(context.tuples[lhs.index].words, context.tuples[rhs.index].words,
+                              [&context](const Word &w1, const Word &w2) { return equalValues(context, w1, w2); });
+  default:
+    return false;
+  }
+}
+
+// Enables memoization of pure blocks and executors, a capacity of 0 disables it and drops the entries.
+export auto setMemoCapacity(Context &context, size_t capacity) -> void
+{
+  auto &entries = context.memo.entries;
+  context.memo.capacity = capacity;
+  if (entries.size() > capacity)
+  {
+    std::ranges::sort(entries, std::greater{}, &MemoEntry::lastUse);
+    entries.erase(entries.begin() + capacity, entries.end());
+  }
+}
+
+// Result of function applied to argument if it was memoized. The argument matches an entry with the same word, or
+// with the same content when it has a hash, which is stored in hash for memoize.
+export auto findMemoized(Context &context, const Word &function, const Word &argument, std::optional<size_t> &hash)
+    -> std::optional<Word>
+{
+  auto &memo = context.memo;
+  auto match = std::ranges::find_if(memo.entries, [&](const MemoEntry &entry) {
+    return entry.function == function && entry.argument == argument;
+  });
+
+  if (match == memo.entries.end())
+  {
+    hash = hashValue(context, argument);
+    if (!hash)
+      return std::nullopt;
+
+    match = std::ranges::find_if(memo.entries, [&](const MemoEntry &entry) {
+      return entry.function == function && entry.hash == hash && equalValues(context, entry.argument, argument);
+    });
+    if (match == memo.entries.end())
+      return std::nullopt;
+  }
+
+  match->lastUse = ++memo.useCount;
+  return match->result;
+}
+
+export auto memoize(Context &context, const Word &function, const Word &argument, const std::optional<size_t> &hash,
+                    const Word &result) -> void
+{
+  auto &memo = context.memo;
+  if (memo.capacity == 0)
+    return;
+
+  MemoEntry entry{function, argument, hash, result, ++memo.useCount};
+  if (memo.entries.size() < memo.capacity)
+  {
+    memo.entries.push_back(entry);
+    return;
+  }
+
+  *std::ranges::min_element(memo.entries, {}, &MemoEntry::lastUse) = entry;
+}
+
+} // namespace anka
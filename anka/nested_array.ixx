@@ -0,0 +1,86 @@
+module;
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+export module anka:nested_array;
+
+import :bit_array;
+
+namespace anka
+{
+
+// Array of arrays stored as the values of all rows one after the other and the offsets of the rows in them, so
+// rows do not need an allocation each. Row i is values[offsets[i], offsets[i + 1]). Booleans are stored one per bit.
+export template <typename T> class NestedArray
+{
+public:
+  using Values = std::conditional_t<std::is_same_v<T, bool>, BitArray, std::vector<T>>;
+
+  NestedArray() : offsetColumn{0}
+  {
+  }
+
+  // offsets has one more element than there are rows, starts with 0 and ends with the number of values.
+  NestedArray(Values &&values, std::vector<size_t> &&offsets)
+      : valueColumn(std::move(values)), offsetColumn(std::move(offsets))
+  {
+  }
+
+  // Number of rows
+  auto size() const -> size_t
+  {
+    return offsetColumn.size() - 1;
+  }
+
+  auto empty() const -> bool
+  {
+    return size() == 0;
+  }
+
+  auto row(size_t index) const -> std::span<const T>
+    requires(!std::is_same_v<T, bool>)
+  {
+    return std::span<const T>(valueColumn).subspan(offsetColumn[index], offsetColumn[index + 1] - offsetColumn[index]);
+  }
+
+  auto values() const -> const Values &
+  {
+    return valueColumn;
+  }
+
+  auto offsets() const -> const std::vector<size_t> &
+  {
+    return offsetColumn;
+  }
+
+  auto push_back(std::span<const T> row) -> void
+    requires(!std::is_same_v<T, bool>)
+  {
+    valueColumn.insert(valueColumn.end(), row.begin(), row.end());
+    offsetColumn.push_back(valueColumn.size());
+  }
+
+  auto push_back(const BitArray &row) -> void
+    requires std::is_same_v<T, bool>
+  {
+    for (const auto value : row)
+      valueColumn.push_back(value);
+    offsetColumn.push_back(valueColumn.size());
+  }
+
+  auto reserve(size_t rowCount, size_t valueCount) -> void
+  {
+    offsetColumn.reserve(rowCount + 1);
+    valueColumn.reserve(valueCount);
+  }
+
+  friend auto operator==(const NestedArray &lhs, const NestedArray &rhs) -> bool = default;
+
+private:
+  Values valueColumn;
+  std::vector<size_t> offsetColumn;
+};
+
+} // namespace anka
@@ -33,6 +33,58 @@ TEST_CASE("single array")
   CHECK_EQ(arr, std::vector<int>{10, 20, 30});
 }
 
+TEST_CASE("large number array")
+{
+  auto ParseResult = toParseResult("(1 -2 3 4 5 6 7 8 9 10) (1.5 -2.5 3.0)");
+  REQUIRE_EQ(ParseResult.sentences.size(), 1);
+  REQUIRE_EQ(ParseResult.context.integerArrays.size(), 1);
+  REQUIRE_EQ(ParseResult.context.doubleArrays.size(), 1);
+  // the elements are parsed straight into the arrays
+  CHECK(ParseResult.context.integerNumbers.empty());
+  CHECK(ParseResult.context.doubleNumbers.empty());
+
+  CHECK_EQ(ParseResult.context.integerArrays[0], std::vector<int>{1, -2, 3, 4, 5, 6, 7, 8, 9, 10});
+  CHECK_EQ(ParseResult.context.doubleArrays[0], std::vector<double>{1.5, -2.5, 3.0});
+}
+
+TEST_CASE("mixed number array")
+{
+  try
+  {
+    toParseResult("(1 2 3.5 4)");
+    FAIL("expected a parse error");
+  }
+  catch (const anka::ParseError &err)
+  {
+    REQUIRE(err.tokenOpt.has_value());
+    CHECK_EQ(err.tokenOpt->start, 5);
+    CHECK_EQ(err.tokenOpt->type, anka::TokenType::NumberDouble);
+  }
+
+  CHECK_THROWS_AS(toParseResult("(1 2-3)"), const anka::ParseError &);
+  CHECK_THROWS_AS(toParseResult("(1 2 true)"), const anka::ParseError &);
+}
+
+TEST_CASE("nested array")
+{
+  auto ParseResult = toParseResult("((1000 2000 3000) (4000) (5000 6000))");
+  REQUIRE_EQ(ParseResult.sentences.size(), 1);
+  REQUIRE_EQ(ParseResult.context.nestedIntegerArrays.size(), 1);
+  CHECK(ParseResult.context.integerArrays.empty());
+
+  // one buffer for the values of all rows
+  const auto &nested = ParseResult.context.nestedIntegerArrays[0];
+  CHECK_EQ(nested.values(), std::vector<int>{1000, 2000, 3000, 4000, 5000, 6000});
+  CHECK_EQ(nested.offsets(), std::vector<size_t>{0, 3, 4, 6});
+
+  auto boolResult = toParseResult("((true false) (true))");
+  REQUIRE_EQ(boolResult.context.nestedBooleanArrays.size(), 1);
+  CHECK_EQ(boolResult.context.nestedBooleanArrays[0].offsets(), std::vector<size_t>{0, 2, 3});
+
+  CHECK_THROWS_AS(toParseResult("((1 2) (1.5))"), const anka::ParseError &);
+  CHECK_THROWS_AS(toParseResult("((1 2) 3)"), const anka::ParseError &);
+}
+
 TEST_CASE("number")
 {
   auto ParseResult = toParseResult("10 20 30");
@@ -148,7 +200,9 @@ TEST_CASE("boolean array")
   auto ParseResult = toParseResult("(true false)");
   REQUIRE_EQ(ParseResult.sentences.size(), 1);
   REQUIRE_EQ(ParseResult.context.booleanArrays.size(), 1);
-  CHECK_EQ(ParseResult.context.booleanArrays[0], std::vector<bool>{true, false});
+  CHECK_EQ(ParseResult.context.booleanArrays[0], BitArray{true, false});
+  // the elements are not kept
+  CHECK(ParseResult.context.booleans.empty());
   CHECK_EQ(ParseResult.sentences[0].words, std::vector<Word>{{WordType::BooleanArray, 0}});
 }
 
@@ -182,21 +236,30 @@ TEST_CASE("names")
 {
   using namespace anka;
 
-  auto ParseResult = toParseResult("add ioata (10 20 30)\n ioata 50 (1 2 3)");
-  REQUIRE_EQ(ParseResult.sentences.size(), 2);
+  auto ParseResult = toParseResult("add ioata (10 20 30)\n ioata 50 (1 2 3)\n x: x");
+  REQUIRE_EQ(ParseResult.sentences.size(), 3);
   REQUIRE_EQ(ParseResult.context.integerNumbers.size(), 1);
   REQUIRE_EQ(ParseResult.context.integerArrays.size(), 2);
-  REQUIRE_EQ(ParseResult.context.names.size(), 3);
+  REQUIRE_EQ(ParseResult.context.names.size(), getInternalFunctionNames().size() + 1);
 
   CHECK_EQ(ParseResult.context.integerNumbers, std::vector<int>{50});
   CHECK_EQ(ParseResult.context.integerArrays[0], std::vector<int>{10, 20, 30});
   CHECK_EQ(ParseResult.context.integerArrays[1], std::vector<int>{1, 2, 3});
-  CHECK_EQ(ParseResult.context.names, std::vector<std::string>{"add", "ioata", "ioata"});
+
+  const auto add = findNameId(ParseResult.context, "add").value();
+  const auto ioata = findNameId(ParseResult.context, "ioata").value();
+  const auto x = findNameId(ParseResult.context, "x").value();
+  CHECK(isInternalFunction(add));
+  CHECK(isInternalFunction(ioata));
+  CHECK_FALSE(isInternalFunction(x));
+  CHECK_EQ(ParseResult.context.names[ioata], "ioata");
 
   CHECK_EQ(ParseResult.sentences[0].words,
-           std::vector<Word>{{WordType::Name, 0}, {WordType::Name, 1}, {WordType::IntegerArray, 0}});
+           std::vector<Word>{{WordType::Name, add}, {WordType::Name, ioata}, {WordType::IntegerArray, 0}});
   CHECK_EQ(ParseResult.sentences[1].words,
-           std::vector<Word>{{WordType::Name, 2}, {WordType::IntegerNumber, 0}, {WordType::IntegerArray, 1}});
+           std::vector<Word>{{WordType::Name, ioata}, {WordType::IntegerNumber, 0}, {WordType::IntegerArray, 1}});
+  CHECK_EQ(ParseResult.sentences[2].words,
+           std::vector<Word>{{WordType::Name, x}, {WordType::Assignment, 0}, {WordType::Name, x}});
 }
 
 TEST_CASE("executor")
@@ -206,12 +269,14 @@ TEST_CASE("executor")
   auto ParseResult = toParseResult("|length add[10 _] _1|");
   REQUIRE_EQ(ParseResult.sentences.size(), 1);
   REQUIRE_EQ(ParseResult.context.executors.size(), 1);
-  REQUIRE_EQ(
-      ParseResult.context.executors[0].words,
-      std::vector<Word>{{WordType::Name, 0}, {WordType::Name, 1}, {WordType::Tuple, 0}, {WordType::PlaceHolder, 1}});
+  const auto length = findNameId(ParseResult.context, "length").value();
+  const auto add = findNameId(ParseResult.context, "add").value();
+  REQUIRE_EQ(ParseResult.context.executors[0].words,
+             std::vector<Word>{
+                 {WordType::Name, length}, {WordType::Name, add}, {WordType::Tuple, 0}, {WordType::PlaceHolder, 1}});
   REQUIRE_EQ(ParseResult.context.tuples.size(), 1);
   REQUIRE(ParseResult.context.tuples[0].connectedNameIndexOpt);
-  CHECK_EQ(ParseResult.context.tuples[0].connectedNameIndexOpt.value(), 1);
+  CHECK_EQ(ParseResult.context.tuples[0].connectedNameIndexOpt.value(), add);
   REQUIRE_EQ(ParseResult.context.tuples[0].words, std::vector<Word>{{WordType::IntegerNumber, 0}, {WordType::PlaceHolder, 0}});
 }
 
@@ -222,8 +287,9 @@ TEST_CASE("assignment")
   auto ParseResult = toParseResult("inc2: {inc inc}");
   REQUIRE_EQ(ParseResult.sentences.size(), 1);
   REQUIRE_EQ(ParseResult.context.blocks.size(), 1);
+  const auto inc2 = findNameId(ParseResult.context, "inc2").value();
   REQUIRE_EQ(ParseResult.sentences[0].words,
-             std::vector<Word>{{WordType::Name, 0}, {WordType::Assignment, 0}, {WordType::Block, 0}});
+             std::vector<Word>{{WordType::Name, inc2}, {WordType::Assignment, 0}, {WordType::Block, 0}});
 }
 
 TEST_CASE("block")
@@ -233,9 +299,13 @@ TEST_CASE("block")
   auto ParseResult = toParseResult("{div |{to_double sum} length| (1 2 3 4 5 6)}");
   REQUIRE_EQ(ParseResult.sentences.size(), 1);
   REQUIRE_EQ(ParseResult.context.blocks.size(), 2);
-  REQUIRE_EQ(ParseResult.context.blocks[0].words, std::vector<Word>{{WordType::Name, 1}, {WordType::Name, 2}});
+  const auto div = findNameId(ParseResult.context, "div").value();
+  const auto toDouble = findNameId(ParseResult.context, "to_double").value();
+  const auto sum = findNameId(ParseResult.context, "sum").value();
+  REQUIRE_EQ(ParseResult.context.blocks[0].words,
+             std::vector<Word>{{WordType::Name, toDouble}, {WordType::Name, sum}});
   REQUIRE_EQ(ParseResult.context.blocks[1].words,
-             std::vector<Word>{{WordType::Name, 0}, {WordType::Executor, 0}, {WordType::IntegerArray, 0}});
+             std::vector<Word>{{WordType::Name, div}, {WordType::Executor, 0}, {WordType::IntegerArray, 0}});
 }
 
 #endif
@@ -6,12 +6,16 @@ module;
 #include <optional>
 #include <span>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 export module anka:parser;
 
 import :tokenizer;
 import :interpreter_state;
+import :bit_array;
+import :nested_array;
+import :profiler;
 
 namespace anka
 {
@@ -63,8 +67,7 @@ auto addNameWord(const std::string_view content, anka::Context &context, TokenFo
     return createWord(context, false);
   }
 
-  context.names.push_back(value);
-  return {anka::WordType::Name, context.names.size() - 1};
+  return {anka::WordType::Name, internName(context, value)};
 }
 
 template <typename T> auto throwNumberTokenError(const std::string_view content, anka::Token token) -> T
@@ -137,6 +140,14 @@ auto extractWords(const std::string_view content, anka::Context &context, TokenF
     case TokenType::NumberDouble:
       words.emplace_back(addNumberWord<double>(content, context, tokenIter));
       break;
+    case TokenType::NumberArray:
+      // numbers followed by other words, only arrays of numbers are parsed without a word per element
+      forEachArrayNumber(content, *(tokenIter++), [&](const Token &token) {
+        words.emplace_back(token.type == TokenType::NumberInt
+                               ? createWord(context, toNumber<int>(content, token))
+                               : createWord(context, toNumber<double>(content, token)));
+      });
+      break;
     case TokenType::Placeholder:
       words.emplace_back(addPlaceHolderWord(content, tokenIter));
       break;
@@ -223,16 +234,93 @@ auto extractExecutor(const std::string_view content, anka::Context &context, Tok
                                                          TokenType::Executor)});
 }
 
+template <typename T>
+auto toNumberArray(const std::string_view content, anka::Token token, size_t count) -> std::vector<T>
+{
+  std::vector<T> values;
+  values.reserve(count);
+  anka::forEachArrayNumber(content, token,
+                           [&](const anka::Token &number) { values.push_back(toNumber<T>(content, number)); });
+  return values;
+}
+
+// Parses a literal of only numbers straight from the content into an array, without a token or a word for every
+// element. Returns nothing if the literal contains anything else.
+auto tryExtractNumberArray(const std::string_view content, anka::Context &context,
+                           TokenForwardIterator auto &tokenIter, TokenForwardIterator auto tokensEnd)
+    -> std::optional<anka::Word>
+{
+  using namespace anka;
+
+  if (tokenIter == tokensEnd || tokenIter->type != TokenType::NumberArray)
+    return std::nullopt;
+  const auto arrayEnd = std::next(tokenIter);
+  if (arrayEnd == tokensEnd || arrayEnd->type != TokenType::ArrayEnd)
+    return std::nullopt;
+
+  // the first pass finds the type and the size, so the array is allocated once
+  std::optional<TokenType> expectedTypeOpt;
+  size_t count = 0;
+  forEachArrayNumber(content, *tokenIter, [&](const Token &number) {
+    if (!expectedTypeOpt)
+      expectedTypeOpt = number.type;
+    else if (number.type != expectedTypeOpt.value())
+      throw ParseError{number, std::format("Arrays should have elements of the same type, expected {} but found {}",
+                                           toString(expectedTypeOpt.value()), toString(number.type))};
+    ++count;
+  });
+
+  auto word = expectedTypeOpt == TokenType::NumberInt
+                  ? createWord(context, toNumberArray<int>(content, *tokenIter, count))
+                  : createWord(context, toNumberArray<double>(content, *tokenIter, count));
+  tokenIter = std::next(arrayEnd);
+  return word;
+}
+
+// Values of the element words of an array literal.
+template <typename T>
+auto getElementValues(const anka::Context &context, const std::vector<anka::Word> &words)
+    -> std::conditional_t<std::is_same_v<T, bool>, anka::BitArray, std::vector<T>>
+{
+  std::conditional_t<std::is_same_v<T, bool>, anka::BitArray, std::vector<T>> values;
+  values.reserve(words.size());
+  for (const auto &word : words)
+  {
+    values.push_back(anka::getValue<T>(context, word.index));
+  }
+  return values;
+}
+
+// Copies the rows the words refer to into one nested array.
+template <typename T, typename Row>
+auto toNestedArray(const std::vector<anka::Word> &words, const anka::Pool<Row> &rows) -> anka::NestedArray<T>
+{
+  anka::NestedArray<T> nested;
+  for (const auto &word : words)
+  {
+    nested.push_back(rows[word.index]);
+  }
+  return nested;
+}
+
 auto extractArray(const std::string_view content, anka::Context &context, TokenForwardIterator auto &tokenIter,
                   TokenForwardIterator auto tokensEnd) -> anka::Word
 {
   using namespace anka;
 
+  if (auto wordOpt = tryExtractNumberArray(content, context, tokenIter, tokensEnd))
+    return wordOpt.value();
+
   auto startToken = *tokenIter;
 
-  Context arrayContext;
-  auto words = extractWords(content, arrayContext, tokenIter, tokensEnd, {TokenType::SentenceEnd, TokenType::TupleEnd},
+  // the elements are parsed into the context and dropped once the array holds their values
+  const auto mark = markContext(context);
+  auto words = extractWords(content, context, tokenIter, tokensEnd, {TokenType::SentenceEnd, TokenType::TupleEnd},
                             TokenType::ArrayEnd);
+  const auto replaceElements = [&context, &mark](auto array) {
+    truncateContext(context, mark);
+    return createWord(context, std::move(array));
+  };
 
   if (words.empty())
   {
@@ -241,9 +329,10 @@ auto extractArray(const std::string_view content, anka::Context &context, TokenF
 
   auto expectedType = words.front().type;
   if (!(expectedType == WordType::IntegerNumber || expectedType == WordType::Boolean ||
-        expectedType == WordType::DoubleNumber))
+        expectedType == WordType::DoubleNumber || expectedType == WordType::IntegerArray ||
+        expectedType == WordType::DoubleArray || expectedType == WordType::BooleanArray))
   {
-    throw ParseError{startToken, "Only boolean, integer or double arrays are supported"};
+    throw ParseError{startToken, "Only boolean, integer or double arrays and arrays of them are supported"};
   }
 
   if (!std::all_of(words.begin(), words.end(), [expectedType](const Word &word) { return word.type == expectedType; }))
@@ -253,17 +342,32 @@ auto extractArray(const std::string_view content, anka::Context &context, TokenF
 
   if (expectedType == WordType::IntegerNumber)
   {
-    return createWord(context, std::move(arrayContext.integerNumbers));
+    return replaceElements(getElementValues<int>(context, words));
   }
 
   if (expectedType == WordType::Boolean)
   {
-    return createWord(context, std::move(arrayContext.booleans));
+    return replaceElements(getElementValues<bool>(context, words));
   }
 
   if (expectedType == WordType::DoubleNumber)
   {
-    return createWord(context, std::move(arrayContext.doubleNumbers));
+    return replaceElements(getElementValues<double>(context, words));
+  }
+
+  if (expectedType == WordType::IntegerArray)
+  {
+    return replaceElements(toNestedArray<int>(words, context.integerArrays));
+  }
+
+  if (expectedType == WordType::DoubleArray)
+  {
+    return replaceElements(toNestedArray<double>(words, context.doubleArrays));
+  }
+
+  if (expectedType == WordType::BooleanArray)
+  {
+    return replaceElements(toNestedArray<bool>(words, context.booleanArrays));
   }
 
   throw ParseError{startToken, "Fatal Error: Could not extract array"};
@@ -273,6 +377,9 @@ namespace anka
 {
 export auto parse(const std::string_view content, std::span<Token> tokens, Context &context) -> std::vector<Sentence>
 {
+  ProfileScope scope{ProfilePhase::Parse, "parse"};
+  scope.setElements(tokens.size());
+
   std::vector<Sentence> sentences;
   for (auto tokenIter = tokens.begin(); tokenIter != tokens.end();)
   {
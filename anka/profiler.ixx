@@ -0,0 +1,275 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+export module anka:profiler;
+
+namespace anka
+{
+
+export enum class ProfilePhase
+{
+  Tokenize,
+  Parse,
+  Compile,
+  Dispatch,
+  Builtin,
+  Block,
+  Executor,
+  Release
+};
+
+export auto toString(ProfilePhase phase) -> std::string
+{
+  switch (phase)
+  {
+  case ProfilePhase::Tokenize:
+    return "tokenize";
+  case ProfilePhase::Parse:
+    return "parse";
+  case ProfilePhase::Compile:
+    return "compile";
+  case ProfilePhase::Dispatch:
+    return "dispatch";
+  case ProfilePhase::Builtin:
+    return "builtin";
+  case ProfilePhase::Block:
+    return "block";
+  case ProfilePhase::Executor:
+    return "executor";
+  case ProfilePhase::Release:
+    return "release";
+  default:
+    return "";
+  }
+}
+
+using ProfileClock = std::chrono::steady_clock;
+
+struct ProfileRecord
+{
+  size_t calls = 0;
+  ProfileClock::duration time{};
+  size_t elements = 0;
+  // bytes of the values created in the scopes themselves, not in the scopes they contain
+  size_t bytes = 0;
+};
+
+struct PoolAllocations
+{
+  size_t values = 0;
+  size_t bytes = 0;
+};
+
+struct TraceEvent
+{
+  ProfilePhase phase;
+  std::string name;
+  ProfileClock::time_point start;
+  ProfileClock::duration duration;
+  size_t thread;
+};
+
+// the trace of a long run is cut off instead of taking all the memory
+constexpr size_t maxTraceEvents = 1 << 20;
+
+struct ProfileState
+{
+  std::mutex mutex;
+  std::map<std::pair<ProfilePhase, std::string>, ProfileRecord> records;
+  std::map<std::string, PoolAllocations> pools;
+  std::vector<TraceEvent> events;
+  bool tracing = false;
+  ProfileClock::time_point start;
+};
+
+// Checked by every scope, so profiling costs one relaxed load and a branch while it is off.
+std::atomic<bool> profiling{false};
+
+auto getProfileState() -> ProfileState &
+{
+  static ProfileState state;
+  return state;
+}
+
+auto getThreadNumber() -> size_t
+{
+  static std::atomic<size_t> nextNumber{0};
+  thread_local const size_t number = nextNumber++;
+  return number;
+}
+
+export auto isProfiling() -> bool
+{
+  return profiling.load(std::memory_order_relaxed);
+}
+
+// Clears the previous measurements, the trace keeps every scope for getChromeTrace.
+export auto startProfiling(bool trace) -> void
+{
+  auto &state = getProfileState();
+  {
+    std::lock_guard lock(state.mutex);
+    state.records.clear();
+    state.pools.clear();
+    state.events.clear();
+    state.tracing = trace;
+    state.start = ProfileClock::now();
+  }
+  profiling.store(true);
+}
+
+export auto stopProfiling() -> void
+{
+  profiling.store(false);
+}
+
+class ProfileScope;
+thread_local ProfileScope *currentScope = nullptr;
+
+// Measures the time from its construction to its destruction under the phase and name, scopes nest.
+export class ProfileScope
+{
+public:
+  ProfileScope(ProfilePhase phase, std::string_view name) : active(isProfiling()), phase(phase)
+  {
+    if (!active)
+      return;
+
+    this->name = name;
+    parent = currentScope;
+    currentScope = this;
+    start = ProfileClock::now();
+  }
+
+  ~ProfileScope()
+  {
+    if (!active)
+      return;
+
+    const auto duration = ProfileClock::now() - start;
+    currentScope = parent;
+
+    auto &state = getProfileState();
+    std::lock_guard lock(state.mutex);
+    auto &record = state.records[{phase, name}];
+    record.calls += 1;
+    record.time += duration;
+    record.elements += elements;
+    record.bytes += bytes;
+
+    if (state.tracing && state.events.size() < maxTraceEvents)
+      state.events.push_back({phase, std::move(name), start, duration, getThreadNumber()});
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  auto operator=(const ProfileScope &) -> ProfileScope & = delete;
+
+  auto isActive() const -> bool
+  {
+    return active;
+  }
+
+  // Number of elements the scope processed, for the throughput.
+  auto setElements(size_t count) -> void
+  {
+    elements = count;
+  }
+
+  auto addBytes(size_t count) -> void
+  {
+    bytes += count;
+  }
+
+private:
+  bool active;
+  ProfilePhase phase;
+  std::string name;
+  ProfileScope *parent = nullptr;
+  ProfileClock::time_point start;
+  size_t elements = 0;
+  size_t bytes = 0;
+};
+
+// Counts a value of bytes added to the pool, towards the innermost scope of the thread.
+export auto recordAllocation(std::string_view pool, size_t bytes) -> void
+{
+  if (currentScope != nullptr)
+    currentScope->addBytes(bytes);
+
+  auto &state = getProfileState();
+  std::lock_guard lock(state.mutex);
+  auto &allocations = state.pools[std::string(pool)];
+  allocations.values += 1;
+  allocations.bytes += bytes;
+}
+
+// Table of the scopes sorted by their time, then the values created per pool. The times of nested scopes are
+// included in the times of the scopes around them.
+export auto getProfileReport() -> std::string
+{
+  auto &state = getProfileState();
+  std::lock_guard lock(state.mutex);
+
+  std::vector<std::pair<std::pair<ProfilePhase, std::string>, ProfileRecord>> records(state.records.begin(),
+                                                                                       state.records.end());
+  std::ranges::sort(records, std::greater{}, [](const auto &entry) { return entry.second.time; });
+
+  auto report = std::format("{:<10} {:<24} {:>10} {:>12} {:>14} {:>12} {:>14}\n", "phase", "name", "calls", "ms",
+                            "elements", "Melements/s", "bytes");
+  for (const auto &[key, record] : records)
+  {
+    const auto milliseconds = std::chrono::duration<double, std::milli>(record.time).count();
+    const auto throughput = milliseconds > 0 ? static_cast<double>(record.elements) / milliseconds / 1000 : 0.0;
+    report += std::format("{:<10} {:<24} {:>10} {:>12.3f} {:>14} {:>12.1f} {:>14}\n", toString(key.first),
+                          key.second, record.calls, milliseconds, record.elements, throughput, record.bytes);
+  }
+
+  report += std::format("\n{:<24} {:>10} {:>14}\n", "pool", "values", "bytes");
+  for (const auto &[pool, allocations] : state.pools)
+    report += std::format("{:<24} {:>10} {:>14}\n", pool, allocations.values, allocations.bytes);
+  return report;
+}
+
+auto escapeJson(std::string_view text) -> std::string
+{
+  std::string res;
+  for (const auto ch : text)
+  {
+    if (ch == '"' || ch == '\\')
+      res += '\\';
+    res += ch;
+  }
+  return res;
+}
+
+// Trace of the scopes in the Chrome trace event format, for chrome://tracing or Perfetto.
+export auto getChromeTrace() -> std::string
+{
+  auto &state = getProfileState();
+  std::lock_guard lock(state.mutex);
+
+  std::string trace = "{\"traceEvents\": [";
+  for (size_t i = 0; i < state.events.size(); ++i)
+  {
+    const auto &event = state.events[i];
+    const auto start = std::chrono::duration<double, std::micro>(event.start - state.start).count();
+    const auto duration = std::chrono::duration<double, std::micro>(event.duration).count();
+    trace += std::format("{}\n{{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, "
+                         "\"pid\": 1, \"tid\": {}}}",
+                         i == 0 ? "" : ",", escapeJson(event.name), toString(event.phase), start, duration,
+                         event.thread);
+  }
+  trace += "\n]}\n";
+  return trace;
+}
+
+} // namespace anka
@@ -0,0 +1,194 @@
+module;
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+export module anka:sorting;
+
+import :thread_pool;
+
+namespace anka
+{
+
+// Smaller arrays are sorted by comparing their keys.
+constexpr size_t radixSortThreshold = 256;
+
+// Unsigned integer that sorts like the values of type T, the small integers are widened to int.
+export template <typename T>
+using SortKey = std::conditional_t<sizeof(T) <= sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+
+auto toSortKey(int value) -> std::uint32_t
+{
+  return std::bit_cast<std::uint32_t>(value) ^ 0x80000000u;
+}
+
+auto toSortKey(std::int64_t value) -> std::uint64_t
+{
+  return std::bit_cast<std::uint64_t>(value) ^ (std::uint64_t{1} << 63);
+}
+
+// Negative numbers sort in reverse, so all their bits are flipped. -0.0 comes before 0.0.
+auto toSortKey(float value) -> std::uint32_t
+{
+  const auto bits = std::bit_cast<std::uint32_t>(value);
+  return (bits >> 31) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+auto toSortKey(double value) -> std::uint64_t
+{
+  const auto bits = std::bit_cast<std::uint64_t>(value);
+  return (bits >> 63) != 0 ? ~bits : bits | (std::uint64_t{1} << 63);
+}
+
+template <typename T> auto fromSortKey(SortKey<T> key) -> T
+{
+  if constexpr (std::is_same_v<T, double>)
+    return std::bit_cast<double>((key >> 63) != 0 ? key & ~(std::uint64_t{1} << 63) : ~key);
+  else if constexpr (std::is_same_v<T, float>)
+    return std::bit_cast<float>((key >> 31) != 0 ? key & ~0x80000000u : ~key);
+  else if constexpr (std::is_same_v<T, std::int64_t>)
+    return std::bit_cast<std::int64_t>(key ^ (std::uint64_t{1} << 63));
+  else
+    return static_cast<T>(std::bit_cast<int>(key ^ 0x80000000u));
+}
+
+template <typename T> auto toSortKeys(const std::vector<T> &vec) -> std::vector<SortKey<T>>
+{
+  std::vector<SortKey<T>> keys(vec.size());
+  parallelFor(vec.size(), [&](size_t begin, size_t end) {
+    std::transform(vec.begin() + begin, vec.begin() + end, keys.begin() + begin,
+                   [](T value) { return toSortKey(value); });
+  });
+  return keys;
+}
+
+using Histogram = std::array<size_t, 256>;
+
+// One stable counting pass over the byte at shift, returns false if all keys have the same byte there. Every chunk
+// counts its bytes, then writes its keys after the ones with smaller bytes and after the same bytes of the chunks
+// before it. The indices are moved along with their keys when given.
+template <typename Key>
+auto radixPass(std::span<const Key> keys, std::span<const int> indices, std::span<Key> keysOut,
+               std::span<int> indicesOut, unsigned shift) -> bool
+{
+  std::vector<Histogram> offsets(getChunkCount(keys.size()));
+  parallelFor(keys.size(), [&](size_t begin, size_t end) {
+    auto &counts = offsets[begin / parallelChunkSize];
+    counts.fill(0);
+    for (auto i = begin; i < end; ++i)
+    {
+      ++counts[(keys[i] >> shift) & 0xff];
+    }
+  });
+
+  size_t offset = 0;
+  for (size_t byte = 0; byte < 256; ++byte)
+  {
+    const auto byteBegin = offset;
+    for (auto &counts : offsets)
+    {
+      const auto count = counts[byte];
+      counts[byte] = offset;
+      offset += count;
+    }
+    if (offset - byteBegin == keys.size())
+      return false;
+  }
+
+  parallelFor(keys.size(), [&](size_t begin, size_t end) {
+    auto &next = offsets[begin / parallelChunkSize];
+    for (auto i = begin; i < end; ++i)
+    {
+      const auto position = next[(keys[i] >> shift) & 0xff]++;
+      keysOut[position] = keys[i];
+      if (!indices.empty())
+        indicesOut[position] = indices[i];
+    }
+  });
+  return true;
+}
+
+// LSD radix sort with one pass per byte, indices can be empty or are reordered like the keys.
+template <typename Key> auto radixSort(std::vector<Key> &keys, std::vector<int> &indices) -> void
+{
+  std::vector<Key> keyBuffer(keys.size());
+  std::vector<int> indexBuffer(indices.size());
+  for (unsigned shift = 0; shift < 8 * sizeof(Key); shift += 8)
+  {
+    if (!radixPass<Key>(keys, indices, keyBuffer, indexBuffer, shift))
+      continue;
+
+    keys.swap(keyBuffer);
+    indices.swap(indexBuffer);
+  }
+}
+
+// Sorts the values in ascending order.
+export template <typename T> auto sortValues(std::vector<T> &vec) -> void
+{
+  if (vec.size() < radixSortThreshold)
+  {
+    std::ranges::sort(vec, std::less{}, [](T value) { return toSortKey(value); });
+    return;
+  }
+
+  auto keys = toSortKeys(vec);
+  std::vector<int> noIndices;
+  radixSort(keys, noIndices);
+  parallelFor(vec.size(), [&](size_t begin, size_t end) {
+    std::transform(keys.begin() + begin, keys.begin() + end, vec.begin() + begin, &fromSortKey<T>);
+  });
+}
+
+// Indices of the values in ascending order, equal values keep their order.
+export template <typename T> auto gradeValues(const std::vector<T> &vec) -> std::vector<int>
+{
+  std::vector<int> indices(vec.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  if (vec.size() < radixSortThreshold)
+  {
+    std::ranges::stable_sort(indices, std::less{}, [&vec](int index) { return toSortKey(vec[index]); });
+    return indices;
+  }
+
+  auto keys = toSortKeys(vec);
+  radixSort(keys, indices);
+  return indices;
+}
+
+// Moves the count smallest or largest values to the front of vec in order and drops the others. Few values are
+// selected without sorting the rest.
+export template <typename T> auto selectValues(std::vector<T> &vec, size_t count, bool largest) -> void
+{
+  count = std::min(count, vec.size());
+  if (count * 8 >= vec.size())
+  {
+    sortValues(vec);
+    if (largest)
+      std::reverse(vec.begin(), vec.end());
+  }
+  else
+  {
+    const auto key = [](T value) { return toSortKey(value); };
+    const auto middle = vec.begin() + count;
+    if (largest)
+    {
+      std::ranges::nth_element(vec, middle, std::greater{}, key);
+      std::ranges::sort(vec.begin(), middle, std::greater{}, key);
+    }
+    else
+    {
+      std::ranges::nth_element(vec, middle, std::less{}, key);
+      std::ranges::sort(vec.begin(), middle, std::less{}, key);
+    }
+  }
+  vec.resize(count);
+}
+
+} // namespace anka
@@ -2,6 +2,8 @@ module;
 #include <format>
 #include <optional>
 #include <string>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 #include <range/v3/range/conversion.hpp>
@@ -26,17 +28,46 @@ export auto anka::getFoldableWord(const anka::Context &context, const anka::Word
   if (word.type != WordType::Name)
     return word;
 
-  const auto &name = context.names[word.index];
-
-  if (!getInternalFunctionDefinitionsWithName(name).empty())
+  if (isInternalFunction(word.index))
   {
     return word;
   }
 
-  if (auto iter = context.userDefinedNames.find(name); iter != context.userDefinedNames.end())
-    return iter->second;
+  return context.userDefinedNames[word.index];
+}
+
+// Number of values and bytes of their elements in every pool of the context.
+export auto getMemoryReport(const Context &context) -> std::string
+{
+  auto report = std::format("{:<24} {:>10} {:>14}\n", "pool", "values", "bytes");
+  const auto addPool = [&report](WordType type, const auto &pool) {
+    size_t bytes = 0;
+    for (const auto &value : pool)
+      bytes += getValueBytes(value);
+    report += std::format("{:<24} {:>10} {:>14}\n", getPoolName(type), pool.size(), bytes);
+  };
 
-  return std::nullopt;
+  addPool(WordType::IntegerNumber, context.integerNumbers);
+  addPool(WordType::IntegerArray, context.integerArrays);
+  addPool(WordType::DoubleNumber, context.doubleNumbers);
+  addPool(WordType::DoubleArray, context.doubleArrays);
+  addPool(WordType::Boolean, context.booleans);
+  addPool(WordType::BooleanArray, context.booleanArrays);
+  addPool(WordType::IntegerRange, context.integerRanges);
+  addPool(WordType::Dictionary, context.dictionaries);
+  addPool(WordType::NestedIntegerArray, context.nestedIntegerArrays);
+  addPool(WordType::NestedDoubleArray, context.nestedDoubleArrays);
+  addPool(WordType::NestedBooleanArray, context.nestedBooleanArrays);
+  addPool(WordType::LongNumber, context.longNumbers);
+  addPool(WordType::LongArray, context.longArrays);
+  addPool(WordType::FloatArray, context.floatArrays);
+  addPool(WordType::Int8Array, context.int8Arrays);
+  addPool(WordType::Int16Array, context.int16Arrays);
+  addPool(WordType::UInt8Array, context.uint8Arrays);
+  addPool(WordType::Tuple, context.tuples);
+  addPool(WordType::Executor, context.executors);
+  addPool(WordType::Block, context.blocks);
+  return report;
 }
 
 auto anka::toString(const anka::Context &context, const anka::Word &word) -> std::string
@@ -51,6 +82,8 @@ auto anka::toString(const anka::Context &context, const anka::Word &word) -> std
     auto &v = context.integerArrays[word.index];
     return fmt::format("({})", fmt::join(v, " "));
   }
+  case WordType::IntegerRange:
+    return fmt::format("({})", fmt::join(materialize(context.integerRanges[word.index]), " "));
   case WordType::DoubleNumber:
     return formatDouble(context.doubleNumbers[word.index]);
   case WordType::DoubleArray: {
@@ -58,6 +91,71 @@ auto anka::toString(const anka::Context &context, const anka::Word &word) -> std
              ranges::to<std::vector<std::string>>;
     return fmt::format("({})", fmt::join(v, " "));
   }
+  case WordType::LongNumber:
+    return std::format("{}", context.longNumbers[word.index]);
+  case WordType::LongArray: {
+    auto &v = context.longArrays[word.index];
+    return fmt::format("({})", fmt::join(v, " "));
+  }
+  case WordType::FloatArray:
+  case WordType::Int8Array:
+  case WordType::Int16Array:
+  case WordType::UInt8Array: {
+    // small integers are printed as numbers, not as characters
+    std::vector<std::string> values;
+    visitStorageArray(context, word, [&values](auto elements) {
+      for (const auto value : elements)
+      {
+        if constexpr (std::is_same_v<decltype(value), const float>)
+          values.push_back(formatDouble(value));
+        else
+          values.push_back(std::format("{}", static_cast<int>(value)));
+      }
+    });
+    return fmt::format("({})", fmt::join(values, " "));
+  }
+  case WordType::NestedIntegerArray: {
+    const auto &nested = context.nestedIntegerArrays[word.index];
+    std::vector<std::string> rows;
+    for (size_t i = 0; i < nested.size(); ++i)
+      rows.push_back(fmt::format("({})", fmt::join(nested.row(i), " ")));
+    return fmt::format("({})", fmt::join(rows, " "));
+  }
+  case WordType::NestedDoubleArray: {
+    const auto &nested = context.nestedDoubleArrays[word.index];
+    std::vector<std::string> rows;
+    for (size_t i = 0; i < nested.size(); ++i)
+    {
+      auto row = nested.row(i) | ranges::views::transform(formatDouble) | ranges::to<std::vector<std::string>>;
+      rows.push_back(fmt::format("({})", fmt::join(row, " ")));
+    }
+    return fmt::format("({})", fmt::join(rows, " "));
+  }
+  case WordType::NestedBooleanArray: {
+    const auto &nested = context.nestedBooleanArrays[word.index];
+    const auto values = nested.values().begin();
+    const auto &offsets = nested.offsets();
+    std::vector<std::string> rows;
+    for (size_t i = 0; i < nested.size(); ++i)
+      rows.push_back(fmt::format("({})", fmt::join(values + offsets[i], values + offsets[i + 1], " ")));
+    return fmt::format("({})", fmt::join(rows, " "));
+  }
+  case WordType::Dictionary: {
+    const auto &dictionary = context.dictionaries[word.index];
+    std::vector<std::string> entries;
+    std::visit(
+        [&](const auto &values) {
+          for (size_t i = 0; i < dictionary.size(); ++i)
+          {
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(values)>, std::vector<double>>)
+              entries.push_back(std::format("{}: {}", dictionary.keys()[i], formatDouble(values[i])));
+            else
+              entries.push_back(std::format("{}: {}", dictionary.keys()[i], values[i]));
+          }
+        },
+        dictionary.values());
+    return fmt::format("({})", fmt::join(entries, " "));
+  }
   case WordType::Boolean:
     return std::format("{}", context.booleans[word.index]);
   case WordType::Block:
@@ -76,7 +174,7 @@ auto anka::toString(const anka::Context &context, const anka::Word &word) -> std
   case WordType::Name: {
     const auto &name = context.names[word.index];
 
-    auto definitions = getInternalFunctionDefinitionsWithName(name);
+    const auto &definitions = getInternalFunctionDefinitionsWithId(word.index);
     auto definitionTexts = definitions | ranges::views::transform([](const auto &def) { return anka::toString(def); }) |
                            ranges::to<std::vector<std::string>>();
 
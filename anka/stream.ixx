@@ -0,0 +1,237 @@
+module;
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+export module anka:stream;
+
+import :interpreter_state;
+import :errors;
+import :type_system;
+import :internal_functions;
+import :executor;
+
+namespace anka
+{
+
+// Functions that combine the results of a reduction over two chunks into the result over both of them.
+auto getReductionMergers() -> const std::unordered_map<std::string, std::string> &
+{
+  static const std::unordered_map<std::string, std::string> mergers{
+      {"sum", "add"}, {"length", "add"}, {"count", "add"}, {"all_of", "and"}, {"any_of", "or"},
+  };
+  return mergers;
+}
+
+// Functions that foldl can be split over chunks with, they merge their own partial results.
+auto isAssociativeFunction(const std::string &name) -> bool
+{
+  return name == "add" || name == "mul" || name == "and" || name == "or" || name == "min" || name == "max";
+}
+
+// Whether the function maps every element of an array on its own, then it gives the same elements over the chunks
+// of an array as over the whole array. The conversions to the storage kinds only have array overloads.
+auto isElementWiseFunction(const Context &context, size_t nameId) -> bool
+{
+  if (!isInternalFunction(nameId))
+    return false;
+
+  const auto &name = context.names[nameId];
+  if (name == "to_float" || name == "to_int8" || name == "to_int16" || name == "to_uint8")
+    return true;
+
+  const auto &definitions = getInternalFunctionDefinitionsWithId(nameId);
+  return !definitions.empty() && std::ranges::all_of(definitions, [](const InternalFunctionDefinition &definition) {
+    return isExpandable(definition.returnType) &&
+           std::ranges::all_of(definition.argumentTypes, [](const TypeVariant &type) { return isExpandable(type); });
+  });
+}
+
+// Throws unless the words from first on are element-wise functions and filters with them applied to the input, only
+// then the reductions over the chunks merge into the reduction over the whole input.
+auto checkReducedInput(const Context &context, const Sentence &sentence, size_t first, size_t inputId) -> void
+{
+  const auto &words = sentence.words;
+  for (auto i = first; i < words.size(); ++i)
+  {
+    const auto &word = words[i];
+    if (word.type == WordType::Name && word.index == inputId && i + 1 == words.size())
+      return;
+
+    auto isElementWise = false;
+    if (word.type == WordType::Name && i + 1 < words.size() && words[i + 1].type == WordType::Tuple)
+    {
+      // bound arguments, filter[f] keeps the elements f is true for
+      const auto &tuple = context.tuples[words[i + 1].index];
+      if (context.names[word.index] == "filter")
+        isElementWise = tuple.words.size() == 1 && tuple.words.front().type == WordType::Name &&
+                        isElementWiseFunction(context, tuple.words.front().index);
+      else
+        isElementWise = isElementWiseFunction(context, word.index);
+      ++i;
+    }
+    else if (word.type == WordType::Name)
+    {
+      isElementWise = isElementWiseFunction(context, word.index);
+    }
+
+    if (!isElementWise)
+      throw ExecutionError{word, std::nullopt,
+                           "A streamed reduction can only follow element-wise functions and filters of the input"};
+  }
+
+  throw ExecutionError{std::nullopt, std::nullopt, "A streamed reduction has to reduce the input"};
+}
+
+// Name id of the function that merges the results of the sentence over two chunks, if it ends in a reduction.
+auto findMerger(Context &context, const Sentence &sentence, size_t inputId) -> std::optional<size_t>
+{
+  const auto &words = sentence.words;
+  if (words.empty() || words.front().type != WordType::Name)
+    return std::nullopt;
+
+  const auto &name = context.names[words.front().index];
+  const auto &mergers = getReductionMergers();
+  if (auto iter = mergers.find(name); iter != mergers.end())
+  {
+    checkReducedInput(context, sentence, 1, inputId);
+    return internName(context, iter->second);
+  }
+
+  // foldl[f] with an associative f
+  if (name != "foldl" || words.size() < 2 || words[1].type != WordType::Tuple)
+    return std::nullopt;
+
+  const auto &tuple = context.tuples[words[1].index];
+  if (tuple.words.size() != 1 || tuple.words.front().type != WordType::Name)
+    return std::nullopt;
+
+  const auto functionId = tuple.words.front().index;
+  if (!isAssociativeFunction(context.names[functionId]))
+    return std::nullopt;
+
+  checkReducedInput(context, sentence, 2, inputId);
+  return functionId;
+}
+
+template <typename Array> auto writeElements(std::ostream &output, const Array &values) -> void
+{
+  std::string text;
+  for (auto value : values)
+  {
+    if constexpr (std::is_same_v<decltype(value), bool>)
+      text += value ? "1\n" : "0\n";
+    else if constexpr (sizeof(value) == 1) // int8 and uint8 values are numbers, not characters
+      text += std::format("{}\n", static_cast<int>(value));
+    else
+      text += std::format("{}\n", value);
+  }
+  output << text;
+}
+
+// Runs the last sentence of a program over the chunks of a large array. The sentences before it run once, before
+// the first chunk. If the sentence ends in a reduction (sum, length, count, all_of, any_of or foldl with add, mul,
+// and, or, min or max) its results are merged over the chunks, otherwise it has to produce an array that is written
+// to the output one element per line. Only element-wise functions give the same result as over the whole array, a
+// reduction that follows anything else throws.
+export class StreamExecution
+{
+public:
+  StreamExecution(Context &context, const std::vector<Sentence> &sentences, const std::string &inputName)
+      : context(context), inputId(internName(context, inputName))
+  {
+    if (sentences.empty())
+      throw ExecutionError{std::nullopt, std::nullopt, "Streaming needs a sentence to run over the chunks"};
+
+    execute(context, std::vector<Sentence>(sentences.begin(), sentences.end() - 1));
+    mergerOpt = findMerger(context, sentences.back(), inputId);
+    compiled = compile(context, std::vector<Sentence>{sentences.back()});
+    mark = markContext(context);
+  }
+
+  // Runs the sentence with the input name bound to the chunk, which has to be created after the constructor.
+  auto executeChunk(const Word &chunk, std::ostream &output) -> void
+  {
+    setUserDefinedName(context, inputId, chunk);
+    auto wordOpt = execute(context, compiled);
+    if (!wordOpt)
+      throw ExecutionError{std::nullopt, std::nullopt, "The streamed sentence did not produce a value"};
+
+    if (mergerOpt)
+    {
+      resultOpt = resultOpt ? merge(resultOpt.value(), wordOpt.value()) : wordOpt.value();
+    }
+    else
+    {
+      write(wordOpt.value(), output);
+    }
+
+    // only the merged result survives the chunk
+    std::vector<Word> roots;
+    if (resultOpt)
+      roots.push_back(resultOpt.value());
+    releaseTemporaries(context, mark, roots);
+    if (resultOpt)
+      resultOpt = roots.front();
+  }
+
+  // Merged result of a reduction over the chunks so far, none for element-wise sentences.
+  auto getResult() const -> std::optional<Word>
+  {
+    return resultOpt;
+  }
+
+private:
+  auto merge(const Word &lhs, const Word &rhs) -> Word
+  {
+    const auto merger = mergerOpt.value();
+    auto tuple = createWord(context, Tuple{{lhs, rhs}, merger});
+    auto wordOpt = execute(context, std::vector<Sentence>{Sentence{{Word{WordType::Name, merger}, tuple}}});
+    return wordOpt.value();
+  }
+
+  auto write(const Word &word, std::ostream &output) -> void
+  {
+    switch (word.type)
+    {
+    case WordType::IntegerArray:
+      writeElements(output, context.integerArrays[word.index]);
+      break;
+    case WordType::IntegerRange:
+      writeElements(output, materialize(context.integerRanges[word.index]));
+      break;
+    case WordType::DoubleArray:
+      writeElements(output, context.doubleArrays[word.index]);
+      break;
+    case WordType::BooleanArray:
+      writeElements(output, context.booleanArrays[word.index]);
+      break;
+    case WordType::LongArray:
+      writeElements(output, context.longArrays[word.index]);
+      break;
+    case WordType::FloatArray:
+    case WordType::Int8Array:
+    case WordType::Int16Array:
+    case WordType::UInt8Array:
+      visitStorageArray(context, word, [&output](auto values) { writeElements(output, values); });
+      break;
+    default:
+      throw ExecutionError{word, std::nullopt,
+                           "A streamed sentence has to end in a reduction that can be merged or produce an array"};
+    }
+  }
+
+  Context &context;
+  size_t inputId;
+  std::optional<size_t> mergerOpt;
+  std::vector<CompiledWords> compiled;
+  ContextMark mark;
+  std::optional<Word> resultOpt;
+};
+
+} // namespace anka
@@ -0,0 +1,236 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+export module anka:thread_pool;
+
+namespace anka
+{
+
+// Arrays smaller than this are processed on the calling thread.
+export constexpr size_t parallelThreshold = 1 << 16;
+
+// Large arrays are split in chunks of this size. Chunk boundaries only depend on the array size, so reductions
+// that combine the chunk results in order give the same result for any number of threads.
+export constexpr size_t parallelChunkSize = 1 << 14;
+
+thread_local bool isPoolWorker = false;
+// set while the thread that called run takes part in its job, so the calls its chunks make run inline
+thread_local bool isRunningJob = false;
+
+// Fixed set of threads that run one job at a time. A job is split in chunks that the threads claim from a shared
+// counter until none are left, the calling thread takes part in the work.
+export class ThreadPool
+{
+public:
+  explicit ThreadPool(size_t threadCount)
+  {
+    for (size_t i = 1; i < threadCount; ++i)
+    {
+      workers.emplace_back([this]() { workerLoop(); });
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  auto threadCount() const -> size_t
+  {
+    return workers.size() + 1;
+  }
+
+  // Calls func for every chunk index in [0, chunkCount) and returns once all of them are done. Nested calls and
+  // calls made while another job is running are executed on the calling thread.
+  auto run(size_t chunkCount, const std::function<void(size_t)> &func) -> void
+  {
+    const auto runInline = [&]() {
+      for (size_t i = 0; i < chunkCount; ++i)
+      {
+        func(i);
+      }
+    };
+
+    // nested calls never touch jobMutex, which their thread already owns
+    if (workers.empty() || isPoolWorker || isRunningJob || chunkCount < 2)
+    {
+      runInline();
+      return;
+    }
+
+    // another thread is running a job
+    std::unique_lock jobLock(jobMutex, std::try_to_lock);
+    if (!jobLock.owns_lock())
+    {
+      runInline();
+      return;
+    }
+
+    isRunningJob = true;
+    struct RunningJobReset
+    {
+      ~RunningJobReset()
+      {
+        isRunningJob = false;
+      }
+    } runningJobReset;
+
+    {
+      std::lock_guard lock(mutex);
+      nextChunk = 0;
+      jobChunkCount = chunkCount;
+      error = nullptr;
+      job = &func;
+      ++generation;
+    }
+    wake.notify_all();
+
+    work(func, chunkCount);
+
+    std::exception_ptr jobError;
+    {
+      std::unique_lock lock(mutex);
+      done.wait(lock, [this]() { return activeWorkers == 0; });
+      job = nullptr;
+      jobError = error;
+    }
+
+    if (jobError)
+      std::rethrow_exception(jobError);
+  }
+
+private:
+  auto work(const std::function<void(size_t)> &func, size_t chunkCount) -> void
+  {
+    for (auto chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1))
+    {
+      try
+      {
+        func(chunk);
+      }
+      catch (...)
+      {
+        std::lock_guard lock(mutex);
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+
+  auto workerLoop() -> void
+  {
+    isPoolWorker = true;
+    size_t seenGeneration = 0;
+    for (;;)
+    {
+      const std::function<void(size_t)> *currentJob = nullptr;
+      size_t chunkCount = 0;
+      {
+        std::unique_lock lock(mutex);
+        wake.wait(lock, [&]() { return stopping || (job != nullptr && generation != seenGeneration); });
+        if (stopping)
+          return;
+
+        seenGeneration = generation;
+        currentJob = job;
+        chunkCount = jobChunkCount;
+        ++activeWorkers;
+      }
+
+      work(*currentJob, chunkCount);
+
+      {
+        std::lock_guard lock(mutex);
+        if (--activeWorkers == 0)
+          done.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::thread> workers;
+
+  std::mutex jobMutex;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+
+  const std::function<void(size_t)> *job = nullptr;
+  size_t jobChunkCount = 0;
+  size_t generation = 0;
+  size_t activeWorkers = 0;
+  bool stopping = false;
+  std::exception_ptr error;
+  std::atomic<size_t> nextChunk = 0;
+};
+
+auto getDefaultThreadCount() -> size_t
+{
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+auto getThreadPoolPtr() -> std::unique_ptr<ThreadPool> &
+{
+  static auto pool = std::make_unique<ThreadPool>(getDefaultThreadCount());
+  return pool;
+}
+
+export auto getThreadPool() -> ThreadPool &
+{
+  return *getThreadPoolPtr();
+}
+
+// Should be called before any work is given to the pool.
+export auto setThreadCount(size_t count) -> void
+{
+  getThreadPoolPtr() = std::make_unique<ThreadPool>(std::max<size_t>(1, count));
+}
+
+export auto getThreadCount() -> size_t
+{
+  return getThreadPool().threadCount();
+}
+
+export auto getChunkCount(size_t size) -> size_t
+{
+  return (size + parallelChunkSize - 1) / parallelChunkSize;
+}
+
+export auto getChunkBegin(size_t chunk) -> size_t
+{
+  return chunk * parallelChunkSize;
+}
+
+export auto getChunkEnd(size_t chunk, size_t size) -> size_t
+{
+  return std::min(size, (chunk + 1) * parallelChunkSize);
+}
+
+// Calls func(begin, end) for all chunks of [0, size) on the thread pool.
+export template <typename Func> auto parallelFor(size_t size, Func &&func) -> void
+{
+  const std::function<void(size_t)> job = [size, &func](size_t chunk) {
+    func(getChunkBegin(chunk), getChunkEnd(chunk, size));
+  };
+  getThreadPool().run(getChunkCount(size), job);
+}
+
+} // namespace anka
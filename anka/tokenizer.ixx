@@ -1,54 +1,14 @@
 module;
+#include <algorithm>
+#include <array>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
-#include <cctype>
-#include <optional>
 export module anka:tokenizer;
 
-auto isDigit(const char c) -> bool
-{
-  return (c >= '0' && c <= '9');
-}
-
-auto isNumber(const char c) -> bool
-{
-  return (c >= '0' && c <= '9') || c == '-' || c == '.';
-}
-
-auto isEndLine(const char c) -> bool
-{
-  return c == '\n' || c == '\r';
-}
-
-auto isSpace(const char c) -> bool
-{
-  return std::isblank(static_cast<unsigned char>(c));
-}
-
-auto isName(const char c) -> bool
-{
-  auto ch = static_cast<unsigned char>(c);
-  return std::isalpha(ch) || std::isdigit(ch) || ch == '_';
-}
-
-template <typename Predicate>
-auto parseContinuously(Predicate predicate, const std::string_view content, size_t pos) -> size_t
-{
-  const auto b = content.begin() + pos;
-  const auto e = content.end();
-  auto next = std::ranges::find_if_not(b, e, predicate);
-  return std::distance(b, next);
-}
-
-template <typename Predicate> auto parseUntil(Predicate predicate, const std::string_view content, size_t pos) -> size_t
-{
-  const auto b = content.begin() + pos;
-  const auto e = content.end();
-  auto next = std::ranges::find_if(b, e, predicate);
-  return std::distance(b, next);
-}
+import :profiler;
 
 namespace anka
 {
@@ -68,6 +28,8 @@ export enum class TokenType
   Connector,
   NumberInt,
   NumberDouble,
+  // the numbers at the start of an array literal, separated by white space
+  NumberArray,
   SentenceEnd,
   Name,
   TupleStart,
@@ -85,6 +47,8 @@ export auto toString(TokenType type) -> std::string
     return "integer";
   case TokenType::NumberDouble:
     return "double";
+  case TokenType::NumberArray:
+    return "number array";
   case TokenType::Name:
     return "name";
   case TokenType::ArrayStart:
@@ -121,110 +85,335 @@ export struct Token
   auto operator<=>(const Token &) const = default;
 };
 
-export auto extractTokens(const std::string_view content) -> std::vector<Token>
+// Character classes that drive the tokenizer, every character that can not start or continue a token is Invalid.
+enum class CharClass : unsigned char
 {
-  std::vector<Token> tokens;
+  Invalid,
+  Digit,
+  Minus,
+  Dot,
+  Letter,
+  Underscore,
+  Space,
+  EndLine,
+  Comment,
+  SingleChar,
+};
 
-  constexpr const char array_start_char = '(';
-  constexpr const char array_end_char = ')';
-  constexpr const char tuple_start_char = '[';
-  constexpr const char tuple_end_char = ']';
-  constexpr const char placeholder_start_char = '_';
-  constexpr const char executor_char = '|';
-  constexpr const char block_start_char = '{';
-  constexpr const char block_end_char = '}';
-  constexpr const char assignment_char = ':';
-  constexpr const char comment_char = '#';
-
-  auto needSeparator = false;
-  auto addConnector = false;
-
-  auto singleCharTokens = std::vector<std::pair<const char, TokenType>>{
-      {array_start_char, TokenType::ArrayStart}, {array_end_char, TokenType::ArrayEnd},
-      {tuple_start_char, TokenType::TupleStart}, {tuple_end_char, TokenType::TupleEnd},
-      {executor_char, TokenType::Executor},      {block_start_char, TokenType::BlockStart},
-      {block_end_char, TokenType::BlockEnd},     {assignment_char, TokenType::Assignment},
-  };
+constexpr auto charClasses = []() {
+  std::array<CharClass, 256> classes{};
+  for (auto c = '0'; c <= '9'; ++c)
+    classes[c] = CharClass::Digit;
+  for (auto c = 'a'; c <= 'z'; ++c)
+    classes[c] = CharClass::Letter;
+  for (auto c = 'A'; c <= 'Z'; ++c)
+    classes[c] = CharClass::Letter;
+  classes['-'] = CharClass::Minus;
+  classes['.'] = CharClass::Dot;
+  classes['_'] = CharClass::Underscore;
+  classes[' '] = CharClass::Space;
+  classes['\t'] = CharClass::Space;
+  classes['\n'] = CharClass::EndLine;
+  classes['\r'] = CharClass::EndLine;
+  classes['#'] = CharClass::Comment;
+  for (auto c : {'(', ')', '[', ']', '|', '{', '}', ':'})
+    classes[c] = CharClass::SingleChar;
+  return classes;
+}();
 
-  size_t i = 0;
-  while (i < content.size())
-  {
-    const auto ch = content[i];
+constexpr auto singleCharTokens = []() {
+  std::array<TokenType, 256> types{};
+  types['('] = TokenType::ArrayStart;
+  types[')'] = TokenType::ArrayEnd;
+  types['['] = TokenType::TupleStart;
+  types[']'] = TokenType::TupleEnd;
+  types['|'] = TokenType::Executor;
+  types['{'] = TokenType::BlockStart;
+  types['}'] = TokenType::BlockEnd;
+  types[':'] = TokenType::Assignment;
+  return types;
+}();
 
-    if (auto iter = std::ranges::find(singleCharTokens, ch, &std::pair<const char, TokenType>::first);
-        iter != singleCharTokens.end())
-    {
-      tokens.push_back(Token{iter->second, i, 1});
-      needSeparator = false;
-    }
-    else if (ch == comment_char)
-    {
-      auto len = parseUntil(isEndLine, content, i);
-      if (len == std::string_view::npos)
-        return tokens;
-      i += len - 1;
-    }
-    else if (ch == placeholder_start_char)
-    {
-      auto len = parseContinuously(isDigit, content, i + 1);
-      tokens.push_back({TokenType::Placeholder, i, len + 1});
-    }
-    else if (isNumber(ch))
-    {
-      if (needSeparator)
-        throw TokenizerError{i, ch};
-      auto len = parseContinuously(isNumber, content, i);
-      auto str = std::string_view(content.data() + i, len);
-      auto type = (str.find('.') != std::string_view::npos) ? TokenType::NumberDouble : TokenType::NumberInt;
-      tokens.push_back(Token{type, i, len});
-      needSeparator = true;
-    }
-    else if (isName(ch))
-    {
-      if (needSeparator)
-        throw TokenizerError{i, ch};
+auto getCharClass(const char c) -> CharClass
+{
+  return charClasses[static_cast<unsigned char>(c)];
+}
 
-      auto len = parseContinuously(isName, content, i);
-      tokens.push_back(Token{TokenType::Name, i, len});
+auto isNumberClass(const CharClass cls) -> bool
+{
+  return cls == CharClass::Digit || cls == CharClass::Minus || cls == CharClass::Dot;
+}
 
-      // a name connected to a tuple
-      if (i + len < content.size() && content[i + len] == tuple_start_char)
+auto isNameClass(const CharClass cls) -> bool
+{
+  return cls == CharClass::Letter || cls == CharClass::Digit || cls == CharClass::Underscore;
+}
+
+// Single pass state machine over the characters of a text. The state is kept between calls of scan, so the text
+// can grow and a token that reaches the end of the text is continued by the next call.
+class TokenStateMachine
+{
+public:
+  // Tokenizes the text from the last scanned position to its end. Error positions are shifted by offset.
+  auto scan(const std::string_view text, std::vector<Token> &tokens, size_t offset) -> void
+  {
+    auto i = position;
+    const auto size = text.size();
+    while (i < size)
+    {
+      switch (mode)
       {
-        addConnector = true;
+      case Mode::Number:
+        while (i < size && isNumberClass(getCharClass(text[i])))
+        {
+          isDouble = isDouble || text[i] == '.';
+          ++i;
+        }
+        break;
+      case Mode::Name:
+        while (i < size && isNameClass(getCharClass(text[i])))
+          ++i;
+        break;
+      case Mode::Placeholder:
+        while (i < size && getCharClass(text[i]) == CharClass::Digit)
+          ++i;
+        break;
+      case Mode::EndLine:
+        while (i < size && getCharClass(text[i]) == CharClass::EndLine)
+          ++i;
+        break;
+      case Mode::Comment:
+        while (i < size && getCharClass(text[i]) != CharClass::EndLine)
+          ++i;
+        break;
+      case Mode::Start:
+        i = start(text, i, tokens, offset);
+        continue;
       }
 
-      needSeparator = true;
+      if (i < size)
+      {
+        const auto isName = mode == Mode::Name;
+        endToken(i, tokens);
+        // a name connected to a tuple
+        if (isName && text[i] == '[')
+          tokens.push_back(Token{TokenType::Connector, i, 0});
+      }
     }
-    else if (isEndLine(ch))
+    position = i;
+  }
+
+  // Ends the token at the end of the text and the last sentence.
+  auto finish(std::vector<Token> &tokens) -> void
+  {
+    endToken(position, tokens);
+    if (tokens.size() > 0 && tokens.back().type != TokenType::SentenceEnd)
+      tokens.push_back(Token{TokenType::SentenceEnd, position, 0});
+  }
+
+  // The first count characters of the text were removed.
+  auto shift(size_t count) -> void
+  {
+    position -= count;
+    tokenStart -= count;
+  }
+
+private:
+  enum class Mode
+  {
+    Start,
+    Number,
+    Name,
+    Placeholder,
+    EndLine,
+    Comment,
+  };
+
+  // Handles a character outside of a token and returns the next position.
+  auto start(const std::string_view text, size_t i, std::vector<Token> &tokens, size_t offset) -> size_t
+  {
+    const auto ch = text[i];
+    switch (getCharClass(ch))
     {
-      tokens.push_back(Token{TokenType::SentenceEnd, i, parseContinuously(isEndLine, content, i)});
+    case CharClass::SingleChar:
+      tokens.push_back(Token{singleCharTokens[static_cast<unsigned char>(ch)], i, 1});
       needSeparator = false;
-    }
-    else if (isSpace(ch))
-    {
-      i = i + parseContinuously(isSpace, content, i);
+      break;
+    case CharClass::Comment:
+      mode = Mode::Comment;
+      break;
+    case CharClass::Underscore:
+      beginToken(Mode::Placeholder, i);
+      break;
+    case CharClass::Digit:
+    case CharClass::Minus:
+    case CharClass::Dot:
+      if (needSeparator)
+        throw TokenizerError{i + offset, ch};
+      beginToken(Mode::Number, i);
+      isDouble = ch == '.';
+      needSeparator = true;
+      break;
+    case CharClass::Letter:
+      if (needSeparator)
+        throw TokenizerError{i + offset, ch};
+      beginToken(Mode::Name, i);
+      needSeparator = true;
+      break;
+    case CharClass::EndLine:
+      beginToken(Mode::EndLine, i);
       needSeparator = false;
-      continue;
-    }
-    else
-    {
-      throw TokenizerError{i, ch};
+      break;
+    case CharClass::Space:
+      needSeparator = false;
+      break;
+    default:
+      throw TokenizerError{i + offset, ch};
     }
+    return i + 1;
+  }
 
-    i = i + tokens.back().len;
-    if (addConnector)
+  auto beginToken(Mode tokenMode, size_t i) -> void
+  {
+    mode = tokenMode;
+    tokenStart = i;
+  }
+
+  auto endToken(size_t end, std::vector<Token> &tokens) -> void
+  {
+    const auto len = end - tokenStart;
+    switch (mode)
     {
-      const auto &lastToken = tokens.back();
-      tokens.push_back({TokenType::Connector, lastToken.start + lastToken.len, 0});
-      addConnector = false;
+    case Mode::Number:
+      endNumber(end, tokens);
+      break;
+    case Mode::Name:
+      tokens.push_back(Token{TokenType::Name, tokenStart, len});
+      break;
+    case Mode::Placeholder:
+      tokens.push_back(Token{TokenType::Placeholder, tokenStart, len});
+      break;
+    case Mode::EndLine:
+      tokens.push_back(Token{TokenType::SentenceEnd, tokenStart, len});
+      break;
+    default:
+      break;
     }
+    mode = Mode::Start;
   }
 
-  if (tokens.size() > 0 && tokens.back().type != TokenType::SentenceEnd)
+  // The numbers right after the start of an array are joined into one token, so large literals do not need a token
+  // per element.
+  auto endNumber(size_t end, std::vector<Token> &tokens) -> void
   {
-    tokens.push_back(Token{TokenType::SentenceEnd, content.size(), 0});
+    if (!tokens.empty() && tokens.back().type == TokenType::NumberArray)
+      tokens.back().len = end - tokens.back().start;
+    else if (!tokens.empty() && tokens.back().type == TokenType::ArrayStart)
+      tokens.push_back(Token{TokenType::NumberArray, tokenStart, end - tokenStart});
+    else
+      tokens.push_back(Token{isDouble ? TokenType::NumberDouble : TokenType::NumberInt, tokenStart, end - tokenStart});
   }
+
+  Mode mode = Mode::Start;
+  size_t position = 0;
+  size_t tokenStart = 0;
+  bool isDouble = false;
+  bool needSeparator = false;
+};
+
+export auto extractTokens(const std::string_view content) -> std::vector<Token>
+{
+  ProfileScope scope{ProfilePhase::Tokenize, "extractTokens"};
+  scope.setElements(content.size());
+
+  std::vector<Token> tokens;
+  TokenStateMachine machine;
+  machine.scan(content, tokens, 0);
+  machine.finish(tokens);
   return tokens;
 }
 
+// Calls func with a token for every number of a number array token.
+export template <typename Func>
+auto forEachArrayNumber(const std::string_view content, const Token &token, Func func) -> void
+{
+  const auto end = token.start + token.len;
+  auto pos = token.start;
+  while (pos < end)
+  {
+    while (getCharClass(content[pos]) == CharClass::Space)
+      ++pos;
+
+    auto numberEnd = pos;
+    auto isDouble = false;
+    while (numberEnd < end && getCharClass(content[numberEnd]) != CharClass::Space)
+    {
+      isDouble = isDouble || content[numberEnd] == '.';
+      ++numberEnd;
+    }
+    func(Token{isDouble ? TokenType::NumberDouble : TokenType::NumberInt, pos, numberEnd - pos});
+    pos = numberEnd;
+  }
+}
+
+// Complete lines of the input with their tokens, the token positions are relative to the text.
+export struct TokenizedLines
+{
+  std::string text;
+  std::vector<Token> tokens;
+  // position of the text in the whole input
+  size_t offset = 0;
+};
+
+// Tokenizes an input that arrives in chunks. Only the text after the last taken line is kept, so memory depends
+// on the length of a line and not on the size of the input.
+export class Tokenizer
+{
+public:
+  // Tokenizes the next chunk, a token at the end of the chunk can continue in the next one.
+  auto feed(const std::string_view chunk) -> void
+  {
+    ProfileScope scope{ProfilePhase::Tokenize, "feed"};
+    scope.setElements(chunk.size());
+
+    buffer.append(chunk);
+    machine.scan(buffer, tokens, offset);
+  }
+
+  // Ends the input, the last line is complete without an end of line.
+  auto finish() -> void
+  {
+    machine.finish(tokens);
+  }
+
+  // Takes the lines that are complete so far.
+  auto takeLines() -> std::optional<TokenizedLines>
+  {
+    auto lastEnd = std::find_if(tokens.rbegin(), tokens.rend(),
+                                [](const Token &token) { return token.type == TokenType::SentenceEnd; });
+    if (lastEnd == tokens.rend())
+      return std::nullopt;
+
+    const auto tokenCount = static_cast<size_t>(std::distance(lastEnd, tokens.rend()));
+    const auto textSize = lastEnd->start + lastEnd->len;
+
+    TokenizedLines lines{buffer.substr(0, textSize), {}, offset};
+    lines.tokens.assign(tokens.begin(), tokens.begin() + tokenCount);
+
+    buffer.erase(0, textSize);
+    tokens.erase(tokens.begin(), tokens.begin() + tokenCount);
+    for (auto &token : tokens)
+      token.start -= textSize;
+    machine.shift(textSize);
+    offset += textSize;
+    return lines;
+  }
+
+private:
+  std::string buffer;
+  std::vector<Token> tokens;
+  size_t offset = 0;
+  TokenStateMachine machine;
+};
+
 } // namespace anka
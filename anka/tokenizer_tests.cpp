@@ -19,29 +19,42 @@ auto checkTokens(const std::string_view text, const std::vector<anka::Token> &ex
 TEST_CASE("test array tokenizing")
 {
   checkTokens("(1 2 3) #dummy comment",
-              {anka::Token{anka::TokenType::ArrayStart, 0, 1}, anka::Token{anka::TokenType::NumberInt, 1, 1},
-               anka::Token{anka::TokenType::NumberInt, 3, 1}, anka::Token{anka::TokenType::NumberInt, 5, 1},
+              {anka::Token{anka::TokenType::ArrayStart, 0, 1}, anka::Token{anka::TokenType::NumberArray, 1, 5},
                anka::Token{anka::TokenType::ArrayEnd, 6, 1}, anka::Token{anka::TokenType::SentenceEnd, 22, 0}});
 
   checkTokens(" (123 2  3444)",
-              {anka::Token{anka::TokenType::ArrayStart, 1, 1}, anka::Token{anka::TokenType::NumberInt, 2, 3},
-               anka::Token{anka::TokenType::NumberInt, 6, 1}, anka::Token{anka::TokenType::NumberInt, 9, 4},
+              {anka::Token{anka::TokenType::ArrayStart, 1, 1}, anka::Token{anka::TokenType::NumberArray, 2, 11},
                anka::Token{anka::TokenType::ArrayEnd, 13, 1}, anka::Token{anka::TokenType::SentenceEnd, 14, 0}});
 
   checkTokens("  (1 2 3) #dummy comment\n  (1 2 3)", {
                                           anka::Token{anka::TokenType::ArrayStart, 2, 1},
-                                          anka::Token{anka::TokenType::NumberInt, 3, 1},
-                                          anka::Token{anka::TokenType::NumberInt, 5, 1},
-                                          anka::Token{anka::TokenType::NumberInt, 7, 1},
+                                          anka::Token{anka::TokenType::NumberArray, 3, 5},
                                           anka::Token{anka::TokenType::ArrayEnd, 8, 1},
                                           anka::Token{anka::TokenType::SentenceEnd, 24, 1},
                                           anka::Token{anka::TokenType::ArrayStart, 27, 1},
-                                          anka::Token{anka::TokenType::NumberInt, 28, 1},
-                                          anka::Token{anka::TokenType::NumberInt, 30, 1},
-                                          anka::Token{anka::TokenType::NumberInt, 32, 1},
+                                          anka::Token{anka::TokenType::NumberArray, 28, 5},
                                           anka::Token{anka::TokenType::ArrayEnd, 33, 1},
                                           anka::Token{anka::TokenType::SentenceEnd, 34, 0},
                                       });
+
+  // only the numbers right after the start of an array are joined
+  checkTokens("(1 -2.5 x 3)",
+              {anka::Token{anka::TokenType::ArrayStart, 0, 1}, anka::Token{anka::TokenType::NumberArray, 1, 6},
+               anka::Token{anka::TokenType::Name, 8, 1}, anka::Token{anka::TokenType::NumberInt, 10, 1},
+               anka::Token{anka::TokenType::ArrayEnd, 11, 1}, anka::Token{anka::TokenType::SentenceEnd, 12, 0}});
+}
+
+TEST_CASE("numbers of number arrays")
+{
+  const auto text = std::string_view{"(10 -2.5\t 3)"};
+  const auto tokens = anka::extractTokens(text);
+  REQUIRE_EQ(tokens[1].type, anka::TokenType::NumberArray);
+
+  std::vector<anka::Token> numbers;
+  anka::forEachArrayNumber(text, tokens[1], [&](const anka::Token &number) { numbers.push_back(number); });
+  CHECK_EQ(numbers, std::vector<anka::Token>{anka::Token{anka::TokenType::NumberInt, 1, 2},
+                                             anka::Token{anka::TokenType::NumberDouble, 4, 4},
+                                             anka::Token{anka::TokenType::NumberInt, 10, 1}});
 }
 
 TEST_CASE("test tuple tokenizing")
@@ -73,13 +86,12 @@ TEST_CASE("test tuple tokenizing")
 
   checkTokens("[1 (1 2 3) [4 (1 2)]]",
               {anka::Token{anka::TokenType::TupleStart, 0, 1}, anka::Token{anka::TokenType::NumberInt, 1, 1},
-               anka::Token{anka::TokenType::ArrayStart, 3, 1}, anka::Token{anka::TokenType::NumberInt, 4, 1},
-               anka::Token{anka::TokenType::NumberInt, 6, 1}, anka::Token{anka::TokenType::NumberInt, 8, 1},
+               anka::Token{anka::TokenType::ArrayStart, 3, 1}, anka::Token{anka::TokenType::NumberArray, 4, 5},
                anka::Token{anka::TokenType::ArrayEnd, 9, 1}, anka::Token{anka::TokenType::TupleStart, 11, 1},
                anka::Token{anka::TokenType::NumberInt, 12, 1}, anka::Token{anka::TokenType::ArrayStart, 14, 1},
-               anka::Token{anka::TokenType::NumberInt, 15, 1}, anka::Token{anka::TokenType::NumberInt, 17, 1},
-               anka::Token{anka::TokenType::ArrayEnd, 18, 1}, anka::Token{anka::TokenType::TupleEnd, 19, 1},
-               anka::Token{anka::TokenType::TupleEnd, 20, 1}, anka::Token{anka::TokenType::SentenceEnd, 21, 0}});
+               anka::Token{anka::TokenType::NumberArray, 15, 3}, anka::Token{anka::TokenType::ArrayEnd, 18, 1},
+               anka::Token{anka::TokenType::TupleEnd, 19, 1}, anka::Token{anka::TokenType::TupleEnd, 20, 1},
+               anka::Token{anka::TokenType::SentenceEnd, 21, 0}});
 }
 
 TEST_CASE("test number tokenizing")
@@ -149,4 +161,54 @@ TEST_CASE("blocks")
                anka::Token{anka::TokenType::NumberInt, 7, 2}, anka::Token{anka::TokenType::SentenceEnd, 9, 0}});
 }
 
+TEST_CASE("chunked input")
+{
+  const auto text = std::string_view{"x: ioata[10]\nsum x # comment\r\n add[1.5 -2] (1 2 3)\ninc2: {inc inc}\ninc2 5"};
+  const auto expected = anka::extractTokens(text);
+
+  for (size_t chunkSize = 1; chunkSize < 8; ++chunkSize)
+  {
+    anka::Tokenizer tokenizer;
+    std::vector<anka::Token> tokens;
+    auto takeLines = [&]() {
+      while (auto linesOpt = tokenizer.takeLines())
+      {
+        CHECK_EQ(linesOpt->text, text.substr(linesOpt->offset, linesOpt->text.size()));
+        for (auto token : linesOpt->tokens)
+        {
+          token.start += linesOpt->offset;
+          tokens.push_back(token);
+        }
+      }
+    };
+
+    for (size_t pos = 0; pos < text.size(); pos += chunkSize)
+    {
+      tokenizer.feed(text.substr(pos, chunkSize));
+      takeLines();
+    }
+    tokenizer.finish();
+    takeLines();
+
+    CHECK_EQ(tokens, expected);
+  }
+}
+
+TEST_CASE("chunked input error position")
+{
+  anka::Tokenizer tokenizer;
+  tokenizer.feed("abc\n1");
+  CHECK(tokenizer.takeLines().has_value());
+  try
+  {
+    tokenizer.feed("2x");
+    FAIL("expected a tokenizer error");
+  }
+  catch (const anka::TokenizerError &err)
+  {
+    CHECK_EQ(err.pos, 6);
+    CHECK_EQ(err.ch, 'x');
+  }
+}
+
 #endif
\ No newline at end of file
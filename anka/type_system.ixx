@@ -7,11 +7,16 @@ module;
 #include <range/v3/range/conversion.hpp>
 #include <range/v3/view.hpp>
 
+#include <cstdint>
 #include <string>
 #include <variant>
 #include <vector>
 export module anka:type_system;
 
+import :bit_array;
+import :dictionary;
+import :nested_array;
+
 namespace anka
 {
 
@@ -32,6 +37,16 @@ export enum class TypeFamily
   BoolArray,
   IntArray,
   DoubleArray,
+  Dictionary,
+  NestedIntArray,
+  NestedDoubleArray,
+  Long,
+  LongArray,
+  FloatArray,
+  Int8Array,
+  Int16Array,
+  UInt8Array,
+  NestedBoolArray,
 };
 
 export struct FunctionType
@@ -57,6 +72,7 @@ export inline auto isExpandable(const TypeVariant &type) -> bool
   case TypeFamily::Bool:
   case TypeFamily::Int:
   case TypeFamily::Double:
+  case TypeFamily::Long:
     return true;
   default:
     return false;
@@ -112,6 +128,26 @@ struct TypeStringConvertor
       return "(int)";
     case TypeFamily::DoubleArray:
       return "(double)";
+    case TypeFamily::Dictionary:
+      return "dict";
+    case TypeFamily::NestedIntArray:
+      return "((int))";
+    case TypeFamily::NestedDoubleArray:
+      return "((double))";
+    case TypeFamily::Long:
+      return "long";
+    case TypeFamily::LongArray:
+      return "(long)";
+    case TypeFamily::FloatArray:
+      return "(float)";
+    case TypeFamily::Int8Array:
+      return "(int8)";
+    case TypeFamily::Int16Array:
+      return "(int16)";
+    case TypeFamily::UInt8Array:
+      return "(uint8)";
+    case TypeFamily::NestedBoolArray:
+      return "((bool))";
     default:
       return "unknown";
     }
@@ -156,8 +192,12 @@ concept IsSameType = std::is_same_v<typename std::remove_cv<typename std::remove
 
 export template <typename T>
 concept IsTypeFamilyCompatible =
-    IsSameType<T, int> || IsSameType<T, double> || IsSameType<T, bool> || IsSameType<T, std::vector<bool>> ||
-    IsSameType<T, std::vector<int>> || IsSameType<T, std::vector<double>>;
+    IsSameType<T, int> || IsSameType<T, double> || IsSameType<T, bool> || IsSameType<T, BitArray> ||
+    IsSameType<T, std::vector<int>> || IsSameType<T, std::vector<double>> || IsSameType<T, Dictionary> ||
+    IsSameType<T, NestedArray<int>> || IsSameType<T, NestedArray<double>> || IsSameType<T, std::int64_t> ||
+    IsSameType<T, std::vector<std::int64_t>> || IsSameType<T, std::vector<float>> ||
+    IsSameType<T, std::vector<std::int8_t>> || IsSameType<T, std::vector<std::int16_t>> ||
+    IsSameType<T, std::vector<std::uint8_t>> || IsSameType<T, NestedArray<bool>>;
 
 template <IsTypeFamilyCompatible T> auto getFamilyType() -> TypeFamily
 {
@@ -169,12 +209,32 @@ template <IsTypeFamilyCompatible T> auto getFamilyType() -> TypeFamily
     return TypeFamily::IntArray;
   else if constexpr (std::is_same_v<Decayed, bool>)
     return TypeFamily::Bool;
-  else if constexpr (std::is_same_v<Decayed, std::vector<bool>>)
+  else if constexpr (std::is_same_v<Decayed, BitArray>)
     return TypeFamily::BoolArray;
   else if constexpr (std::is_same_v<Decayed, double>)
     return TypeFamily::Double;
   else if constexpr (std::is_same_v<Decayed, std::vector<double>>)
     return TypeFamily::DoubleArray;
+  else if constexpr (std::is_same_v<Decayed, Dictionary>)
+    return TypeFamily::Dictionary;
+  else if constexpr (std::is_same_v<Decayed, NestedArray<int>>)
+    return TypeFamily::NestedIntArray;
+  else if constexpr (std::is_same_v<Decayed, NestedArray<double>>)
+    return TypeFamily::NestedDoubleArray;
+  else if constexpr (std::is_same_v<Decayed, NestedArray<bool>>)
+    return TypeFamily::NestedBoolArray;
+  else if constexpr (std::is_same_v<Decayed, std::int64_t>)
+    return TypeFamily::Long;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int64_t>>)
+    return TypeFamily::LongArray;
+  else if constexpr (std::is_same_v<Decayed, std::vector<float>>)
+    return TypeFamily::FloatArray;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int8_t>>)
+    return TypeFamily::Int8Array;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::int16_t>>)
+    return TypeFamily::Int16Array;
+  else if constexpr (std::is_same_v<Decayed, std::vector<std::uint8_t>>)
+    return TypeFamily::UInt8Array;
   else
     []<bool flag = false>()
     {